@@ -1,57 +1,261 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
-// класс, который будет считывать ONNX файл и разбирать его
-class BinaryReader
+#include "parse_profile.h"
+#include "span.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BIN_READER_HAS_MMAP 1
+#endif
+
+// режим загрузки файла в BinaryReader
+enum class ReadMode
+{
+    COPY,   // весь файл копируется в std::vector
+    MMAP    // файл отображается в память, страницы подгружаются по мере чтения
+};
+
+// байты файла в памяти: отображение (mmap) или копия в std::vector.
+// Ридер и лениво загруженные тензоры держат буфер через shared_ptr,
+// поэтому данные живут, пока на них есть ссылки, даже после разбора.
+class FileBuffer
 {
 private:
-    std::vector<uint8_t> byte_vector;
-    size_t cur_index;
+    std::vector<uint8_t> byte_vector; // буфер для режима COPY (и для пайпов)
+    const uint8_t* bytes;             // начало данных: byte_vector.data() или mmap
+    void* mapped;                     // отображённая область, nullptr если mmap не используется
     size_t size;
 
-public:
-    // конструктор
-    BinaryReader(const std::string& file_name) 
-        : cur_index(0), size(0)  
+    // чтение потока до конца, когда размер заранее неизвестен (пайп, /dev/stdin)
+    void read_stream(std::istream& stream)
+    {
+        char chunk[1 << 16];
+        while (stream.read(chunk, sizeof(chunk)) || stream.gcount() > 0)
+        {
+            byte_vector.insert(byte_vector.end(), chunk, chunk + stream.gcount());
+        }
+    }
+
+    // загрузка копированием через std::ifstream
+    void load_copy(const std::string& file_name)
     {
         std::ifstream onnxFile(file_name, std::ios::binary);
-        if (!onnxFile) 
+        if (!onnxFile)
         {
             throw std::runtime_error("Ошибка открытия файла .onnx");
         }
 
         // вычисляем размер данных
         onnxFile.seekg(0, std::ios::end);
-        size = onnxFile.tellg();
-        onnxFile.seekg(0, std::ios::beg);  
+        std::streamoff file_size = onnxFile.tellg();
+
+        if (file_size < 0)
+        {
+            // поток без произвольного доступа — читаем как есть
+            onnxFile.clear();
+            read_stream(onnxFile);
+        }
+        else
+        {
+            onnxFile.seekg(0, std::ios::beg);
 
-        // Создаём буфер нужного размера
-        byte_vector.resize(size);
+            // Создаём буфер нужного размера
+            byte_vector.resize(static_cast<size_t>(file_size));
+
+            // Читаем все байты файла
+            if (!onnxFile.read(reinterpret_cast<char*>(byte_vector.data()), file_size))
+            {
+                throw std::runtime_error("Ошибка чтения файла");
+            }
+        }
+
+        bytes = byte_vector.data();
+        size = byte_vector.size();
+    }
+
+#ifdef BIN_READER_HAS_MMAP
+    // загрузка через mmap, возвращает false, если файл нельзя отобразить (пайп и т.п.)
+    bool load_mmap(const std::string& file_name)
+    {
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Ошибка открытия файла .onnx");
+        }
 
-        // Читаем все байты файла
-        if (!onnxFile.read(reinterpret_cast<char*>(byte_vector.data()), size)) 
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
         {
-            throw std::runtime_error("Ошибка чтения файла");
+            ::close(fd);
+            return false;
         }
+
+        size_t file_size = static_cast<size_t>(st.st_size);
+        void* region = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // отображение остаётся валидным и после закрытия дескриптора
+
+        if (region == MAP_FAILED) return false;
+
+        mapped = region;
+        bytes = static_cast<const uint8_t*>(region);
+        size = file_size;
+        return true;
+    }
+#endif
+
+public:
+    // конструктор: по умолчанию файл отображается в память,
+    // для пайпов и специальных файлов — обычное чтение в буфер
+    FileBuffer(const std::string& file_name, ReadMode mode = ReadMode::MMAP)
+        : bytes(nullptr), mapped(nullptr), size(0)
+    {
+        PARSE_PROFILE_SCOPE(ParsePhase::LOAD, 0);
+#ifdef BIN_READER_HAS_MMAP
+        if (mode != ReadMode::MMAP || !load_mmap(file_name)) load_copy(file_name);
+#else
+        (void)mode;
+        load_copy(file_name);
+#endif
+        PARSE_PROFILE_BYTES(size);
+    }
+
+    ~FileBuffer()
+    {
+#ifdef BIN_READER_HAS_MMAP
+        if (mapped) ::munmap(mapped, size);
+#endif
+    }
+
+    // отображение нельзя копировать
+    FileBuffer(const FileBuffer&) = delete;
+    FileBuffer& operator=(const FileBuffer&) = delete;
+
+    // геттеры
+    const uint8_t* data() const { return bytes; }
+    size_t get_size() const { return size; }
+    bool is_mapped() const { return mapped != nullptr; }
+
+    // участок буфера без копирования
+    ByteView view(size_t offset, size_t length) const
+    {
+        if (offset > size || length > size - offset) throw std::out_of_range("Unexpected EOF");
+        return ByteView(bytes + offset, length);
     }
+};
+
+// файлы внешних данных модели (TensorProto.external_data): модели больше 2 ГБ хранят
+// веса рядом, в отдельных файлах. Каждый файл отображается в память один раз и
+// разделяется всеми тензорами, которые на него ссылаются
+class ExternalDataFiles
+{
+private:
+    std::string base_dir; // каталог модели: location задаётся относительно него
+    ReadMode mode;
+
+    std::mutex mutex; // файлы открывают потоки многопоточного разбора
+    std::unordered_map<std::string, std::shared_ptr<const FileBuffer>> files;
 
-    // функция для просмотра текущего байта 
+public:
+    ExternalDataFiles(const std::string& model_path, ReadMode read_mode) : mode(read_mode)
+    {
+        size_t slash = model_path.find_last_of('/');
+        if (slash != std::string::npos) base_dir = model_path.substr(0, slash + 1);
+    }
+
+    // буфер файла location, открывается при первом обращении; nullptr, если файла нет
+    // (модель без весов по-прежнему разбирается: граф, формы, план памяти).
+    // Как и в ONNX, путь только относительный и не выходит из каталога модели
+    std::shared_ptr<const FileBuffer> open(const std::string& location)
+    {
+        if (location.empty() || location[0] == '/' || location == ".." || location.compare(0, 3, "../") == 0
+            || location.find("/../") != std::string::npos
+            || (location.size() >= 3 && location.compare(location.size() - 3, 3, "/..") == 0))
+        {
+            throw std::runtime_error("Недопустимый путь к внешним данным: " + location);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto [it, inserted] = files.try_emplace(location);
+        if (inserted)
+        {
+            try
+            {
+                it->second = std::make_shared<const FileBuffer>(base_dir + location, mode);
+            }
+            catch (const std::runtime_error&)
+            {
+                // файл недоступен: запоминаем, чтобы не открывать снова для каждого тензора
+            }
+        }
+        return it->second;
+    }
+
+    // число отображённых файлов
+    size_t mapped_count()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t count = 0;
+        for (const auto& [location, file] : files) count += file != nullptr;
+        return count;
+    }
+
+    // файлы, на которые ссылается модель, но которых нет рядом с ней
+    std::vector<std::string> missing()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> result;
+        for (const auto& [location, file] : files)
+        {
+            if (!file) result.push_back(location);
+        }
+        return result;
+    }
+};
+
+// класс, который будет считывать ONNX файл и разбирать его
+class BinaryReader
+{
+private:
+    std::shared_ptr<const FileBuffer> buffer; // владелец байтов файла
+    const uint8_t* bytes;                     // buffer->data(), кешируется для горячих путей
+    size_t cur_index;
+    size_t size;
+
+public:
+    // конструктор: по умолчанию файл отображается в память,
+    // для пайпов и специальных файлов — обычное чтение в буфер
+    BinaryReader(const std::string& file_name, ReadMode mode = ReadMode::MMAP)
+        : buffer(std::make_shared<const FileBuffer>(file_name, mode)),
+          bytes(buffer->data()), cur_index(0), size(buffer->get_size()) {}
+
+    // функция для просмотра текущего байта
     uint8_t watch_cur_byte()
     {
         if (cur_index >= size) return 0;
-        return byte_vector[cur_index];
+        return bytes[cur_index];
     }
 
     // прочитать байт и сдвинуться
     uint8_t read_byte()
     {
         if (cur_index >= size) throw std::out_of_range("Unexpected EOF");
-        uint8_t cur_byte = byte_vector[cur_index];
+        uint8_t cur_byte = bytes[cur_index];
         cur_index++;
         return cur_byte;
     }
@@ -59,13 +263,85 @@ public:
 
     // прочитать varint
     uint64_t read_varint()
+    {
+        PARSE_PROFILE_READ(ParsePhase::VARINT, cur_index);
+
+        // однобайтовые (теги, короткие длины) — самые частые
+        if (cur_index < size && bytes[cur_index] < 0x80) return bytes[cur_index++];
+
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // до конца буфера не меньше максимальной длины varint: 8 байт читаются разом,
+        // без проверки границ на каждый байт
+        if (size - cur_index >= 10) return read_varint_fast();
+#endif
+        return read_varint_slow();
+    }
+
+private:
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // 7-битные группы 8 байтов подряд (биты продолжения уже сброшены) → 56 бит значения
+    static uint64_t compact_varint_groups(uint64_t word)
+    {
+        word = ((word & 0x7F007F007F007F00ULL) >> 1) | (word & 0x007F007F007F007FULL);
+        word = ((word & 0x3FFF00003FFF0000ULL) >> 2) | (word & 0x00003FFF00003FFFULL);
+        word = ((word & 0x0FFFFFFF00000000ULL) >> 4) | (word & 0x000000000FFFFFFFULL);
+        return word;
+    }
+
+    // быстрый путь: в буфере ≥ 10 байтов. Последний байт varint — первый со сброшенным
+    // старшим битом, его находит count-trailing-zeros по маске битов продолжения
+    uint64_t read_varint_fast()
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + cur_index, sizeof(word));
+
+        uint64_t stops = ~word & 0x8080808080808080ULL;
+        if (stops != 0)
+        {
+            int bits = __builtin_ctzll(stops) + 1;   // биты байтов varint, включая последний
+            uint64_t used = bits == 64 ? word : word & ((uint64_t(1) << bits) - 1);
+            cur_index += static_cast<size_t>(bits / 8);
+            return compact_varint_groups(used & 0x7F7F7F7F7F7F7F7FULL);
+        }
+
+        // 9 или 10 байтов (отрицательные int64): первые 8 дают 56 бит
+        uint64_t result = compact_varint_groups(word & 0x7F7F7F7F7F7F7F7FULL);
+        uint8_t ninth = bytes[cur_index + 8];
+        result |= static_cast<uint64_t>(ninth & 0x7F) << 56;
+        if ((ninth & 0x80) == 0)
+        {
+            cur_index += 9;
+            return result;
+        }
+
+        uint8_t tenth = bytes[cur_index + 9];
+        if (tenth & 0x80)
+        {
+            cur_index += 10;
+            throw std::runtime_error("Varint too long");
+        }
+        result |= static_cast<uint64_t>(tenth) << 63;
+        cur_index += 10;
+        return result;
+    }
+#endif
+
+    // один varint упакованного поля, которое заканчивается на end
+    void read_packed_element(size_t end, std::vector<int64_t>& values)
+    {
+        values.push_back(static_cast<int64_t>(read_varint()));
+        if (cur_index > end) throw std::runtime_error("Packed varint crosses field boundary");
+    }
+
+    // побайтовое чтение с проверкой границ — у конца буфера
+    uint64_t read_varint_slow()
     {
         uint64_t result = 0;
         int shift = 0;
-    
+
         while (cur_index < size)
         {
-            uint8_t byte = byte_vector[cur_index++];
+            uint8_t byte = bytes[cur_index++];
             result |= static_cast<uint64_t>(byte & 0x7F) << shift;
             if ((byte & 0x80) == 0) return result;
 
@@ -77,17 +353,89 @@ public:
         throw std::runtime_error("Unexpected EOF while reading varint");
     }
 
+public:
+    // упакованное повторяющееся поле (packed repeated int64/int32/uint64) длиной length
+    // байтов: значения дописываются в values. Слова из 8 однобайтовых varint (малые
+    // числа: pads, kernel_shape, размерности) разбираются целиком, без цикла по varint
+    void read_packed_varints(size_t length, std::vector<int64_t>& values)
+    {
+        if (length > size - cur_index) throw std::out_of_range("Unexpected EOF");
+        const size_t end = cur_index + length;
+
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        while (end - cur_index >= 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + cur_index, sizeof(word));
+            if (word & 0x8080808080808080ULL)
+            {
+                read_packed_element(end, values);
+                continue;
+            }
+
+            size_t first = values.size();
+            values.resize(first + 8);
+            for (size_t i = 0; i < 8; i++) values[first + i] = static_cast<int64_t>((word >> (8 * i)) & 0xFF);
+            cur_index += 8;
+        }
+#endif
+        while (cur_index < end) read_packed_element(end, values);
+    }
+
+    // упакованное поле fixed32 (packed float) — одним копированием
+    void read_packed_floats(size_t length, std::vector<float>& values)
+    {
+        PARSE_PROFILE_READ(ParsePhase::BYTES, cur_index);
+        if (length > size - cur_index) throw std::out_of_range("Unexpected EOF");
+        if (length % sizeof(float) != 0) throw std::runtime_error("Packed float field length is not a multiple of 4");
+        size_t count = length / sizeof(float);
+        size_t first = values.size();
+        values.resize(first + count);
+        std::memcpy(values.data() + first, bytes + cur_index, count * sizeof(float));
+        cur_index += length;
+    }
 
-    // функция считывания n байтов подряд 
-    std::vector<uint8_t> read_bytes(size_t n)  
+    // функция считывания n байтов подряд
+    std::vector<uint8_t> read_bytes(size_t n)
     {
-        if (cur_index + n > size) throw std::out_of_range("Unexpected EOF");
-        std::vector<uint8_t> data(byte_vector.begin() + cur_index, 
-                              byte_vector.begin() + cur_index + n);
+        PARSE_PROFILE_READ(ParsePhase::BYTES, cur_index);
+        if (n > size - cur_index) throw std::out_of_range("Unexpected EOF");
+        std::vector<uint8_t> data(bytes + cur_index, bytes + cur_index + n);
         cur_index += n;
         return data;
     }
 
+    // n байтов подряд без копирования: указатель в буфер ридера
+    // (view валиден, пока жив ридер)
+    ByteView read_view(size_t n)
+    {
+        PARSE_PROFILE_READ(ParsePhase::BYTES, cur_index);
+        if (n > size - cur_index) throw std::out_of_range("Unexpected EOF");
+        ByteView view(bytes + cur_index, n);
+        cur_index += n;
+        return view;
+    }
+
+    // строка длины n без копирования
+    std::string_view read_string_view(size_t n)
+    {
+        return as_string_view(read_view(n));
+    }
+
+    // пропустить n байтов, только сдвигает курсор
+    void skip(size_t n)
+    {
+        if (n > size - cur_index) throw std::out_of_range("Unexpected EOF");
+        cur_index += n;
+    }
+
+    // перейти к позиции pos (копия ридера над тем же буфером может читать с любого места)
+    void seek(size_t pos)
+    {
+        if (pos > size) throw std::out_of_range("Unexpected EOF");
+        cur_index = pos;
+    }
+
     // функция для проверки выхода за границу массива битов
     bool check_eof()
     {
@@ -107,4 +455,180 @@ public:
     {
         return cur_index;
     }
-};
\ No newline at end of file
+
+    // работает ли ридер поверх отображённого файла
+    bool is_mapped() const
+    {
+        return buffer->is_mapped();
+    }
+
+    // буфер файла — для ленивых ссылок на данные (см. Tensor)
+    const std::shared_ptr<const FileBuffer>& get_buffer() const
+    {
+        return buffer;
+    }
+};
+
+// последовательное чтение из std::istream или файлового дескриптора через окно
+// фиксированного размера: память не зависит от размера файла (потоковый разбор,
+// пайпы, модели больше памяти). Пропуски — seek, если источник его поддерживает
+class StreamReader
+{
+private:
+    std::istream* stream = nullptr; // источник: поток или дескриптор
+    int fd = -1;
+
+    std::vector<uint8_t> window;
+    size_t begin = 0;       // непрочитанные байты — window[begin, end)
+    size_t end = 0;
+    uint64_t position = 0;  // позиция в источнике байта window[begin]
+    bool exhausted = false; // источник больше ничего не отдаст
+
+    // дочитать источник в окно (непрочитанный хвост переносится в начало); false — данных нет
+    bool refill()
+    {
+        if (exhausted) return false;
+
+        if (begin > 0)
+        {
+            std::memmove(window.data(), window.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+
+        size_t got = read_source(window.data() + end, window.size() - end);
+        if (got == 0) exhausted = true;
+        end += got;
+        return got > 0;
+    }
+
+    size_t read_source(uint8_t* destination, size_t count)
+    {
+        if (count == 0) return 0;
+        if (stream)
+        {
+            stream->read(reinterpret_cast<char*>(destination), static_cast<std::streamsize>(count));
+            return static_cast<size_t>(stream->gcount());
+        }
+#ifdef BIN_READER_HAS_MMAP
+        ssize_t got = ::read(fd, destination, count);
+        if (got < 0) throw std::runtime_error("Ошибка чтения файла");
+        return static_cast<size_t>(got);
+#else
+        return 0;
+#endif
+    }
+
+    // пропустить count байтов источника (окно уже пусто): seek или чтение впустую
+    void skip_source(uint64_t count)
+    {
+        if (stream)
+        {
+            std::streampos here = stream->tellg();
+            if (here != std::streampos(-1))
+            {
+                stream->seekg(0, std::ios::end);
+                std::streamoff left = stream->tellg() - here;
+                if (left < 0 || static_cast<uint64_t>(left) < count) throw std::out_of_range("Unexpected EOF");
+                stream->seekg(here + static_cast<std::streamoff>(count));
+                return;
+            }
+            stream->clear();
+        }
+#ifdef BIN_READER_HAS_MMAP
+        else
+        {
+            struct stat st;
+            off_t here = ::lseek(fd, 0, SEEK_CUR);
+            if (here >= 0 && ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+            {
+                if (static_cast<uint64_t>(st.st_size - here) < count) throw std::out_of_range("Unexpected EOF");
+                ::lseek(fd, static_cast<off_t>(count), SEEK_CUR);
+                return;
+            }
+        }
+#endif
+        // пайп: читаем и выбрасываем
+        while (count > 0)
+        {
+            size_t got = read_source(window.data(), static_cast<size_t>(std::min<uint64_t>(count, window.size())));
+            if (got == 0) throw std::out_of_range("Unexpected EOF");
+            count -= got;
+        }
+    }
+
+public:
+    // чтение из потока (файл, std::cin)
+    explicit StreamReader(std::istream& input, size_t window_size = 1 << 16)
+        : stream(&input), window(std::max<size_t>(window_size, 16)) {}
+
+    // чтение из открытого дескриптора (не закрывается ридером)
+    explicit StreamReader(int file_descriptor, size_t window_size = 1 << 16)
+        : fd(file_descriptor), window(std::max<size_t>(window_size, 16)) {}
+
+    // позиция следующего байта от начала источника
+    uint64_t get_cur_pos() const { return position; }
+
+    // источник прочитан до конца
+    bool check_eof()
+    {
+        return begin == end && !refill();
+    }
+
+    uint8_t read_byte()
+    {
+        if (begin == end && !refill()) throw std::out_of_range("Unexpected EOF");
+        position++;
+        return window[begin++];
+    }
+
+    uint64_t read_varint()
+    {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = read_byte();
+            result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return result;
+        }
+        throw std::runtime_error("Слишком длинный varint");
+    }
+
+    // n байтов подряд в destination
+    void read_into(void* destination, size_t n)
+    {
+        uint8_t* out = static_cast<uint8_t*>(destination);
+        while (n > 0)
+        {
+            if (begin == end && !refill()) throw std::out_of_range("Unexpected EOF");
+            size_t chunk = std::min(n, end - begin);
+            std::memcpy(out, window.data() + begin, chunk);
+            begin += chunk;
+            position += chunk;
+            out += chunk;
+            n -= chunk;
+        }
+    }
+
+    // дописать n байтов в строку (строка переиспользуется вызывающим — без новых выделений)
+    void read_append(size_t n, std::string& out)
+    {
+        size_t old_size = out.size();
+        out.resize(old_size + n);
+        read_into(out.data() + old_size, n);
+    }
+
+    // пропустить n байтов: сначала из окна, остальное — в источнике
+    void skip(uint64_t n)
+    {
+        size_t buffered = static_cast<size_t>(std::min<uint64_t>(n, end - begin));
+        begin += buffered;
+        position += buffered;
+        n -= buffered;
+        if (n == 0) return;
+
+        begin = end = 0;
+        skip_source(n);
+        position += n;
+    }
+};
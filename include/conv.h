@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "gemm.h"
+#include "ops.h"
+
+// способ вычисления 2D-свёртки
+enum class ConvAlgorithm
+{
+    DIRECT,     // прямой вложенный цикл — эталон
+    IM2COL,     // развёртка окон в матрицу + sgemm (общий случай)
+    WINOGRAD,   // Winograd F(2x2, 3x3): 3x3, stride 1, dilation 1, group 1
+    DEPTHWISE   // один входной канал на группу (group == C)
+};
+
+// применим ли алгоритм к свёртке с такой геометрией
+bool conv_algorithm_supported(ConvAlgorithm algorithm, const ConvGeometry& g);
+
+// автоматический выбор по атрибутам Conv (kernel_shape, strides, dilations, group)
+ConvAlgorithm choose_conv_algorithm(const ConvGeometry& g);
+
+// имя алгоритма для вывода: "direct", "im2col", "winograd", "depthwise"
+const char* conv_algorithm_name(ConvAlgorithm algorithm);
+
+// может ли Conv с весом формы w_shape выбрать Winograd хоть при каком-то входе:
+// только для таких весов исполнитель заранее считает winograd_kernels
+bool conv_may_use_winograd(const Node& node, const std::vector<int64_t>& w_shape);
+
+// ядра W[M, C, 3, 3] в пространстве Winograd (U = G g G^T), раскладка [16][M][C].
+// Веса не меняются между запусками: исполнитель считает U один раз на вес
+std::vector<float> winograd_kernels(const float* w, int64_t filters, int64_t channels);
+
+// Y[N, M, OH, OW] = Conv(X[N, C, H, W], W[M, C / group, KH, KW]) + bias[M];
+// bias может быть nullptr. winograd_u — готовые ядра из winograd_kernels (только для
+// WINOGRAD; nullptr — преобразовать W при вызове). epilogue (может быть nullptr) применяется
+// к готовым участкам Y: im2col — к плиткам sgemm, остальные — к плоскости каждого выходного
+// канала сразу после неё. Бросает runtime_error, если алгоритм неприменим.
+void conv2d(ConvAlgorithm algorithm, const ConvGeometry& g, const float* x, const float* w,
+            const float* bias, float* y, const float* winograd_u = nullptr,
+            const GemmEpilogue* epilogue = nullptr);
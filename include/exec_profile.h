@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+#include "executor.h"
+
+// профиль выполнения графа: время каждого узла и его цена — операции с плавающей
+// точкой и байты, — по которым видно, упирается узел в вычисления или в память
+// (модель roofline: узел с арифметической интенсивностью FLOP/байт ниже
+// отношения пиков машины ограничен памятью)
+
+// цена одного выполнения узла по атрибутам и фактическим формам
+struct NodeCost
+{
+    double flops = 0.0;   // умножения и сложения по отдельности (FMA — 2)
+    double bytes = 0.0;   // входы читаются и выходы пишутся по одному разу
+};
+
+// Conv: 2 · N · OC · OH · OW · (IC / group) · KH · KW (ядро из kernel_shape или W);
+// Gemm: 2 · M · N · K; MatMul: 2 · K на каждый элемент выхода; поэлементные и
+// слитые эпилоги — по операции на элемент; Reshape, Shape, Concat — только байты
+NodeCost node_cost(const Node& node, const std::vector<const Value*>& inputs, const std::vector<Value>& outputs);
+
+// пиковые скорости машины на threads потоках (столько же, сколько у исполнителя): sgemm
+// в каждом потоке и копирование буфера больше кэша. Узел, данные которого лежат в кэше,
+// может превысить такой пик памяти (roof > 100%)
+struct MachinePeaks
+{
+    double gflops = 0.0;
+    double gbytes_per_second = 0.0;
+};
+
+// замер пиков (около 0.1 с)
+MachinePeaks measure_machine_peaks(size_t threads = 1);
+
+// замеры одного узла, накопленные за все профилируемые вызовы run()
+struct NodeTiming
+{
+    double seconds = 0.0;
+    NodeCost cost;
+    size_t runs = 0;
+};
+
+class ExecutionProfile
+{
+private:
+    std::vector<NodeTiming> nodes;   // NodeId → замеры
+
+public:
+    // обнулить замеры графа из node_count узлов
+    void reset(size_t node_count) { nodes.assign(node_count, NodeTiming()); }
+
+    // выполнение узла; узлы разных потоков пишут в разные ячейки
+    void record(NodeId node, double seconds, const NodeCost& cost)
+    {
+        NodeTiming& timing = nodes[node];
+        timing.seconds += seconds;
+        timing.cost.flops += cost.flops;
+        timing.cost.bytes += cost.bytes;
+        timing.runs++;
+    }
+
+    const std::vector<NodeTiming>& get_nodes() const { return nodes; }
+
+    // таблицы: узлы в порядке выполнения, типы операций, top_n самых медленных узлов.
+    // Достигнутые GFLOP/s и GB/s сравниваются с пиками: интенсивность ниже
+    // peaks.gflops / peaks.gbytes_per_second — узел ограничен памятью
+    void print(const Graph& graph, std::ostream& out, size_t top_n, const MachinePeaks& peaks) const;
+};
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_plan.h"
+#include "parser.h"
+#include "thread_pool.h"
+
+// число элементов тензора заданной формы
+size_t shape_size(const std::vector<int64_t>& shape);
+
+// тензор во время выполнения: форма и данные FLOAT или INT64
+// (INT64 нужен для тензоров-форм: Shape, Concat, Reshape).
+// FLOAT-данные могут лежать в арене исполнителя (см. memory_plan.h): тогда Value
+// ими не владеет, а копия Value получает собственные данные
+class Value
+{
+    std::vector<int64_t> shape;
+    int32_t data_type = FLOAT;
+    std::vector<float> floats;   // данные FLOAT
+    std::vector<int64_t> ints;   // данные INT64
+    float* arena = nullptr;      // данные FLOAT в арене (вместо floats)
+    size_t arena_capacity = 0;   // размер места в арене, элементов
+    size_t arena_count = 0;      // занято элементов
+    bool read_only = false;      // arena — чужая память только для чтения (см. const_view)
+    std::shared_ptr<const std::vector<float>> winograd;   // ядра Winograd веса Conv (см. conv.h)
+
+public:
+    Value() = default;
+    Value(Value&&) = default;
+    Value& operator=(Value&&) = default;
+
+    Value(const Value& other)
+        : shape(other.shape), data_type(other.data_type), ints(other.ints), winograd(other.winograd)
+    {
+        if (other.arena) floats.assign(other.arena, other.arena + other.arena_count);
+        else floats = other.floats;
+    }
+
+    Value& operator=(const Value& other)
+    {
+        Value copy(other);
+        return *this = std::move(copy);
+    }
+
+    // float-тензор с данными
+    Value(std::vector<int64_t> value_shape, std::vector<float> data)
+        : shape(std::move(value_shape)), floats(std::move(data))
+    {
+        if (floats.size() != shape_size(shape))
+        {
+            throw std::runtime_error("Размер данных не совпадает с формой тензора");
+        }
+    }
+
+    // float-тензор, заполненный нулями
+    static Value zeros(std::vector<int64_t> value_shape)
+    {
+        size_t count = shape_size(value_shape);
+        return Value(std::move(value_shape), std::vector<float>(count, 0.0f));
+    }
+
+    // int64-тензор
+    static Value of_ints(std::vector<int64_t> value_shape, std::vector<int64_t> data)
+    {
+        if (data.size() != shape_size(value_shape))
+        {
+            throw std::runtime_error("Размер данных не совпадает с формой тензора");
+        }
+
+        Value value;
+        value.shape = std::move(value_shape);
+        value.data_type = INT64;
+        value.ints = std::move(data);
+        return value;
+    }
+
+    // место под выход ядра в арене: форма задаётся позже, в bind_output
+    static Value arena_slot(float* memory, size_t capacity)
+    {
+        Value value;
+        value.arena = memory;
+        value.arena_capacity = capacity;
+        return value;
+    }
+
+    // float-тензор над чужой памятью (не обнуляется и не копируется); память должна
+    // пережить Value и его перемещения — копия Value получает собственные данные
+    static Value view(float* memory, std::vector<int64_t> value_shape)
+    {
+        Value value;
+        value.arena_count = shape_size(value_shape);
+        value.arena_capacity = value.arena_count;
+        value.arena = memory;
+        value.shape = std::move(value_shape);
+        return value;
+    }
+
+    // float-тензор над чужой памятью только для чтения (веса в mmap модели с PROT_READ):
+    // изменяемый data() бросает исключение вместо записи в неё, а bind_output
+    // выделяет собственную память
+    static Value const_view(const float* memory, std::vector<int64_t> value_shape)
+    {
+        Value value = view(const_cast<float*>(memory), std::move(value_shape));
+        value.read_only = true;
+        return value;
+    }
+
+    // обнулённый float-тензор формы value_shape: в арене, если места хватает
+    // (выход ядра без malloc), иначе в собственной памяти
+    void bind_output(std::vector<int64_t> value_shape)
+    {
+        size_t count = shape_size(value_shape);
+        if (arena == nullptr || read_only || count > arena_capacity || data_type != FLOAT)
+        {
+            *this = zeros(std::move(value_shape));
+            return;
+        }
+
+        shape = std::move(value_shape);
+        arena_count = count;
+        std::fill(arena, arena + count, 0.0f);
+    }
+
+    // значение инициализатора (копия данных FLOAT/INT64/INT32 из Tensor)
+    static Value from_tensor(const Tensor& tensor);
+
+    // обратно в инициализатор (FLOAT или INT64, данные в raw_data)
+    Tensor to_tensor(std::string name) const;
+
+    // геттеры
+    const std::vector<int64_t>& get_shape() const { return shape; }
+    int32_t get_data_type() const { return data_type; }
+    size_t element_count() const
+    {
+        if (data_type == INT64) return ints.size();
+        return arena ? arena_count : floats.size();
+    }
+
+    float* data()
+    {
+        if (read_only) throw std::runtime_error("Запись в тензор только для чтения (данные файла модели)");
+        return arena ? arena : floats.data();
+    }
+    const float* data() const { return arena ? arena : floats.data(); }
+
+    const std::vector<int64_t>& int_data() const { return ints; }
+
+    // ядра веса Conv в пространстве Winograd (winograd_kernels из conv.h), посчитанные
+    // исполнителем один раз; nullptr — нет. Общие у копий Value
+    const float* winograd_data() const { return winograd ? winograd->data() : nullptr; }
+    void set_winograd_data(std::vector<float> kernels)
+    {
+        winograd = std::make_shared<const std::vector<float>>(std::move(kernels));
+    }
+    void share_winograd_data(const Value& other) { winograd = other.winograd; }
+
+    // та же память, другая форма (число элементов должно совпадать)
+    void reshape(std::vector<int64_t> new_shape)
+    {
+        if (shape_size(new_shape) != element_count())
+        {
+            throw std::runtime_error("Reshape: число элементов не совпадает");
+        }
+        shape = std::move(new_shape);
+    }
+};
+
+class ExecutionProfile;
+
+// ядро операции: входы (nullptr для пропущенных необязательных) → выходы
+using OpKernel = void (*)(const Node& node, const std::vector<const Value*>& inputs,
+                          std::vector<Value>& outputs);
+
+// выполнение графа на CPU (float32) эталонными ядрами из ops.h
+class Executor
+{
+private:
+    const Graph& graph;
+    std::vector<Value> weights;       // TensorId → значение инициализатора
+    std::vector<bool> has_weight;     // есть ли инициализатор с таким id
+    std::vector<OpKernel> kernels;    // NodeId → ядро
+
+    // арена промежуточных тензоров (пусто — каждый выход в своей памяти)
+    mutable std::vector<float> arena;
+    std::vector<size_t> arena_offsets;   // TensorId → смещение в арене, элементов (SIZE_MAX — вне арены)
+    std::vector<size_t> arena_sizes;     // TensorId → место в арене, элементов
+
+    std::unique_ptr<ThreadPool> pool;         // параллельное выполнение (nullptr — последовательное)
+    std::unique_ptr<float[]> weight_memory;   // float-веса после первого касания потоками пула
+    std::vector<uint32_t> dependency_counts;  // NodeId → число узлов-предшественников
+    ExecutionProfile* profile = nullptr;      // замеры узлов (nullptr — без профиля)
+
+    // значения тензоров одного вызова run()
+    struct RunState
+    {
+        std::vector<const Value*> slots;  // TensorId → значение: вес, вход или результат узла
+        std::vector<Value> activations;   // TensorId → результат узла
+        float* arena_base = nullptr;      // выровненное начало арены (nullptr — без плана)
+    };
+
+    // перенос float-весов в память, первое касание которой делят потоки пула
+    void first_touch_weights();
+
+    // одно ядро и его эпилоги; node_inputs/node_outputs — переиспользуемые буферы
+    void run_node(NodeId i, RunState& state, std::vector<const Value*>& node_inputs,
+                  std::vector<Value>& node_outputs) const;
+
+    // узлы запускаются по готовности: счётчик предшественников каждого узла уменьшается
+    // атомарно, обнуливший его поток выполняет узел сам или ставит в свою очередь пула
+    void run_parallel(RunState& state) const;
+
+public:
+    // готовит веса и ядра; бросает runtime_error для неподдерживаемых операций
+    explicit Executor(const Graph& graph);
+
+    // выходы узлов пишутся в одну заранее выделенную арену по плану (см. memory_plan.h):
+    // в цикле выполнения память под активации не выделяется. Тензор, не поместившийся
+    // в своё место (формы входов больше плановых), получает собственную память.
+    // С планом run() не реентерабелен: арена общая для всех вызовов
+    void use_memory_plan(const MemoryPlan& plan);
+
+    // число потоков; 1 — последовательно. Независимые узлы (ветви перед Concat и т.п.)
+    // выполняются одновременно, а большие Conv/Gemm/MatMul/поэлементные ядра делятся
+    // на части между потоками (parallel_for). Параллельный запуск не использует арену:
+    // план памяти рассчитан на один поток.
+    // pin_threads — закрепить потоки за ядрами по узлам NUMA; float-веса при этом
+    // переносятся в новую память, которую по частям первыми касаются потоки пула: страницы
+    // весов распределяются по узлам потоков, а не лежат все на узле загрузившего модель.
+    // С разбиением ядер части весов не согласованы: поток может читать и чужой узел
+    void set_threads(size_t threads, bool pin_threads = false);
+
+    // профиль следующих вызовов run(): время, FLOP и байты каждого узла (см. exec_profile.h).
+    // Профиль обнуляется здесь и должен пережить эти вызовы; nullptr — выключить
+    void set_profile(ExecutionProfile* execution_profile);
+
+    // запуск: значения входов по имени → выходы графа по имени
+    // (если выходы графа не разобраны — тензоры, которые никто не читает)
+    std::unordered_map<std::string, Value> run(const std::unordered_map<std::string, Value>& inputs) const;
+};
+
+// свёртка констант: узлы, все входы которых — инициализаторы, вычисляются заранее
+// и заменяются инициализаторами; Shape сворачивается и по известной форме входа
+// графа (input_shapes: имя входа → форма, например из --input).
+// Входы свёрнутых узлов, которые больше никто не читает, удаляются из графа.
+// Возвращает число свёрнутых узлов.
+size_t fold_constants(Graph& graph, const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes = {});
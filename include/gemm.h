@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+// набор SIMD-инструкций, которым считает sgemm
+enum class GemmBackend
+{
+    SCALAR,   // переносимый C++ (без intrinsics)
+    AVX2,     // AVX2 + FMA, микроядро 6x16
+    AVX512    // AVX-512F, микроядро 6x32
+};
+
+// лучший бэкенд для текущего процессора (определяется один раз при первом вызове)
+GemmBackend gemm_backend();
+
+// поддерживает ли процессор (и сборка) данный бэкенд
+bool gemm_backend_available(GemmBackend backend);
+
+// имя бэкенда для вывода: "scalar", "avx2", "avx512"
+const char* gemm_backend_name(GemmBackend backend);
+
+// эпилог над готовыми значениями C: apply(context, row, cols) вызывается для каждого
+// отрезка строки C из cols элементов, как только он посчитан окончательно (после
+// последнего блока по K), — пока блок C ещё в кэше. Отрезки не пересекаются и вместе
+// покрывают C; при делении sgemm между потоками apply вызывается из разных потоков
+struct GemmEpilogue
+{
+    void (*apply)(const void* context, float* row, size_t cols);
+    const void* context;
+};
+
+// C = alpha * op(A) * op(B) + beta * C, матрицы построчно (row-major);
+// op(A) — [M, K], op(B) — [K, N], C — [M, N]; lda/ldb/ldc — длины строк в памяти.
+// При beta == 0 содержимое C не читается. Вызванный из задачи пула потоков
+// (thread_pool.h), большой sgemm делится на полосы C между потоками пула.
+// epilogue (может быть nullptr) применяется к каждому готовому блоку C
+void sgemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, float alpha,
+           const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc,
+           const GemmEpilogue* epilogue = nullptr);
+
+// то же на заданном бэкенде (для бенчмарков и сверки бэкендов между собой)
+void sgemm(GemmBackend backend, bool trans_a, bool trans_b, size_t m, size_t n, size_t k, float alpha,
+           const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc);
+
+// наивный тройной цикл с теми же аргументами — эталон для проверки и бенчмарков
+void sgemm_reference(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, float alpha,
+                     const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc);
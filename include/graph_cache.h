@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "parser.h"
+
+// бинарный кеш разобранного графа: повторный запуск отображает файл кеша в память
+// и собирает Graph из плоских таблиц, без разбора protobuf.
+//
+// Формат (little-endian, секции выровнены на 8 байт):
+//   заголовок — сигнатура, версия, размер, mtime, ctime, inode и хэш выборки содержимого
+//   исходной модели,
+//   смещения секций;
+//   пул строк (все имена подряд) и имена тензоров в порядке TensorId;
+//   плоская таблица узлов: входы/выходы, атрибуты и эпилоги — диапазонами в общих массивах;
+//   инициализаторы и ValueInfo — записи с диапазонами размерностей;
+//   данные инициализаторов — каждое с выравниванием 64 байта: тензоры ссылаются на них
+//   лениво, как на веса в mmap модели, и исполнитель читает их на месте.
+// Внешние данные (external_data) в кеш не копируются: хранятся путь, смещение и длина.
+
+// версия формата: кеш другой версии считается устаревшим
+constexpr uint32_t GRAPH_CACHE_VERSION = 2;
+
+// выравнивание данных инициализаторов в файле кеша
+constexpr size_t GRAPH_CACHE_ALIGNMENT = 64;
+
+// путь кеша по умолчанию: рядом с моделью
+std::string graph_cache_path(const std::string& model_path);
+
+// записать кеш графа, разобранного из model_path. Пишется во временный файл и
+// переименовывается: одновременно стартующие процессы не увидят недописанный кеш.
+// false — записать не удалось
+bool save_graph_cache(const Graph& graph, const std::string& model_path, const std::string& cache_path);
+
+// граф из кеша или nullopt, если кеша нет, он другой версии, повреждён или модель
+// изменилась (размер, mtime, ctime, inode, хэш выборки содержимого). Файлы внешних данных открываются через external_files
+std::optional<Graph> load_graph_cache(const std::string& cache_path, const std::string& model_path,
+                                      ExternalDataFiles& external_files);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "parser.h"
+
+// место промежуточного тензора в арене
+struct BufferAssignment
+{
+    TensorId tensor = NO_TENSOR;
+    size_t size = 0;        // байт, с выравниванием
+    size_t offset = 0;      // байт от начала арены
+    size_t first_step = 0;  // шаг (позиция в топологическом порядке), на котором тензор вычисляется
+    size_t last_step = 0;   // последний шаг, на котором его читают (число шагов — читают после run)
+};
+
+// статический план памяти: тензоры с непересекающимися временами жизни делят место
+struct MemoryPlan
+{
+    std::vector<BufferAssignment> buffers; // в порядке вычисления тензоров
+    size_t arena_size = 0;                 // пиковый размер арены, байт
+    size_t naive_size = 0;                 // сумма размеров всех тензоров (без переиспользования)
+    size_t live_peak = 0;                  // максимум суммы живых тензоров на одном шаге — нижняя граница арены
+};
+
+// выравнивание мест в арене (строка кэша, AVX-512)
+constexpr size_t ARENA_ALIGNMENT = 64;
+
+// план для float-выходов узлов с известной статической формой (Graph::find_tensor_info,
+// т.е. после infer_shapes с конкретными формами входов). Входы графа и инициализаторы
+// в арену не попадают; выходы графа живут до конца выполнения.
+// Смещения — жадно по размеру (крупные первыми) в наименьший подходящий промежуток
+// между уже размещёнными тензорами, чьи времена жизни пересекаются с текущим.
+MemoryPlan plan_memory(const Graph& graph);
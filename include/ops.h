@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "executor.h"
+
+// геометрия 2D-свёртки после разбора атрибутов Conv
+struct ConvGeometry
+{
+    int64_t batch, in_channels, in_h, in_w;
+    int64_t out_channels, out_h, out_w;
+    int64_t kernel_h, kernel_w;
+    int64_t stride_h, stride_w;
+    int64_t dilation_h, dilation_w;
+    int64_t pad_top, pad_left, pad_bottom, pad_right;
+    int64_t group;
+};
+
+// разбор strides/dilations/pads/kernel_shape/group/auto_pad для входа X и весов W
+ConvGeometry conv_geometry(const Node& node, const std::vector<int64_t>& x_shape, const std::vector<int64_t>& w_shape);
+
+// эталонные ядра операций (NCHW, float32; формы — int64)
+void op_conv(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_relu(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_gemm(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_matmul(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_add(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_mul(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_reshape(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_concat(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+void op_shape(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs);
+
+// слитый эпилог (Relu/Add/Mul из Graph::fuse_epilogues) над выходом узла, по возможности на месте;
+// operand — значение входа op.operand или nullptr для Relu. Ядра Conv, Gemm и MatMul (только к ним
+// цепляются эпилоги) применяют эпилоги своего узла сами, к готовым плиткам выхода; отдельным
+// проходом — только если операнд растягивает выход
+void apply_fused_op(const FusedOp& op, const Value* operand, Value& value);
+
+// срез формы по атрибутам start/end узла Shape
+std::vector<int64_t> shape_slice(const Node& node, const std::vector<int64_t>& shape);
+
+// ядро по типу операции, nullptr если операция не поддерживается
+OpKernel find_kernel(const std::string& op_type);
+
+// форма результата поэлементной операции с numpy-broadcasting
+std::vector<int64_t> broadcast_shape(const std::vector<int64_t>& a, const std::vector<int64_t>& b);
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// профилировщик разбора: время, прочитанные байты и число вызовов parseGraph,
+// parseNode, parseAttribute, parseTensor, parseValueInfo, чтений BinaryReader
+// (read_varint, read_bytes/read_view) и выделения памяти внутри них.
+// Собирается только с опцией CMake ONNX_PARSE_PROFILE (макрос ONNX_PARSE_PROFILE);
+// без неё макросы ниже пустые и в код разбора ничего не попадает.
+//
+//   PARSE_PROFILE_SCOPE(phase, bytes) — замер до конца блока: время с вложенными
+//                                       и без них, байты, выделения памяти;
+//   PARSE_PROFILE_BYTES(count)        — байты замера, известные только в конце;
+//   PARSE_PROFILE_READ(phase, cursor) — вызов чтения: байты — сдвиг cursor. Время
+//                                       замеряется у каждого PARSE_PROFILE_SAMPLE-го
+//                                       вызова и экстраполируется: часы дороже varint
+
+// фазы разбора (строки отчёта)
+enum class ParsePhase
+{
+    LOAD,        // открытие файла: mmap или чтение в буфер
+    PARSE,       // ONNXParser::parse целиком
+    GRAPH,       // parseGraph (с разметкой полей многопоточного разбора)
+    NODE,        // parseNode
+    ATTRIBUTE,   // parseAttribute
+    TENSOR,      // parseTensor
+    VALUE_INFO,  // parseValueInfo
+    VARINT,      // BinaryReader::read_varint
+    BYTES,       // BinaryReader::read_bytes, read_view, read_packed_floats
+    COUNT
+};
+
+#ifdef ONNX_PARSE_PROFILE
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// каждый какой вызов чтения замеряется по времени (степень двойки)
+constexpr uint32_t PARSE_PROFILE_SAMPLE = 64;
+
+// наносекунды монотонных часов
+inline int64_t parse_profile_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ParseProfileScope;
+
+// счётчики потока: сбрасываются в общие итоги при выходе из каждого замера.
+// Тривиальная инициализация — доступ без обёртки thread_local
+struct ParseProfileThread
+{
+    ParseProfileScope* current;   // самый вложенный открытый замер потока
+    bool busy;                    // внутри профилировщика: его выделения не считаются
+    uint32_t tid;                 // номер потока в трассировке, 0 — ещё не выдан
+    uint32_t tick;                // счётчик вызовов чтения для выборки
+    uint64_t read_calls[2];       // [0] — VARINT, [1] — BYTES
+    uint64_t read_bytes[2];
+    uint64_t sampled_calls[2];
+    int64_t sampled_ns[2];
+};
+
+inline thread_local ParseProfileThread parse_profile_thread{};
+
+// замер фазы до конца блока
+struct ParseProfileScope
+{
+    ParsePhase phase;
+    uint64_t bytes;
+    int64_t start;
+    int64_t children_ns = 0;         // время вложенных замеров этого потока
+    uint64_t allocations = 0;        // собственные выделения (без вложенных замеров)
+    uint64_t allocated_bytes = 0;
+    ParseProfileScope* parent;
+
+    ParseProfileScope(ParsePhase scope_phase, uint64_t scope_bytes);
+    ~ParseProfileScope();
+
+    ParseProfileScope(const ParseProfileScope&) = delete;
+    ParseProfileScope& operator=(const ParseProfileScope&) = delete;
+};
+
+// вызов чтения BinaryReader: cursor — позиция ридера
+class ParseProfileRead
+{
+private:
+    size_t kind;
+    const size_t& cursor;
+    size_t start_pos;
+    int64_t start_ns = -1;
+
+public:
+    ParseProfileRead(ParsePhase phase, const size_t& reader_cursor)
+        : kind(phase == ParsePhase::VARINT ? 0 : 1), cursor(reader_cursor), start_pos(reader_cursor)
+    {
+        if ((++parse_profile_thread.tick & (PARSE_PROFILE_SAMPLE - 1)) == 0) start_ns = parse_profile_now();
+    }
+
+    ~ParseProfileRead()
+    {
+        ParseProfileThread& thread = parse_profile_thread;
+        thread.read_calls[kind]++;
+        thread.read_bytes[kind] += cursor - start_pos;
+        if (start_ns >= 0)
+        {
+            thread.sampled_ns[kind] += parse_profile_now() - start_ns;
+            thread.sampled_calls[kind]++;
+        }
+    }
+
+    ParseProfileRead(const ParseProfileRead&) = delete;
+    ParseProfileRead& operator=(const ParseProfileRead&) = delete;
+};
+
+// итоги фазы
+struct ParsePhaseStats
+{
+    const char* name;
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    double seconds = 0.0;       // с вложенными фазами; сумма по потокам
+    double self_seconds = 0.0;  // без вложенных замеров (чтения входят в self)
+    uint64_t allocations = 0;   // собственные выделения памяти
+    uint64_t allocated_bytes = 0;
+    bool estimated = false;     // время экстраполировано по выборке вызовов
+};
+
+// начать новый сеанс: счётчики обнуляются. trace — записывать события для
+// write_parse_trace (каждый замер фазы — событие, не больше миллиона)
+void parse_profile_reset(bool trace);
+
+// итоги сеанса по фазам в порядке ParsePhase
+std::vector<ParsePhaseStats> parse_profile_stats();
+
+// таблица итогов: фазы, МБ/с, выделения памяти, страничные отказы процесса за сеанс
+void print_parse_profile(std::ostream& out);
+
+// события сеанса в формате Chrome trace event (chrome://tracing, Perfetto).
+// false — файл не записан
+bool write_parse_trace(const std::string& path);
+
+// выделений памяти с запуска процесса (operator new подменяет профилировщик)
+size_t parse_profile_allocation_count();
+
+#define PARSE_PROFILE_SCOPE(phase, bytes) ParseProfileScope parse_profile_scope((phase), (bytes))
+#define PARSE_PROFILE_BYTES(count) (parse_profile_scope.bytes = (count))
+#define PARSE_PROFILE_READ(phase, cursor) ParseProfileRead parse_profile_read((phase), (cursor))
+
+#else
+
+#define PARSE_PROFILE_SCOPE(phase, bytes) ((void)0)
+#define PARSE_PROFILE_BYTES(count) ((void)0)
+#define PARSE_PROFILE_READ(phase, cursor) ((void)0)
+
+#endif
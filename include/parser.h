@@ -1,12 +1,19 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <iostream>
 #include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 
 #include "bin_reader.h"
+#include "symbol_table.h"
 
 // для расшифровки типа в onnx файле
 enum DATA_TYPES
@@ -24,7 +31,8 @@ enum DATA_TYPES
     FLOAT16 = 10,
     DOUBLE = 11,
     UINT32 = 12,
-    UINT64 = 13
+    UINT64 = 13,
+    BFLOAT16 = 16
 };
 
 // для расшифровки типов в парсинге атрибутов
@@ -41,20 +49,57 @@ enum ATTR_TYPES {
 };
 
 // очистка строки от мусора
+std::string_view clean_view(std::string_view bytes); // без копирования: допустимый префикс
+std::string clean_string(std::string_view bytes);
 std::string clean_string(const std::vector<uint8_t>& bytes);
 
+// имя типа данных для вывода ("FLOAT", "INT64", ...)
+const char* data_type_name(int32_t data_type);
+
+// размер элемента в байтах (0 — STRING и неизвестные типы)
+size_t data_type_size(int32_t data_type);
+
+// преобразование 16-битных вещественных в float
+float half_to_float(uint16_t bits);     // IEEE 754 binary16 (FLOAT16)
+float bfloat16_to_float(uint16_t bits); // старшие 16 бит float (BFLOAT16)
+
+// хранятся ли элементы типа data_type как T (16-битные вещественные — как uint16_t)
+template <typename T>
+constexpr bool data_type_holds(int32_t data_type)
+{
+    if constexpr (std::is_same_v<T, float>) return data_type == FLOAT;
+    else if constexpr (std::is_same_v<T, double>) return data_type == DOUBLE;
+    else if constexpr (std::is_same_v<T, int64_t>) return data_type == INT64;
+    else if constexpr (std::is_same_v<T, uint64_t>) return data_type == UINT64;
+    else if constexpr (std::is_same_v<T, int32_t>) return data_type == INT32;
+    else if constexpr (std::is_same_v<T, uint32_t>) return data_type == UINT32;
+    else if constexpr (std::is_same_v<T, int16_t>) return data_type == INT16;
+    else if constexpr (std::is_same_v<T, uint16_t>) return data_type == UINT16 || data_type == FLOAT16 || data_type == BFLOAT16;
+    else if constexpr (std::is_same_v<T, int8_t>) return data_type == INT8;
+    else if constexpr (std::is_same_v<T, uint8_t>) return data_type == UINT8 || data_type == BOOL;
+    else return false;
+}
+
 
 // класс для хранения тензора
 class Tensor
 {
     std::string name;
     std::vector<int64_t> dims; // вектор размерностей
-    int32_t data_type; // тип данных
-    std::vector<uint8_t> raw_data;
+    int32_t data_type = UNDEFINED; // тип данных
+
+    // данные либо лежат в raw_data, либо лениво ссылаются на участок файла:
+    // байты копируются только при первом вызове get_raw_data()
+    mutable std::vector<uint8_t> raw_data;
+    std::shared_ptr<const FileBuffer> source; // nullptr — данные уже в raw_data
+    size_t data_offset = 0;
+    size_t data_length = 0;
+    mutable bool materialized = false;
+    std::string external_location; // файл external_data (пусто — данные в самой модели)
 
 public:
     // геттер для имени тензора
-    std::string get_name()
+    const std::string& get_name() const
     {
         return name;
     }
@@ -68,7 +113,7 @@ public:
     // сеттеры
     void set_name(std::string tensor_name)
     {
-        name = tensor_name;
+        name = std::move(tensor_name);
     }
 
     void set_data_type(int32_t type)
@@ -76,18 +121,135 @@ public:
         data_type = type;
     }
 
-    void set_raw_data(const std::vector<uint8_t>& data) { raw_data = data; };
+    // геттеры
+    const std::vector<int64_t>& get_dims() const { return dims; }
+    int32_t get_data_type() const { return data_type; }
+
+    void set_raw_data(std::vector<uint8_t> data) 
+    { 
+        raw_data = std::move(data); 
+        source.reset();
+    };
+
+    // копирование прямо из буфера ридера, без промежуточного вектора
+    void set_raw_data(ByteView data) 
+    { 
+        raw_data.assign(data.begin(), data.end()); 
+        source.reset();
+    }
+
+    // ленивая ссылка на length байтов буфера начиная с offset
+    void set_lazy_data(std::shared_ptr<const FileBuffer> buffer, size_t offset, size_t length)
+    {
+        source = std::move(buffer);
+        data_offset = offset;
+        data_length = length;
+        raw_data.clear();
+        materialized = false;
+    }
+
+    // файл внешних данных, на который ссылается тензор; данных нет, если файл не найден
+    void set_external_location(std::string location) { external_location = std::move(location); }
+    const std::string& get_external_location() const { return external_location; }
+
+    // смещение данных в исходном буфере (файле модели или внешних данных)
+    size_t source_offset() const { return data_offset; }
+
+    // данные ещё не скопированы из файла
+    bool is_lazy() const { return source && !materialized; }
+
+    // размер данных в байтах (без загрузки)
+    size_t raw_size() const { return source ? data_length : raw_data.size(); }
+
+    // данные без копирования: указывают в буфер файла или в raw_data
+    ByteView raw_view() const
+    {
+        if (source) return source->view(data_offset, data_length);
+        return ByteView(raw_data.data(), raw_data.size());
+    }
+
+    // данные как вектор, копируются из файла при первом обращении
+    // (не потокобезопасно: первое обращение должно быть из одного потока)
+    const std::vector<uint8_t>& get_raw_data() const
+    {
+        if (is_lazy())
+        {
+            ByteView view = raw_view();
+            raw_data.assign(view.begin(), view.end());
+            materialized = true;
+        }
+        return raw_data;
+    }
+
+    // число элементов по форме
+    size_t element_count() const
+    {
+        size_t count = 1;
+        for (int64_t dim : dims) count *= static_cast<size_t>(dim);
+        return count;
+    }
+
+    // данные как массив T без копирования: указывают в буфер файла или в raw_data.
+    // Невыровненные под T данные файла один раз копируются в raw_data (его выравнивает malloc).
+    // T должен соответствовать data_type (см. data_type_holds)
+    template <typename T>
+    Span<T> as_span() const
+    {
+        if (!data_type_holds<T>(data_type))
+        {
+            throw std::runtime_error("Тензор " + name + ": данные типа " + data_type_name(data_type)
+                                     + " нельзя прочитать как элементы размера " + std::to_string(sizeof(T)));
+        }
+
+        ByteView bytes = raw_view();
+        if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(T) != 0)
+        {
+            const std::vector<uint8_t>& copy = get_raw_data();
+            bytes = ByteView(copy.data(), copy.size());
+        }
+        if (bytes.size() % sizeof(T) != 0)
+        {
+            throw std::runtime_error("Тензор " + name + ": размер данных " + std::to_string(bytes.size())
+                                     + " не кратен размеру элемента");
+        }
+        return Span<T>(reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T));
+    }
+
+    // значения как float: FLOAT копируется, FLOAT16/BFLOAT16/DOUBLE преобразуются
+    std::vector<float> to_floats() const;
 };
 
 
 
+// элементы словаря атрибутов в порядке имён: вывод и кеш графа не зависят
+// от порядка обхода unordered_map
+template <typename Map>
+std::vector<const typename Map::value_type*> sorted_by_name(const Map& attrs)
+{
+    std::vector<const typename Map::value_type*> sorted;
+    sorted.reserve(attrs.size());
+    for (const auto& attr : attrs) sorted.push_back(&attr);
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+    return sorted;
+}
+
+// поэлементная операция, слитая с предыдущим узлом (эпилог Conv/Gemm/MatMul):
+// применяется к выходу узла сразу после вычисления, без отдельного тензора
+struct FusedOp
+{
+    std::string op_type;   // Relu, Add или Mul
+    std::string name;      // имя исходного узла
+    int32_t operand = -1;  // номер второго операнда во входах узла (-1 для Relu)
+};
+
 // класс, хранящий операцию и ее параметры
 class Node
 {
     std::string name;
     std::string op_type; // тип операции
-    std::vector<std::string> inputs; // имена входных тензоров
-    std::vector<std::string> outputs; // имена выходных тензоров
+    std::vector<TensorId> inputs; // входные тензоры (имена — в SymbolTable графа)
+    std::vector<TensorId> outputs; // выходные тензоры
+    std::vector<FusedOp> fused; // эпилоги после слияния (Graph::fuse_epilogues)
 
     // добавить атрибуты
 public:
@@ -96,52 +258,89 @@ public:
     std::unordered_map<std::string, float> float_attrs;        // для alpha, beta
     std::unordered_map<std::string, std::vector<int64_t>> ints_attrs; // для strides, dilations
     std::unordered_map<std::string, std::string> string_attrs; // для auto_pad
+    std::unordered_map<std::string, std::vector<float>> floats_attrs; // списки float (scales, ...)
 
     // Методы для добавления атрибутов
-    void add_int_attr(const std::string& name, int64_t value) { 
-        int_attrs[name] = value; 
+    // (аргументы по значению: rvalue перемещаются без лишней копии)
+    void add_int_attr(std::string name, int64_t value) { 
+        int_attrs.insert_or_assign(std::move(name), value); 
     }
     
-    void add_float_attr(const std::string& name, float value) { 
-        float_attrs[name] = value; 
+    void add_float_attr(std::string name, float value) { 
+        float_attrs.insert_or_assign(std::move(name), value); 
     }
     
-    void add_ints_attr(const std::string& name, const std::vector<int64_t>& value) { 
-        ints_attrs[name] = value; 
+    void add_ints_attr(std::string name, std::vector<int64_t> value) { 
+        ints_attrs.insert_or_assign(std::move(name), std::move(value)); 
     }
     
-    void add_string_attr(const std::string& name, const std::string& value) { 
-        string_attrs[name] = value; 
+    void add_string_attr(std::string name, std::string value) { 
+        string_attrs.insert_or_assign(std::move(name), std::move(value)); 
     }
 
-    // добавить строку входа в имена входных тензоров
-    void add_input(std::string input)
+    void add_floats_attr(std::string name, std::vector<float> value) { 
+        floats_attrs.insert_or_assign(std::move(name), std::move(value)); 
+    }
+
+    // добавить входной тензор (id из Graph::intern_tensor)
+    void add_input(TensorId input)
     {
         inputs.push_back(input);
     }
 
-    // добавить строку выхода в имена выходных тензоров
-    void add_output(std::string output)
+    // добавить выходной тензор
+    void add_output(TensorId output)
     {
         outputs.push_back(output);
     }
 
+    // заменить k-й вход (при перезаписи графа)
+    void set_input(size_t k, TensorId input)
+    {
+        inputs.at(k) = input;
+    }
+
+    // заменить k-й выход (при перезаписи графа)
+    void set_output(size_t k, TensorId output)
+    {
+        outputs.at(k) = output;
+    }
+
+    // добавить слитую операцию (применяется после уже добавленных)
+    void add_fused(FusedOp op)
+    {
+        fused.push_back(std::move(op));
+    }
+
     // сеттеры
     void set_name(std::string node_name)
     {
-        name = node_name;
+        name = std::move(node_name);
     }
     void set_op_type(std::string op_name)
     {
-        op_type = op_name;
+        op_type = std::move(op_name);
     }
 
     // геттеры
     const std::string& get_op_type() const { return op_type; }
-    const std::vector<std::string>& get_inputs() const { return inputs; }
-    const std::vector<std::string>& get_outputs() const { return outputs; }
+    const std::vector<TensorId>& get_inputs() const { return inputs; }
+    const std::vector<TensorId>& get_outputs() const { return outputs; }
     const std::string& get_name() const { return name; }
+    const std::vector<FusedOp>& get_fused() const { return fused; }
+
+    // тип для вывода: "Conv" или, после слияния, "Conv+Relu"
+    std::string display_type() const
+    {
+        std::string result = op_type;
+        for (const FusedOp& op : fused) result += "+" + op.op_type;
+        return result;
+    }
     // геттеры для атрибутов
+    const std::unordered_map<std::string, int64_t>& get_int_attrs() const { 
+        return int_attrs; 
+    }
+
     const std::unordered_map<std::string, std::vector<int64_t>>& get_ints_attrs() const { 
         return ints_attrs; 
     }
@@ -153,6 +352,119 @@ public:
     const std::unordered_map<std::string, std::string>& get_string_attrs() const { 
         return string_attrs; 
     }
+
+    const std::unordered_map<std::string, std::vector<float>>& get_floats_attrs() const { 
+        return floats_attrs; 
+    }
+
+    // значение атрибута или значение по умолчанию, если атрибута нет
+    // (парсер кладёт INT в ints_attrs, add_int_attr — в int_attrs)
+    int64_t get_int(const std::string& attr, int64_t default_value) const
+    {
+        auto single = int_attrs.find(attr);
+        if (single != int_attrs.end()) return single->second;
+
+        auto it = ints_attrs.find(attr);
+        return (it == ints_attrs.end() || it->second.empty()) ? default_value : it->second[0];
+    }
+
+    std::vector<int64_t> get_ints(const std::string& attr, std::vector<int64_t> default_value = {}) const
+    {
+        auto it = ints_attrs.find(attr);
+        return it == ints_attrs.end() ? default_value : it->second;
+    }
+
+    float get_float(const std::string& attr, float default_value) const
+    {
+        auto it = float_attrs.find(attr);
+        return it == float_attrs.end() ? default_value : it->second;
+    }
+
+    std::string get_string(const std::string& attr, const std::string& default_value) const
+    {
+        auto it = string_attrs.find(attr);
+        return it == string_attrs.end() ? default_value : it->second;
+    }
+};
+
+// номер узла в Graph::get_nodes()
+using NodeId = uint32_t;
+
+// тензор без производящего узла (вход сети или вес)
+constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+
+// индекс смежности графа в формате CSR: для каждого тензора — производитель
+// и потребители, для каждого узла — предшественники и последователи.
+// Строится один раз за O(узлы + рёбра), запросы — O(1) или O(степени).
+class GraphIndex
+{
+private:
+    std::vector<NodeId> producers;          // TensorId → узел-производитель
+
+    std::vector<uint32_t> consumer_offsets; // TensorId → [begin, end) в consumer_list
+    std::vector<NodeId> consumer_list;
+
+    std::vector<uint32_t> pred_offsets;     // NodeId → [begin, end) в pred_list
+    std::vector<NodeId> pred_list;
+
+    std::vector<uint32_t> succ_offsets;     // NodeId → [begin, end) в succ_list
+    std::vector<NodeId> succ_list;
+
+public:
+    // построение индекса по узлам графа
+    void build(const std::vector<Node>& nodes, size_t tensor_count);
+
+    // узел, производящий тензор, или NO_NODE
+    NodeId producer_of(TensorId tensor) const
+    {
+        return tensor < producers.size() ? producers[tensor] : NO_NODE;
+    }
+
+    // узлы, читающие тензор (каждый узел один раз)
+    Span<NodeId> consumers_of(TensorId tensor) const
+    {
+        if (tensor + 1 >= consumer_offsets.size()) return Span<NodeId>();
+        return Span<NodeId>(consumer_list.data() + consumer_offsets[tensor],
+                            consumer_offsets[tensor + 1] - consumer_offsets[tensor]);
+    }
+
+    // узлы, от выходов которых зависит node
+    Span<NodeId> predecessors(NodeId node) const
+    {
+        return Span<NodeId>(pred_list.data() + pred_offsets[node],
+                            pred_offsets[node + 1] - pred_offsets[node]);
+    }
+
+    // узлы, которые читают выходы node
+    Span<NodeId> successors(NodeId node) const
+    {
+        return Span<NodeId>(succ_list.data() + succ_offsets[node],
+                            succ_offsets[node + 1] - succ_offsets[node]);
+    }
+};
+
+// тип и форма тензора из ValueInfoProto (входы/выходы графа, value_info) или из вывода форм.
+// Неизвестная размерность — -1; у символьной (batch_size) ещё и имя в dim_params
+struct TensorInfo
+{
+    int32_t data_type = UNDEFINED;
+    std::vector<int64_t> dims;
+    std::vector<std::string> dim_params; // по одному на размерность, пустое — не символьная
+    bool has_shape = false;              // известен хотя бы ранг
+
+    // все размерности известны числами
+    bool is_static() const
+    {
+        if (!has_shape) return false;
+        for (int64_t dim : dims)
+        {
+            if (dim < 0) return false;
+        }
+        return true;
+    }
+
+    // "[batch_size, 1, 28, 28]", "[?]" для неизвестной размерности
+    std::string shape_string() const;
 };
 
 // класс для хранения графа
@@ -160,9 +472,32 @@ class Graph
 {
 private:
     std::vector<Node> nodes;                          // все узлы
-    std::unordered_map<std::string, Tensor> initializers;  // веса (поиск по имени)
-    std::vector<std::string> inputs;                   // входы всей сети
-    std::vector<std::string> outputs;                  // выходы всей сети
+    SymbolTable tensor_names;                         // имя тензора ↔ TensorId
+    std::unordered_map<TensorId, Tensor> initializers;  // веса (поиск по id)
+    std::vector<TensorId> inputs;                     // входы всей сети
+    std::vector<TensorId> outputs;                    // выходы всей сети
+    std::unordered_map<TensorId, TensorInfo> tensor_infos; // типы и формы (ValueInfoProto, вывод форм)
+
+    // индекс смежности: строится после разбора или при первом запросе,
+    // сбрасывается при изменении списка узлов
+    mutable GraphIndex index;
+    mutable bool index_valid = false;
+
+    // топологический порядок и разбиение на уровни (кешируются так же)
+    mutable std::vector<NodeId> topo_order;      // узлы уровня 0, затем уровня 1, ...
+    mutable std::vector<uint32_t> level_offsets; // уровень → [begin, end) в topo_order
+    mutable std::vector<uint32_t> node_levels;   // NodeId → номер уровня
+    mutable bool order_valid = false;
+
+    // сброс кешей анализа после изменения узлов
+    void invalidate_analysis()
+    {
+        index_valid = false;
+        order_valid = false;
+    }
+
+    // алгоритм Кана по уровням, бросает runtime_error при цикле
+    void build_order() const;
 
     int64_t ir_version;
     std::string producer_name;
@@ -173,30 +508,170 @@ private:
 public:
     // сеттеры
     void setIrVersion(int64_t version) { ir_version = version; }
-    void setProducerName(const std::string& name) { producer_name = name; }
-    void setProducerVersion(const std::string& version) { producer_version = version; }
-    void setGraphName(const std::string& name) {graph_name = name; }
+    void setProducerName(std::string name) { producer_name = std::move(name); }
+    void setProducerVersion(std::string version) { producer_version = std::move(version); }
+    void setGraphName(std::string name) { graph_name = std::move(name); }
 
     // добавить новую ноду
     void add_node(Node node)
     {
-        nodes.push_back(node);
+        nodes.push_back(std::move(node));
+        invalidate_analysis();
+    }
+
+    // создать ноду прямо в графе и вернуть ссылку на неё
+    Node& emplace_node()
+    {
+        invalidate_analysis();
+        return nodes.emplace_back();
+    }
+
+    // слияние поэлементных Relu/Add/Mul с предшествующими Conv/Gemm/MatMul:
+    // поглощённые узлы удаляются, их выходы переходят к узлу-производителю.
+    // Возвращает число удалённых узлов.
+    size_t fuse_epilogues();
+
+    // удалить узлы с removed[i] == true, порядок остальных сохраняется
+    void remove_nodes(const std::vector<bool>& removed);
+
+    // удалить инициализатор (имя остаётся в таблице символов)
+    void remove_initializer(TensorId id)
+    {
+        initializers.erase(id);
+    }
+
+    // зарезервировать место под узлы (если их число известно заранее)
+    void reserve_nodes(size_t count)
+    {
+        nodes.reserve(count);
     }
 
     // добавить новый тензор
     void add_tensor(Tensor tensor)
     {
-        initializers[tensor.get_name()] = tensor;
+        TensorId id = tensor_names.intern(tensor.get_name());
+        initializers.insert_or_assign(id, std::move(tensor));
+    }
+
+    // добавить тензор, чьё имя уже в таблице под id (без повторного поиска по имени)
+    void add_tensor(TensorId id, Tensor tensor)
+    {
+        initializers.insert_or_assign(id, std::move(tensor));
+    }
+
+    // вход и выход всей сети
+    void add_input(TensorId id) { inputs.push_back(id); }
+    void add_output(TensorId id) { outputs.push_back(id); }
+
+    // тип и форма тензора (заменяет прежние)
+    void set_tensor_info(TensorId id, TensorInfo info)
+    {
+        tensor_infos.insert_or_assign(id, std::move(info));
+    }
+
+    // тип и форма тензора или nullptr, если неизвестны
+    const TensorInfo* find_tensor_info(TensorId id) const
+    {
+        auto it = tensor_infos.find(id);
+        return it == tensor_infos.end() ? nullptr : &it->second;
+    }
+
+    // перенести имена тензоров other в этот граф (см. SymbolTable::merge): id в этом
+    // графе для каждого id в other; узлы и тензоры other после этого без имён
+    std::vector<TensorId> merge_symbols(Graph& other)
+    {
+        return tensor_names.merge(std::move(other.tensor_names));
+    }
+
+    // место под count имён тензоров
+    void reserve_tensors(size_t count) { tensor_names.reserve(count); }
+
+    // id тензора по имени, имя добавляется в таблицу при первом появлении
+    TensorId intern_tensor(std::string_view name) { return tensor_names.intern(name); }
+
+    // id тензора по имени или NO_TENSOR
+    TensorId find_tensor(std::string_view name) const { return tensor_names.find(name); }
+
+    // имя тензора по id
+    const std::string& tensor_name(TensorId id) const { return tensor_names.name(id); }
+
+    // число различных тензоров в графе (все TensorId меньше этого числа)
+    size_t tensor_count() const { return tensor_names.size(); }
+
+    // вес по id или имени, nullptr если это не инициализатор
+    const Tensor* find_initializer(TensorId id) const
+    {
+        auto it = initializers.find(id);
+        return it == initializers.end() ? nullptr : &it->second;
+    }
+
+    const Tensor* find_initializer(std::string_view name) const
+    {
+        return find_initializer(find_tensor(name));
+    }
+
+    // построить индекс смежности заранее (ленивое построение в const-методах
+    // не потокобезопасно, поэтому перед многопоточным анализом лучше вызвать явно)
+    void build_index() const
+    {
+        index.build(nodes, tensor_names.size());
+        index_valid = true;
+    }
+
+    // индекс смежности (строится при первом обращении)
+    const GraphIndex& get_index() const
+    {
+        if (!index_valid) build_index();
+        return index;
+    }
+
+    // запросы к индексу смежности
+    NodeId producer_of(TensorId tensor) const { return get_index().producer_of(tensor); }
+    Span<NodeId> consumers_of(TensorId tensor) const { return get_index().consumers_of(tensor); }
+    Span<NodeId> predecessors(NodeId node) const { return get_index().predecessors(node); }
+    Span<NodeId> successors(NodeId node) const { return get_index().successors(node); }
+
+    // узлы в топологическом порядке (каждый узел после всех своих предшественников);
+    // если в графе есть цикл — std::runtime_error
+    const std::vector<NodeId>& topological_order() const
+    {
+        if (!order_valid) build_order();
+        return topo_order;
+    }
+
+    // число уровней: на уровне k лежат узлы, все входы которых готовы после уровня k-1
+    size_t level_count() const
+    {
+        topological_order();
+        return level_offsets.size() - 1;
+    }
+
+    // узлы одного уровня, их можно выполнять независимо друг от друга
+    Span<NodeId> level(size_t k) const
+    {
+        const std::vector<NodeId>& order = topological_order();
+        return Span<NodeId>(order.data() + level_offsets[k], level_offsets[k + 1] - level_offsets[k]);
+    }
+
+    // уровень узла
+    uint32_t level_of(NodeId node) const
+    {
+        topological_order();
+        return node_levels[node];
     }
 
     // геттеры
     const std::vector<Node>& get_nodes() const { return nodes; }
 
-    const std::unordered_map<std::string, Tensor>& get_initializers() const { return initializers; }
+    const SymbolTable& get_symbols() const { return tensor_names; }
 
-    const std::vector<std::string>& get_inputs() const { return inputs; }
+    const std::unordered_map<TensorId, Tensor>& get_initializers() const { return initializers; }
 
-    const std::vector<std::string>& get_outputs() const { return outputs; }
+    const std::vector<TensorId>& get_inputs() const { return inputs; }
+
+    const std::vector<TensorId>& get_outputs() const { return outputs; }
+
+    const std::unordered_map<TensorId, TensorInfo>& get_tensor_infos() const { return tensor_infos; }
 
     // для отладки и тестов
     int64_t getIrVersion() const { return ir_version; }
@@ -214,19 +689,29 @@ class ONNXParser
 private:
     BinaryReader reader;      // читает байты
     Graph graph;              // сюда собираем результат
-    
+    size_t threads = 1;       // потоков для разбора узлов и инициализаторов
+    std::shared_ptr<ExternalDataFiles> external_files; // файлы external_data рядом с моделью
+
+    // ридер над тем же буфером, свой граф (своя таблица имён): так разбирает
+    // узлы и тензоры один поток многопоточного разбора. Файлы внешних данных общие
+    ONNXParser(const BinaryReader& source, std::shared_ptr<ExternalDataFiles> files)
+        : reader(source), external_files(std::move(files)) {}
+
     // вспомогательная функция для парсинга графа
     void parseGraph(uint64_t length)
     {
+        PARSE_PROFILE_SCOPE(ParsePhase::GRAPH, length);
         size_t end_pos = reader.get_cur_pos() + length;
-        uint8_t cur_byte = reader.watch_cur_byte();
+
+        // многопоточно — до первого поля, которое нельзя разметить заранее; остаток — ниже
+        if (threads != 1) parseGraphParallel(end_pos);
 
         while (reader.get_cur_pos() < end_pos) 
         {
-            cur_byte = reader.watch_cur_byte();
-            int wire_type = cur_byte & 0x07;
-            int field_number = cur_byte >> 3;
-            reader.read_byte();
+            // тег — varint: у полей с номером от 16 (metadata_props) он двухбайтовый
+            uint64_t tag = reader.read_varint();
+            int wire_type = tag & 0x07;
+            uint64_t field_number = tag >> 3;
 
             switch (field_number)
             {
@@ -234,8 +719,7 @@ private:
                 {
                     uint64_t node_size = reader.read_varint(); // длина узла
 
-                    Node res_node = parseNode(node_size);
-                    graph.add_node(res_node);
+                    graph.add_node(parseNode(node_size));
                     break;
                 }
 
@@ -244,9 +728,7 @@ private:
                     uint64_t str_size = reader.read_varint();
                     if (reader.get_cur_pos() + str_size > end_pos) break;
 
-                    auto bytes = reader.read_bytes(str_size);
-                    std::string name = clean_string(bytes);
-                    graph.setGraphName(name);
+                    graph.setGraphName(clean_string(reader.read_string_view(str_size)));
                     break;
                 }
 
@@ -254,39 +736,31 @@ private:
                 {
                     uint64_t tensor_size = reader.read_varint();
 
-                    Tensor res_tensor = parseTensor(tensor_size);
-                    graph.add_tensor(res_tensor);
+                    graph.add_tensor(parseTensor(tensor_size));
                     break;
                 }
 
                 case 11: // inputs графа (входы всей сети)
+                case 12: // outputs графа (выходы всей сети)
+                case 13: // value_info (формы промежуточных тензоров)
                 {
                     uint64_t len = reader.read_varint();
                     if (reader.get_cur_pos() + len > end_pos) break;
 
-                    reader.read_bytes(len);  // пока просто пропускаем
-                    break;
-                }
+                    std::string_view name;
+                    TensorInfo info = parseValueInfo(len, name);
+                    TensorId id = graph.intern_tensor(clean_view(name));
+                    if (id == NO_TENSOR) break;
 
-                case 12: // outputs графа (выходы всей сети)
-                {
-                    uint64_t len = reader.read_varint();
-                    if (reader.get_cur_pos() + len > end_pos) break;
-                    
-                    reader.read_bytes(len);  // пока просто пропускаем
+                    if (field_number == 11) graph.add_input(id);
+                    if (field_number == 12) graph.add_output(id);
+                    graph.set_tensor_info(id, std::move(info));
                     break;
-                }   
+                }
 
-                default: // для неизвестных полей
+                default: // для неизвестных полей (sparse_initializer, metadata_props, ...)
                 {
-                    if (wire_type == 0) {
-                        reader.read_varint();
-                    } else if (wire_type == 2) {
-                        uint64_t len = reader.read_varint();
-                        if (reader.get_cur_pos() + len > end_pos) break;
-
-                        reader.read_bytes(len);
-                    }
+                    skipField(wire_type);
                     break;
                 }
             }
@@ -298,16 +772,49 @@ private:
 
     // вспомогательная функция для парсинга одного тензора
     Tensor parseTensor(uint64_t tensor_size);   
+
+    // StringStringEntryProto из external_data тензора: ключ и значение
+    void parseStringEntry(uint64_t length, std::string& key, std::string& value);
     
     // вспомогательная функция для парсинга атрибута
     void parseAttribute(Node& node, uint64_t attr_len);
+
+    // ValueInfoProto: имя (указывает в буфер файла) и TypeProto.Tensor — тип и форма
+    TensorInfo parseValueInfo(uint64_t length, std::string_view& name);
+
+    // TensorShapeProto: размерности числом (dim_value) или именем (dim_param)
+    void parseShape(uint64_t length, TensorInfo& info);
+
+    // пропуск значения поля неизвестного типа
+    void skipField(int wire_type);
+
+    // двухфазный разбор GraphProto: быстрый проход только размечает поля (тег, смещение,
+    // длина), затем узлы, инициализаторы и ValueInfo разбираются порциями на пуле потоков,
+    // и результаты добавляются в граф в порядке файла — TensorId те же, что при
+    // последовательном разборе. Останавливается перед полем, которое не удалось разметить
+    // (обрезанный файл, неожиданный wire type): его и остаток разбирает parseGraph
+    void parseGraphParallel(size_t end_pos);
     
 public:
-    ONNXParser(const std::string& filename);
+    // по умолчанию модель читается через mmap, см. ReadMode
+    ONNXParser(const std::string& filename, ReadMode mode = ReadMode::MMAP);
+
+    // число потоков разбора (0 — по числу ядер, 1 — последовательно)
+    void set_threads(size_t count) { threads = count; }
+
+    // файлы внешних данных модели (общие с загрузкой графа из кеша)
+    ExternalDataFiles& external_data() { return *external_files; }
+
+    // файлы внешних данных: сколько отображено при разборе и каких не нашлось
+    size_t external_file_count() const { return external_files->mapped_count(); }
+    std::vector<std::string> missing_external_files() const { return external_files->missing(); }
+
+    // разбирает файл и отдаёт граф перемещением: после вызова
+    // парсер больше не владеет графом
     Graph parse();            
 };
 
-inline ONNXParser::ONNXParser(const std::string& filename) 
-    : reader(filename) {}
+inline ONNXParser::ONNXParser(const std::string& filename, ReadMode mode) 
+    : reader(filename, mode), external_files(std::make_shared<ExternalDataFiles>(filename, mode)) {}
 
 
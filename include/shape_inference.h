@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parser.h"
+
+// итог вывода форм
+struct ShapeInferenceResult
+{
+    size_t inferred = 0;                 // тензоров, получивших тип и форму
+    std::vector<std::string> mismatches; // расхождения с формами, объявленными в модели (value_info)
+    std::vector<std::string> skipped;    // узлы, формы выходов которых вывести не удалось, и причина
+};
+
+// вывод типов и форм всех тензоров графа для поддерживаемых операций.
+// Исходные данные — инициализаторы и входы графа (ValueInfoProto); input_shapes
+// (имя входа → форма) перекрывают объявленные формы входов.
+// Символьные размерности (batch_size) протекают через граф; для тензоров-форм
+// (Shape → Concat → Reshape) отслеживаются и их значения.
+// Результат записывается в Graph::set_tensor_info; объявленные формы промежуточных
+// тензоров не используются как входные данные, а только сверяются с выведенными.
+ShapeInferenceResult infer_shapes(Graph& graph,
+                                  const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes = {});
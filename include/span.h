@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// невладеющее представление непрерывного массива (аналог std::span из C++20)
+template <typename T>
+class Span
+{
+    const T* ptr;
+    size_t len;
+
+public:
+    Span() : ptr(nullptr), len(0) {}
+    Span(const T* data, size_t size) : ptr(data), len(size) {}
+
+    // геттеры
+    const T* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+
+    const T& operator[](size_t i) const { return ptr[i]; }
+
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + len; }
+};
+
+// байты внутри буфера ридера
+using ByteView = Span<uint8_t>;
+
+// байты как строка без копирования
+inline std::string_view as_string_view(ByteView view)
+{
+    return std::string_view(reinterpret_cast<const char*>(view.data()), view.size());
+}
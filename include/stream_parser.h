@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bin_reader.h"
+#include "parser.h"
+
+// потоковый (SAX) разбор модели: узлы, инициализаторы и поля метаданных передаются
+// обработчикам по мере декодирования и нигде не накапливаются. Данные тензоров
+// пропускаются (seek), поэтому память — окно StreamReader плюс одна запись узла,
+// независимо от размера модели.
+//
+// Все string_view и Span в записях указывают во внутренние буферы разборщика и
+// действительны только до возврата из обработчика.
+
+// атрибут узла
+struct StreamAttribute
+{
+    std::string_view name;
+    int64_t type = ATTR_UNDEFINED; // ATTR_TYPES
+    int64_t i = 0;
+    float f = 0.0f;
+    std::string_view s;
+    Span<int64_t> ints;
+    Span<float> floats;
+};
+
+// NodeProto
+struct StreamNode
+{
+    std::string_view name;
+    std::string_view op_type;
+    std::string_view domain;
+    Span<std::string_view> inputs;
+    Span<std::string_view> outputs;
+    Span<StreamAttribute> attributes;
+};
+
+// TensorProto (инициализатор графа) без данных: где они лежат и сколько занимают
+struct StreamTensor
+{
+    std::string_view name;
+    int32_t data_type = UNDEFINED;
+    Span<int64_t> dims;
+    uint64_t data_offset = 0; // в потоке (внешние данные — в файле external_location)
+    uint64_t data_length = 0; // байт данных в потоке или во внешнем файле
+    std::string_view external_location; // пусто — данные в самой модели
+};
+
+// обработчики; незаданный пропускается
+struct StreamCallbacks
+{
+    // поле ModelProto/GraphProto: "ir_version", "producer_name", "producer_version", "domain",
+    // "model_version", "doc_string", "graph_name", "opset:<домен>" (значение — версия),
+    // "metadata:<ключ>" (metadata_props)
+    std::function<void(std::string_view key, std::string_view value)> on_metadata;
+    std::function<void(const StreamNode& node)> on_node;
+    std::function<void(const StreamTensor& tensor)> on_tensor;
+};
+
+// потоковый разборщик ONNX
+class ONNXStreamParser
+{
+private:
+    StreamReader& reader;
+    StreamCallbacks callbacks;
+
+    // строка в text: [offset, offset + length)
+    struct TextRef
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    // атрибут, пока узел не дочитан (text и пулы ещё могут переехать при росте)
+    struct PendingAttribute
+    {
+        TextRef name;
+        int64_t type = ATTR_UNDEFINED;
+        int64_t i = 0;
+        float f = 0.0f;
+        TextRef s;
+        size_t ints_begin = 0, ints_end = 0;
+        size_t floats_begin = 0, floats_end = 0;
+    };
+
+    // буферы текущей записи: очищаются, но не освобождаются между записями
+    std::string text;
+    std::vector<TextRef> input_refs, output_refs;
+    std::vector<PendingAttribute> pending;
+    std::vector<int64_t> int_pool;
+    std::vector<float> float_pool;
+    std::vector<std::string_view> views;
+    std::vector<StreamAttribute> attributes;
+
+    // строка длины n из потока в text; имена очищаются как в ONNXParser (clean_view)
+    TextRef read_text(uint64_t n, bool clean);
+    std::string_view view_of(TextRef ref) const;
+
+    void parseGraph(uint64_t length);
+    void parseNode(uint64_t length);
+    void parseAttribute(uint64_t length);
+    void parseTensor(uint64_t length);
+    void parseOpset(uint64_t length);
+    void parseStringEntry(uint64_t length, TextRef& key, TextRef& value);
+    void skipField(int wire_type);
+
+    // упакованные или поштучные varint / fixed32 повторяющегося поля
+    void read_varints(int wire_type, uint64_t end_pos, std::vector<int64_t>& values);
+    void read_floats(int wire_type, uint64_t end_pos, std::vector<float>& values);
+
+public:
+    ONNXStreamParser(StreamReader& stream, StreamCallbacks handlers)
+        : reader(stream), callbacks(std::move(handlers)) {}
+
+    // прочитать модель до конца; обрезанный поток — std::out_of_range("Unexpected EOF")
+    void parse();
+};
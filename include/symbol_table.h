@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// плотный номер имени тензора внутри графа
+using TensorId = uint32_t;
+
+// пустое имя (в ONNX так обозначается отсутствующий необязательный вход)
+constexpr TensorId NO_TENSOR = std::numeric_limits<TensorId>::max();
+
+// таблица имён тензоров: каждое имя хранится один раз, узлы ссылаются на него по TensorId
+class SymbolTable
+{
+private:
+    std::deque<std::string> names;                      // id → имя (deque не двигает строки при росте)
+    std::unordered_map<std::string_view, TensorId> ids; // имя → id, ключи указывают в names
+
+    void rebuild_index()
+    {
+        ids.clear();
+        ids.reserve(names.size());
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            ids.emplace(names[i], static_cast<TensorId>(i));
+        }
+    }
+
+public:
+    SymbolTable() = default;
+
+    // при копировании ключи должны указывать в свои строки, а не в чужие
+    SymbolTable(const SymbolTable& other) : names(other.names) { rebuild_index(); }
+
+    SymbolTable& operator=(const SymbolTable& other)
+    {
+        if (this != &other)
+        {
+            names = other.names;
+            rebuild_index();
+        }
+        return *this;
+    }
+
+    SymbolTable(SymbolTable&&) = default;
+    SymbolTable& operator=(SymbolTable&&) = default;
+
+    // получить id имени, добавив его при первом появлении
+    TensorId intern(std::string_view name)
+    {
+        if (name.empty()) return NO_TENSOR;
+
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+
+        TensorId id = static_cast<TensorId>(names.size());
+        names.emplace_back(name);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    // перенести имена other в эту таблицу в порядке их id: новые имена получают id
+    // по порядку, строки перемещаются без копирования, other остаётся пустой.
+    // Результат: id в этой таблице для каждого id в other
+    std::vector<TensorId> merge(SymbolTable&& other)
+    {
+        std::vector<TensorId> result(other.names.size());
+        other.ids.clear(); // ключи указывают в перемещаемые строки
+
+        for (size_t i = 0; i < other.names.size(); i++)
+        {
+            auto it = ids.find(other.names[i]);
+            if (it != ids.end())
+            {
+                result[i] = it->second;
+                continue;
+            }
+
+            result[i] = static_cast<TensorId>(names.size());
+            names.push_back(std::move(other.names[i]));
+            ids.emplace(names.back(), result[i]);
+        }
+
+        other.names.clear();
+        return result;
+    }
+
+    // место под count имён без перестроения индекса
+    void reserve(size_t count) { ids.reserve(count); }
+
+    // id имени или NO_TENSOR, если такого имени нет
+    TensorId find(std::string_view name) const
+    {
+        auto it = ids.find(name);
+        return it == ids.end() ? NO_TENSOR : it->second;
+    }
+
+    // имя по id (для NO_TENSOR — пустая строка)
+    const std::string& name(TensorId id) const
+    {
+        static const std::string empty;
+        return id < names.size() ? names[id] : empty;
+    }
+
+    // число различных имён
+    size_t size() const { return names.size(); }
+};
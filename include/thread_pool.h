@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+// группа задач: wait() ждёт все задачи группы, включая поставленные из самих задач
+class TaskGroup
+{
+    friend class ThreadPool;
+
+    std::atomic<size_t> pending{0};    // поставлено и ещё не завершено
+    std::atomic<bool> error{false};
+    std::exception_ptr first_error;    // пишется один раз, под флагом error
+
+public:
+    // какая-то задача группы бросила исключение (остальные могут пропустить работу)
+    bool failed() const { return error.load(std::memory_order_relaxed); }
+};
+
+// пул потоков с очередью на каждый поток и кражей работы: свои задачи поток берёт
+// с конца своей очереди (последняя поставленная ещё горячая в кэше), чужие крадёт
+// с начала. Вызывающий поток в wait() тоже выполняет задачи, поэтому пул на
+// N потоков запускает N - 1 рабочих
+class ThreadPool
+{
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;   // можно красть
+        std::deque<std::function<void()>> pinned;  // только для своего потока
+        std::atomic<size_t> pinned_count{0};
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues; // [0] — поток, вызвавший wait()
+    std::vector<std::thread> workers;
+
+    std::atomic<size_t> queued{0};         // задач, которые можно красть, во всех очередях
+    std::atomic<size_t> sleeping{0};       // потоков, ждущих на wake
+    std::atomic<size_t> next_queue{0};     // очередь для задач из посторонних потоков
+    std::atomic<bool> stopping{false};
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;      // условие join могло выполниться
+    std::vector<int> cpus;                 // поток i (кроме 0) закреплён за cpus[i % size]; пусто — без закрепления
+
+    void worker_loop(size_t index);
+    void sleep_until_work(size_t index, const std::function<bool()>& done);
+    std::function<void()> wrap_task(TaskGroup& group, std::function<void()> task);
+    std::function<void()> take_pinned(size_t index);   // nullptr — закреплённых нет
+    bool try_run_one(size_t index);        // закреплённая, своя или украденная задача; false — нечего делать
+    void wake_one();
+    void wake_all();
+
+public:
+    // threads — всего потоков вместе с вызывающим (0 — по числу ядер).
+    // pin_threads: рабочие потоки закрепляются за ядрами по порядку узлов NUMA
+    // (сначала все ядра узла 0, потом узла 1, ...), так что соседние потоки — на одном узле;
+    // вызывающий поток (индекс 0) не закрепляется
+    explicit ThreadPool(size_t threads = 0, bool pin_threads = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return queues.size(); }
+
+    // ядро, за которым закреплён поток (-1 — не закреплён)
+    int cpu_of(size_t thread) const
+    {
+        return thread == 0 || cpus.empty() ? -1 : cpus[thread % cpus.size()];
+    }
+
+    // пул, которому принадлежит вызывающий поток (рабочий или ждущий в wait), иначе nullptr
+    static ThreadPool* current();
+
+    // индекс вызывающего потока в current()
+    static size_t current_thread();
+
+    // задача в очередь текущего потока пула (или по кругу, если поток посторонний);
+    // исключение задачи сохраняется в группе и бросается из wait()
+    void submit(TaskGroup& group, std::function<void()> task);
+
+    // задача, которую выполнит только поток thread (её не крадут): части parallel_for
+    // расходятся по разным потокам, а не достаются первому освободившемуся
+    void submit_to(size_t thread, TaskGroup& group, std::function<void()> task);
+
+    // выполнить закреплённые за вызывающим потоком задачи, не беря обычных: для потока
+    // пула посреди длинной работы (цепочки узлов), который иначе не заглянул бы в очередь
+    void run_pinned();
+
+    // выполняет задачи, пока группа не завершится; потом бросает первое исключение группы
+    void wait(TaskGroup& group);
+
+    // ждёт, пока done() не станет истинным, не выполняя задач: вызывающий поток может быть
+    // посреди ядра, чьи буферы (thread_local) испортила бы чужая задача. Тот, кто делает
+    // done() истинным, вызывает notify_joined
+    void join(const std::function<bool()>& done);
+    void notify_joined();
+};
+
+// число частей, на которые parallel_for разобьёт n элементов (1 — выполнение сразу, без пула;
+// так же внутри части другого разбиения: все потоки уже заняты его частями)
+size_t parallel_parts(size_t n, size_t grain);
+
+// [begin, end) делится на parallel_parts равных непрерывных частей; часть k ставится потоку k
+// текущего пула. Часть, которую её поток ещё не начал (он занят другой работой), выполняет
+// сам вызвавший parallel_for поток после своей части: он ждёт только начатые части, поэтому
+// разбиения из разных задач идут одновременно. Какой поток выполнит часть, не гарантируется.
+// Вне пула — fn(begin, end)
+void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+// начало части k из parts равных частей диапазона длины n
+inline size_t partition_begin(size_t n, size_t parts, size_t k)
+{
+    return n * k / parts;
+}
@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "conv.h"
+#include "gemm.h"
+
+// пороги выбора Winograd (см. choose_conv_algorithm)
+constexpr int64_t WINOGRAD_MIN_CHANNELS = 32;
+constexpr int64_t WINOGRAD_MIN_TILES = 36;
+constexpr int64_t WINOGRAD_MAX_WORKING_SET = int64_t(4) << 20;
+
+bool conv_algorithm_supported(ConvAlgorithm algorithm, const ConvGeometry& g)
+{
+    switch (algorithm)
+    {
+    case ConvAlgorithm::DIRECT:
+    case ConvAlgorithm::IM2COL:
+        return true;
+    case ConvAlgorithm::WINOGRAD:
+        return g.group == 1 && g.kernel_h == 3 && g.kernel_w == 3 && g.stride_h == 1 && g.stride_w == 1 &&
+               g.dilation_h == 1 && g.dilation_w == 1;
+    case ConvAlgorithm::DEPTHWISE:
+        return g.group == g.in_channels;
+    }
+    return false;
+}
+
+ConvAlgorithm choose_conv_algorithm(const ConvGeometry& g)
+{
+    if (g.group > 1 && conv_algorithm_supported(ConvAlgorithm::DEPTHWISE, g))
+    {
+        return ConvAlgorithm::DEPTHWISE;
+    }
+
+    // Winograd выигрывает у im2col (замеры parser_bench conv с готовыми ядрами U), когда:
+    //  - каналов достаточно, чтобы 16 умножений матриц [M, C] x [C, плитки] были плотными;
+    //  - плиток 2x2 не меньше WINOGRAD_MIN_TILES: на 7x7 преобразования входа и выхода
+    //    дороже сэкономленных умножений;
+    //  - преобразованный вход и произведение одного изображения, 16 * плитки * (C + M)
+    //    float, помещаются в кэш — иначе 16 проходов по ним упираются в память
+    const int64_t tiles = ((g.out_h + 1) / 2) * ((g.out_w + 1) / 2);
+    const int64_t working_set = 16 * tiles * (g.in_channels + g.out_channels) * static_cast<int64_t>(sizeof(float));
+    if (conv_algorithm_supported(ConvAlgorithm::WINOGRAD, g) && g.in_channels >= WINOGRAD_MIN_CHANNELS &&
+        g.out_channels >= WINOGRAD_MIN_CHANNELS && tiles >= WINOGRAD_MIN_TILES &&
+        working_set <= WINOGRAD_MAX_WORKING_SET)
+    {
+        return ConvAlgorithm::WINOGRAD;
+    }
+
+    return ConvAlgorithm::IM2COL;
+}
+
+bool conv_may_use_winograd(const Node& node, const std::vector<int64_t>& w_shape)
+{
+    if (w_shape.size() != 4 || w_shape[2] != 3 || w_shape[3] != 3) return false;
+    if (w_shape[0] < WINOGRAD_MIN_CHANNELS || w_shape[1] < WINOGRAD_MIN_CHANNELS) return false;
+    if (node.get_int("group", 1) != 1) return false;
+
+    for (int64_t stride : node.get_ints("strides"))
+    {
+        if (stride != 1) return false;
+    }
+    for (int64_t dilation : node.get_ints("dilations"))
+    {
+        if (dilation != 1) return false;
+    }
+    return true;
+}
+
+const char* conv_algorithm_name(ConvAlgorithm algorithm)
+{
+    switch (algorithm)
+    {
+    case ConvAlgorithm::IM2COL: return "im2col";
+    case ConvAlgorithm::WINOGRAD: return "winograd";
+    case ConvAlgorithm::DEPTHWISE: return "depthwise";
+    default: return "direct";
+    }
+}
+
+// floor(a / b) для b > 0 и любого знака a
+static int64_t floor_div(int64_t a, int64_t b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// выходные позиции o, для которых вход o * stride + shift лежит в [0, in): [begin, end)
+static void valid_range(int64_t out, int64_t in, int64_t stride, int64_t shift, int64_t& begin, int64_t& end)
+{
+    begin = std::max<int64_t>(0, -floor_div(shift, stride));
+    end = std::min<int64_t>(out, floor_div(in - 1 - shift, stride) + 1);
+    if (end < begin) end = begin;
+}
+
+// выход заполняется смещением (или нулями) — дальше алгоритмы только накапливают
+static void fill_bias(const ConvGeometry& g, const float* bias, float* y)
+{
+    const size_t plane = static_cast<size_t>(g.out_h * g.out_w);
+
+    for (int64_t n = 0; n < g.batch; n++)
+    {
+        for (int64_t m = 0; m < g.out_channels; m++)
+        {
+            float* dst = y + (n * g.out_channels + m) * plane;
+            std::fill(dst, dst + plane, bias ? bias[m] : 0.0f);
+        }
+    }
+}
+
+// прямой цикл: эталон для сверки остальных алгоритмов
+static void conv_direct(const ConvGeometry& g, const float* x, const float* w, const float* bias, float* y,
+                        const GemmEpilogue* epilogue)
+{
+    const int64_t in_per_group = g.in_channels / g.group;
+    const int64_t out_per_group = g.out_channels / g.group;
+
+    for (int64_t n = 0; n < g.batch; n++)
+    {
+        for (int64_t m = 0; m < g.out_channels; m++)
+        {
+            int64_t grp = m / out_per_group;
+            float b = bias ? bias[m] : 0.0f;
+
+            for (int64_t oh = 0; oh < g.out_h; oh++)
+            {
+                for (int64_t ow = 0; ow < g.out_w; ow++)
+                {
+                    float sum = b;
+
+                    for (int64_t c = 0; c < in_per_group; c++)
+                    {
+                        int64_t ic = grp * in_per_group + c;
+
+                        for (int64_t kh = 0; kh < g.kernel_h; kh++)
+                        {
+                            int64_t ih = oh * g.stride_h - g.pad_top + kh * g.dilation_h;
+                            if (ih < 0 || ih >= g.in_h) continue;
+
+                            for (int64_t kw = 0; kw < g.kernel_w; kw++)
+                            {
+                                int64_t iw = ow * g.stride_w - g.pad_left + kw * g.dilation_w;
+                                if (iw < 0 || iw >= g.in_w) continue;
+
+                                sum += x[((n * g.in_channels + ic) * g.in_h + ih) * g.in_w + iw] *
+                                       w[((m * in_per_group + c) * g.kernel_h + kh) * g.kernel_w + kw];
+                            }
+                        }
+                    }
+
+                    y[((n * g.out_channels + m) * g.out_h + oh) * g.out_w + ow] = sum;
+                }
+            }
+
+            if (epilogue)
+            {
+                epilogue->apply(epilogue->context, y + (n * g.out_channels + m) * g.out_h * g.out_w,
+                                static_cast<size_t>(g.out_h * g.out_w));
+            }
+        }
+    }
+}
+
+// развёртка окон одной группы: строка (c, kh, kw), столбец (oh, ow); вне входа — нули
+static void im2col(const ConvGeometry& g, int64_t channels, const float* x, float* columns)
+{
+    const int64_t plane = g.out_h * g.out_w;
+
+    for (int64_t c = 0; c < channels; c++)
+    {
+        const float* channel = x + c * g.in_h * g.in_w;
+
+        for (int64_t kh = 0; kh < g.kernel_h; kh++)
+        {
+            for (int64_t kw = 0; kw < g.kernel_w; kw++)
+            {
+                float* row = columns + ((c * g.kernel_h + kh) * g.kernel_w + kw) * plane;
+                int64_t shift_w = kw * g.dilation_w - g.pad_left;
+
+                int64_t ow_begin, ow_end;
+                valid_range(g.out_w, g.in_w, g.stride_w, shift_w, ow_begin, ow_end);
+
+                for (int64_t oh = 0; oh < g.out_h; oh++)
+                {
+                    float* dst = row + oh * g.out_w;
+                    int64_t ih = oh * g.stride_h - g.pad_top + kh * g.dilation_h;
+
+                    if (ih < 0 || ih >= g.in_h)
+                    {
+                        std::fill(dst, dst + g.out_w, 0.0f);
+                        continue;
+                    }
+
+                    const float* src = channel + ih * g.in_w;
+                    std::fill(dst, dst + ow_begin, 0.0f);
+                    for (int64_t ow = ow_begin; ow < ow_end; ow++)
+                    {
+                        dst[ow] = src[ow * g.stride_w + shift_w];
+                    }
+                    std::fill(dst + ow_end, dst + g.out_w, 0.0f);
+                }
+            }
+        }
+    }
+}
+
+// Y_group[M/g, OH*OW] = W_group[M/g, C/g*KH*KW] x columns[C/g*KH*KW, OH*OW]
+static void conv_im2col(const ConvGeometry& g, const float* x, const float* w, const float* bias, float* y,
+                        const GemmEpilogue* epilogue)
+{
+    const int64_t in_per_group = g.in_channels / g.group;
+    const int64_t out_per_group = g.out_channels / g.group;
+    const size_t rows = static_cast<size_t>(in_per_group * g.kernel_h * g.kernel_w);
+    const size_t cols = static_cast<size_t>(g.out_h * g.out_w);
+
+    // свёртка 1x1 без шагов и паддинга: вход уже является матрицей столбцов
+    bool pointwise = g.kernel_h == 1 && g.kernel_w == 1 && g.stride_h == 1 && g.stride_w == 1 &&
+                     g.pad_top == 0 && g.pad_left == 0 && g.pad_bottom == 0 && g.pad_right == 0;
+
+    thread_local std::vector<float> columns;
+    if (!pointwise) columns.resize(rows * cols);
+
+    fill_bias(g, bias, y);
+
+    for (int64_t n = 0; n < g.batch; n++)
+    {
+        for (int64_t grp = 0; grp < g.group; grp++)
+        {
+            const float* xg = x + (n * g.in_channels + grp * in_per_group) * g.in_h * g.in_w;
+            const float* src = xg;
+            if (!pointwise)
+            {
+                im2col(g, in_per_group, xg, columns.data());
+                src = columns.data();
+            }
+
+            sgemm(false, false, static_cast<size_t>(out_per_group), cols, rows, 1.0f,
+                  w + grp * out_per_group * rows, rows, src, cols, 1.0f,
+                  y + (n * g.out_channels + grp * out_per_group) * cols, cols, epilogue);
+        }
+    }
+}
+
+// U = G g G^T для каждого фильтра 3x3: раскладка u[xi][m][c], xi — элемент плитки 4x4
+static void winograd_transform_kernels(const float* w, int64_t filters, int64_t channels, float* u)
+{
+    for (int64_t m = 0; m < filters; m++)
+    {
+        for (int64_t c = 0; c < channels; c++)
+        {
+            const float* k = w + (m * channels + c) * 9;
+
+            // G g: 4x3
+            float gg[4][3];
+            for (int j = 0; j < 3; j++)
+            {
+                gg[0][j] = k[j];
+                gg[1][j] = 0.5f * (k[j] + k[3 + j] + k[6 + j]);
+                gg[2][j] = 0.5f * (k[j] - k[3 + j] + k[6 + j]);
+                gg[3][j] = k[6 + j];
+            }
+
+            // (G g) G^T: 4x4
+            for (int i = 0; i < 4; i++)
+            {
+                float t[4] = {gg[i][0], 0.5f * (gg[i][0] + gg[i][1] + gg[i][2]),
+                              0.5f * (gg[i][0] - gg[i][1] + gg[i][2]), gg[i][2]};
+                for (int j = 0; j < 4; j++)
+                {
+                    u[((i * 4 + j) * filters + m) * channels + c] = t[j];
+                }
+            }
+        }
+    }
+}
+
+std::vector<float> winograd_kernels(const float* w, int64_t filters, int64_t channels)
+{
+    std::vector<float> u(static_cast<size_t>(16 * filters * channels));
+    winograd_transform_kernels(w, filters, channels, u.data());
+    return u;
+}
+
+// Winograd F(2x2, 3x3): выход считается плитками 2x2 по входным окнам 4x4.
+// U = G g G^T (ядро), V = B^T d B (окно), Y = A^T (U . V) A;
+// поэлементное произведение по каналам — 16 умножений матриц [M, C] x [C, плитки].
+// u — готовые ядра из winograd_kernels или nullptr (тогда считаются здесь)
+static void conv_winograd(const ConvGeometry& g, const float* x, const float* w, const float* bias, float* y,
+                          const float* u, const GemmEpilogue* epilogue)
+{
+    const int64_t channels = g.in_channels;
+    const int64_t filters = g.out_channels;
+    const int64_t tiles_h = (g.out_h + 1) / 2;
+    const int64_t tiles_w = (g.out_w + 1) / 2;
+    const int64_t tiles = tiles_h * tiles_w;
+
+    thread_local std::vector<float> kernels, v, product;
+    v.resize(16 * channels * tiles);
+    product.resize(16 * filters * tiles);
+    if (!u)
+    {
+        kernels.resize(16 * filters * channels);
+        winograd_transform_kernels(w, filters, channels, kernels.data());
+        u = kernels.data();
+    }
+
+    for (int64_t n = 0; n < g.batch; n++)
+    {
+        // преобразование входных окон: v[xi][c][tile]
+        for (int64_t c = 0; c < channels; c++)
+        {
+            const float* channel = x + (n * channels + c) * g.in_h * g.in_w;
+
+            for (int64_t th = 0; th < tiles_h; th++)
+            {
+                for (int64_t tw = 0; tw < tiles_w; tw++)
+                {
+                    int64_t ih0 = th * 2 - g.pad_top;
+                    int64_t iw0 = tw * 2 - g.pad_left;
+
+                    float d[4][4];
+                    for (int i = 0; i < 4; i++)
+                    {
+                        int64_t ih = ih0 + i;
+                        for (int j = 0; j < 4; j++)
+                        {
+                            int64_t iw = iw0 + j;
+                            bool inside = ih >= 0 && ih < g.in_h && iw >= 0 && iw < g.in_w;
+                            d[i][j] = inside ? channel[ih * g.in_w + iw] : 0.0f;
+                        }
+                    }
+
+                    // B^T d
+                    float bd[4][4];
+                    for (int j = 0; j < 4; j++)
+                    {
+                        bd[0][j] = d[0][j] - d[2][j];
+                        bd[1][j] = d[1][j] + d[2][j];
+                        bd[2][j] = d[2][j] - d[1][j];
+                        bd[3][j] = d[1][j] - d[3][j];
+                    }
+
+                    // (B^T d) B
+                    int64_t tile = th * tiles_w + tw;
+                    for (int i = 0; i < 4; i++)
+                    {
+                        float t[4] = {bd[i][0] - bd[i][2], bd[i][1] + bd[i][2], bd[i][2] - bd[i][1],
+                                      bd[i][1] - bd[i][3]};
+                        for (int j = 0; j < 4; j++)
+                        {
+                            v[((i * 4 + j) * channels + c) * tiles + tile] = t[j];
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int64_t xi = 0; xi < 16; xi++)
+        {
+            sgemm(false, false, static_cast<size_t>(filters), static_cast<size_t>(tiles),
+                  static_cast<size_t>(channels), 1.0f, u + xi * filters * channels, channels,
+                  v.data() + xi * channels * tiles, tiles, 0.0f, product.data() + xi * filters * tiles, tiles);
+        }
+
+        // обратное преобразование: A^T M A — плитка 2x2, края за выходом отбрасываются
+        for (int64_t m = 0; m < filters; m++)
+        {
+            float* plane = y + (n * filters + m) * g.out_h * g.out_w;
+            float b = bias ? bias[m] : 0.0f;
+
+            for (int64_t th = 0; th < tiles_h; th++)
+            {
+                for (int64_t tw = 0; tw < tiles_w; tw++)
+                {
+                    int64_t tile = th * tiles_w + tw;
+
+                    float p[4][4];
+                    for (int xi = 0; xi < 16; xi++)
+                    {
+                        p[xi / 4][xi % 4] = product[(xi * filters + m) * tiles + tile];
+                    }
+
+                    // A^T p: 2x4
+                    float ap[2][4];
+                    for (int j = 0; j < 4; j++)
+                    {
+                        ap[0][j] = p[0][j] + p[1][j] + p[2][j];
+                        ap[1][j] = p[1][j] - p[2][j] - p[3][j];
+                    }
+
+                    for (int i = 0; i < 2; i++)
+                    {
+                        int64_t oh = th * 2 + i;
+                        if (oh >= g.out_h) break;
+
+                        float out[2] = {ap[i][0] + ap[i][1] + ap[i][2], ap[i][1] - ap[i][2] - ap[i][3]};
+                        for (int j = 0; j < 2; j++)
+                        {
+                            int64_t ow = tw * 2 + j;
+                            if (ow < g.out_w) plane[oh * g.out_w + ow] = out[j] + b;
+                        }
+                    }
+                }
+            }
+
+            if (epilogue) epilogue->apply(epilogue->context, plane, static_cast<size_t>(g.out_h * g.out_w));
+        }
+    }
+}
+
+// один входной канал на группу: каждый выходной канал — 2D-фильтр своего входного канала.
+// Внутренний цикл идёт по строке выхода без проверок границ (диапазон считается заранее)
+static void conv_depthwise(const ConvGeometry& g, const float* x, const float* w, const float* bias, float* y,
+                           const GemmEpilogue* epilogue)
+{
+    const int64_t multiplier = g.out_channels / g.group;
+
+    fill_bias(g, bias, y);
+
+    for (int64_t n = 0; n < g.batch; n++)
+    {
+        for (int64_t m = 0; m < g.out_channels; m++)
+        {
+            const float* channel = x + (n * g.in_channels + m / multiplier) * g.in_h * g.in_w;
+            const float* kernel = w + m * g.kernel_h * g.kernel_w;
+            float* plane = y + (n * g.out_channels + m) * g.out_h * g.out_w;
+
+            for (int64_t oh = 0; oh < g.out_h; oh++)
+            {
+                float* dst = plane + oh * g.out_w;
+
+                for (int64_t kh = 0; kh < g.kernel_h; kh++)
+                {
+                    int64_t ih = oh * g.stride_h - g.pad_top + kh * g.dilation_h;
+                    if (ih < 0 || ih >= g.in_h) continue;
+                    const float* src = channel + ih * g.in_w;
+
+                    for (int64_t kw = 0; kw < g.kernel_w; kw++)
+                    {
+                        float weight = kernel[kh * g.kernel_w + kw];
+                        int64_t shift = kw * g.dilation_w - g.pad_left;
+
+                        int64_t begin, end;
+                        valid_range(g.out_w, g.in_w, g.stride_w, shift, begin, end);
+
+                        if (g.stride_w == 1)
+                        {
+                            for (int64_t ow = begin; ow < end; ow++) dst[ow] += weight * src[ow + shift];
+                        }
+                        else
+                        {
+                            for (int64_t ow = begin; ow < end; ow++) dst[ow] += weight * src[ow * g.stride_w + shift];
+                        }
+                    }
+                }
+            }
+
+            if (epilogue) epilogue->apply(epilogue->context, plane, static_cast<size_t>(g.out_h * g.out_w));
+        }
+    }
+}
+
+void conv2d(ConvAlgorithm algorithm, const ConvGeometry& g, const float* x, const float* w,
+            const float* bias, float* y, const float* winograd_u, const GemmEpilogue* epilogue)
+{
+    if (!conv_algorithm_supported(algorithm, g))
+    {
+        throw std::runtime_error(std::string("Conv: алгоритм ") + conv_algorithm_name(algorithm) +
+                                 " неприменим к этой свёртке");
+    }
+
+    switch (algorithm)
+    {
+    case ConvAlgorithm::DIRECT: conv_direct(g, x, w, bias, y, epilogue); break;
+    case ConvAlgorithm::IM2COL: conv_im2col(g, x, w, bias, y, epilogue); break;
+    case ConvAlgorithm::WINOGRAD: conv_winograd(g, x, w, bias, y, winograd_u, epilogue); break;
+    case ConvAlgorithm::DEPTHWISE: conv_depthwise(g, x, w, bias, y, epilogue); break;
+    }
+}
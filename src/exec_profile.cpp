@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "exec_profile.h"
+#include "gemm.h"
+#include "ops.h"
+#include "thread_pool.h"
+
+// байты значения: FLOAT — 4, INT64 — 8
+static double value_bytes(const Value& value)
+{
+    return static_cast<double>(value.element_count()) * (value.get_data_type() == INT64 ? 8.0 : 4.0);
+}
+
+NodeCost node_cost(const Node& node, const std::vector<const Value*>& inputs, const std::vector<Value>& outputs)
+{
+    NodeCost cost;
+    for (const Value* input : inputs)
+    {
+        if (input) cost.bytes += value_bytes(*input);
+    }
+    for (const Value& output : outputs) cost.bytes += value_bytes(output);
+
+    if (outputs.empty()) return cost;
+    const double out_elements = static_cast<double>(outputs[0].element_count());
+    const std::string& op = node.get_op_type();
+
+    if (op == "Conv" && inputs.size() >= 2 && inputs[0] && inputs[1])
+    {
+        ConvGeometry g = conv_geometry(node, inputs[0]->get_shape(), inputs[1]->get_shape());
+        double macs_per_output = static_cast<double>(g.in_channels / g.group * g.kernel_h * g.kernel_w);
+        cost.flops = 2.0 * out_elements * macs_per_output;
+        if (inputs.size() >= 3 && inputs[2]) cost.flops += out_elements;   // смещение
+    }
+    else if (op == "Gemm" && inputs.size() >= 2 && inputs[0] && inputs[0]->get_shape().size() == 2)
+    {
+        // M · N — элементы выхода, K — общая размерность op(A)
+        bool trans_a = node.get_int("transA", 0) != 0;
+        double k = static_cast<double>(inputs[0]->get_shape()[trans_a ? 0 : 1]);
+        cost.flops = 2.0 * out_elements * k;
+        if (inputs.size() >= 3 && inputs[2] && node.get_float("beta", 1.0f) != 0.0f) cost.flops += 2.0 * out_elements;
+    }
+    else if (op == "MatMul" && inputs.size() >= 2 && inputs[0] && !inputs[0]->get_shape().empty())
+    {
+        cost.flops = 2.0 * out_elements * static_cast<double>(inputs[0]->get_shape().back());
+    }
+    else if (op == "Add" || op == "Mul" || op == "Relu")
+    {
+        cost.flops = out_elements;
+    }
+
+    // слитые эпилоги: операция на элемент. Второй операнд слияние добавило во входы узла,
+    // его байты уже посчитаны выше
+    cost.flops += out_elements * static_cast<double>(node.get_fused().size());
+    return cost;
+}
+
+// повторять fn не меньше min_seconds, лучшее время одного вызова
+template <typename Fn>
+static double best_seconds(Fn&& fn, double min_seconds)
+{
+    using clock = std::chrono::steady_clock;
+
+    fn(); // прогрев
+    double best = 1e30, total = 0.0;
+    while (total < min_seconds)
+    {
+        auto start = clock::now();
+        fn();
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        best = std::min(best, elapsed);
+        total += elapsed;
+    }
+    return best;
+}
+
+// fn(k) одновременно в threads потоках (k = 0 — в вызывающем); возврат — когда закончат все
+template <typename Fn>
+static void run_on_threads(size_t threads, Fn&& fn)
+{
+    std::vector<std::thread> workers;
+    for (size_t k = 1; k < threads; k++) workers.emplace_back([&fn, k]() { fn(k); });
+    fn(0);
+    for (std::thread& worker : workers) worker.join();
+}
+
+MachinePeaks measure_machine_peaks(size_t threads)
+{
+    MachinePeaks peaks;
+    threads = std::max<size_t>(threads, 1);
+
+    // вычисления: в каждом потоке свой sgemm, который целиком помещается в кэш.
+    // Потоки посторонние для пулов, поэтому sgemm в них не делится на части
+    const size_t n = 256;
+    std::vector<std::vector<float>> a(threads), b(threads), c(threads);
+    for (size_t k = 0; k < threads; k++)
+    {
+        a[k].assign(n * n, 1.0f);
+        b[k].assign(n * n, 0.5f);
+        c[k].assign(n * n, 0.0f);
+    }
+    double gemm_seconds = best_seconds([&]() {
+        run_on_threads(threads, [&](size_t k) {
+            sgemm(false, false, n, n, n, 1.0f, a[k].data(), n, b[k].data(), n, 0.0f, c[k].data(), n);
+        });
+    }, 0.05);
+    peaks.gflops = 2.0 * n * n * n * static_cast<double>(threads) / gemm_seconds * 1e-9;
+
+    // память: копирование буфера, много большего кэша (чтение + запись), по части на поток
+    const size_t count = size_t(32) << 20 >> 2;
+    std::vector<float> source(count, 1.0f), target(count, 0.0f);
+    double copy_seconds = best_seconds([&]() {
+        run_on_threads(threads, [&](size_t k) {
+            size_t begin = partition_begin(count, threads, k);
+            size_t end = partition_begin(count, threads, k + 1);
+            std::memcpy(target.data() + begin, source.data() + begin, (end - begin) * sizeof(float));
+        });
+    }, 0.05);
+    peaks.gbytes_per_second = 2.0 * static_cast<double>(count * sizeof(float)) / copy_seconds * 1e-9;
+
+    return peaks;
+}
+
+// итоги группы узлов (узел или тип операции) для строки таблицы
+struct ProfileRow
+{
+    double seconds = 0.0;
+    double flops = 0.0;
+    double bytes = 0.0;
+    size_t nodes = 0;
+};
+
+// достигнутые скорости, интенсивность, ограничение и доля от потолка roofline
+static void print_rates(std::ostream& out, const ProfileRow& row, const MachinePeaks& peaks)
+{
+    double gflops = row.seconds > 0 ? row.flops / row.seconds * 1e-9 : 0.0;
+    double gbytes = row.seconds > 0 ? row.bytes / row.seconds * 1e-9 : 0.0;
+    double intensity = row.bytes > 0 ? row.flops / row.bytes : 0.0;
+    double ridge = peaks.gflops / peaks.gbytes_per_second;
+    bool compute_bound = row.flops > 0 && intensity >= ridge;
+
+    // потолок для этой интенсивности: min(пик вычислений, интенсивность · пик памяти);
+    // у узлов без вычислений — доля от пика памяти
+    double roof = row.flops > 0 ? std::min(peaks.gflops, intensity * peaks.gbytes_per_second) : 0.0;
+    double percent = roof > 0 ? gflops / roof * 100.0 : gbytes / peaks.gbytes_per_second * 100.0;
+
+    out << std::setprecision(2) << std::setw(10) << gflops << std::setw(10) << gbytes << std::setw(9) << intensity
+        << std::setw(9) << (compute_bound ? "compute" : "memory") << std::setprecision(1) << std::setw(7)
+        << percent << "%";
+}
+
+void ExecutionProfile::print(const Graph& graph, std::ostream& out, size_t top_n, const MachinePeaks& peaks) const
+{
+    const std::vector<Node>& graph_nodes = graph.get_nodes();
+
+    // узлы в порядке выполнения: среднее одного запуска
+    std::vector<NodeId> executed;
+    double total_seconds = 0.0;
+    for (NodeId i : graph.topological_order())
+    {
+        if (i >= nodes.size() || nodes[i].runs == 0) continue;
+        executed.push_back(i);
+        total_seconds += nodes[i].seconds / static_cast<double>(nodes[i].runs);
+    }
+
+    auto row_of = [&](NodeId i) {
+        const NodeTiming& timing = nodes[i];
+        double runs = static_cast<double>(timing.runs);
+        ProfileRow row;
+        row.seconds = timing.seconds / runs;
+        row.flops = timing.cost.flops / runs;
+        row.bytes = timing.cost.bytes / runs;
+        row.nodes = 1;
+        return row;
+    };
+    auto label_of = [&](NodeId i) {
+        const std::string& name = graph_nodes[i].get_name();
+        return name.empty() ? "#" + std::to_string(i) : name;
+    };
+    auto share = [&](double seconds) { return total_seconds > 0 ? seconds / total_seconds * 100.0 : 0.0; };
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed;
+
+    out << "=== Node profile: " << executed.size() << " nodes, " << std::setprecision(3) << total_seconds * 1e3
+        << " ms ===\n"
+        << "peaks (1 thread): " << std::setprecision(1) << peaks.gflops << " GFLOP/s sgemm, "
+        << peaks.gbytes_per_second << " GB/s copy; ridge " << std::setprecision(2)
+        << peaks.gflops / peaks.gbytes_per_second << " FLOP/B\n";
+
+    const char* rate_header = "   GFLOP/s      GB/s   FLOP/B    bound   roof\n";
+    out << std::left << std::setw(28) << "node" << std::setw(14) << "op" << std::right << std::setw(10) << "ms"
+        << std::setw(10) << "MFLOP" << std::setw(10) << "KiB" << rate_header;
+    for (NodeId i : executed)
+    {
+        ProfileRow row = row_of(i);
+        out << std::left << std::setw(28) << label_of(i) << std::setw(14) << graph_nodes[i].display_type()
+            << std::right << std::setprecision(3) << std::setw(10) << row.seconds * 1e3 << std::setprecision(2)
+            << std::setw(10) << row.flops * 1e-6 << std::setw(10) << row.bytes / 1024;
+        print_rates(out, row, peaks);
+        out << "\n";
+    }
+
+    // по типам операций (слитые — отдельным типом: "Conv+Relu")
+    std::map<std::string, ProfileRow> by_type;
+    for (NodeId i : executed)
+    {
+        ProfileRow node_row = row_of(i);
+        ProfileRow& row = by_type[graph_nodes[i].display_type()];
+        row.seconds += node_row.seconds;
+        row.flops += node_row.flops;
+        row.bytes += node_row.bytes;
+        row.nodes++;
+    }
+
+    out << "\n=== By op type ===\n"
+        << std::left << std::setw(14) << "op" << std::right << std::setw(7) << "nodes" << std::setw(10) << "ms"
+        << std::setw(8) << "time" << rate_header;
+    for (const auto& [op_type, row] : by_type)
+    {
+        out << std::left << std::setw(14) << op_type << std::right << std::setw(7) << row.nodes
+            << std::setprecision(3) << std::setw(10) << row.seconds * 1e3 << std::setprecision(1) << std::setw(7)
+            << share(row.seconds) << "%";
+        print_rates(out, row, peaks);
+        out << "\n";
+    }
+
+    // самые медленные узлы
+    std::vector<NodeId> slowest = executed;
+    std::stable_sort(slowest.begin(), slowest.end(), [&](NodeId a, NodeId b) {
+        return nodes[a].seconds / static_cast<double>(nodes[a].runs) >
+               nodes[b].seconds / static_cast<double>(nodes[b].runs);
+    });
+    slowest.resize(std::min(top_n, slowest.size()));
+
+    out << "\n=== Top " << slowest.size() << " slowest nodes ===\n"
+        << "     " << std::left << std::setw(28) << "node" << std::setw(14) << "op" << std::right << std::setw(13)
+        << "ms" << std::setw(8) << "time" << rate_header;
+    for (size_t rank = 0; rank < slowest.size(); rank++)
+    {
+        NodeId i = slowest[rank];
+        ProfileRow row = row_of(i);
+        out << std::right << std::setw(3) << rank + 1 << ". " << std::left << std::setw(28) << label_of(i)
+            << std::setw(14) << graph_nodes[i].display_type() << std::right << std::setprecision(3)
+            << std::setw(10) << row.seconds * 1e3 << " ms" << std::setprecision(1) << std::setw(7)
+            << share(row.seconds) << "%";
+        print_rates(out, row, peaks);
+        out << "\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,402 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "conv.h"
+#include "exec_profile.h"
+#include "executor.h"
+#include "ops.h"
+
+size_t shape_size(const std::vector<int64_t>& shape)
+{
+    size_t count = 1;
+    for (int64_t dim : shape)
+    {
+        if (dim < 0) throw std::runtime_error("Отрицательная размерность тензора");
+        count *= static_cast<size_t>(dim);
+    }
+    return count;
+}
+
+// целые элементы тензора, расширенные до int64
+template <typename T>
+static std::vector<int64_t> widen_ints(const Tensor& tensor)
+{
+    Span<T> values = tensor.as_span<T>();
+    return std::vector<int64_t>(values.begin(), values.end());
+}
+
+Value Value::from_tensor(const Tensor& tensor)
+{
+    const std::vector<int64_t>& dims = tensor.get_dims();
+    size_t count = shape_size(dims);
+
+    // размер элемента по типу данных
+    size_t element_size = data_type_size(tensor.get_data_type());
+    if (element_size == 0)
+    {
+        throw std::runtime_error("Инициализатор " + tensor.get_name() + ": неподдерживаемый тип данных " +
+                                 std::to_string(tensor.get_data_type()));
+    }
+
+    if (tensor.raw_size() == 0 && count != 0 && !tensor.get_external_location().empty())
+    {
+        throw std::runtime_error("Инициализатор " + tensor.get_name() + ": не найден файл внешних данных " +
+                                 tensor.get_external_location());
+    }
+    if (tensor.raw_size() != count * element_size)
+    {
+        throw std::runtime_error("Инициализатор " + tensor.get_name() + ": нет данных или размер не совпадает с формой");
+    }
+
+    // вещественные (в т.ч. FLOAT16/BFLOAT16/DOUBLE) исполнитель считает во float,
+    // целые и BOOL — в int64
+    switch (tensor.get_data_type())
+    {
+    case FLOAT:
+    case FLOAT16:
+    case BFLOAT16:
+    case DOUBLE: return Value(dims, tensor.to_floats());
+    case INT64: return Value::of_ints(dims, widen_ints<int64_t>(tensor));
+    case UINT64: return Value::of_ints(dims, widen_ints<uint64_t>(tensor));
+    case INT32: return Value::of_ints(dims, widen_ints<int32_t>(tensor));
+    case UINT32: return Value::of_ints(dims, widen_ints<uint32_t>(tensor));
+    case INT16: return Value::of_ints(dims, widen_ints<int16_t>(tensor));
+    case UINT16: return Value::of_ints(dims, widen_ints<uint16_t>(tensor));
+    case INT8: return Value::of_ints(dims, widen_ints<int8_t>(tensor));
+    default: return Value::of_ints(dims, widen_ints<uint8_t>(tensor)); // UINT8, BOOL
+    }
+}
+
+Tensor Value::to_tensor(std::string name) const
+{
+    Tensor tensor;
+    tensor.set_name(std::move(name));
+    tensor.set_data_type(data_type);
+    for (int64_t dim : shape) tensor.add_dim(dim);
+
+    const uint8_t* bytes = data_type == INT64 ? reinterpret_cast<const uint8_t*>(ints.data())
+                                              : reinterpret_cast<const uint8_t*>(data());
+    size_t size = element_count() * (data_type == INT64 ? sizeof(int64_t) : sizeof(float));
+    tensor.set_raw_data(std::vector<uint8_t>(bytes, bytes + size));
+    return tensor;
+}
+
+Executor::Executor(const Graph& graph) : graph(graph)
+{
+    const size_t tensor_count = graph.tensor_count();
+    weights.resize(tensor_count);
+    has_weight.assign(tensor_count, false);
+
+    // float-веса не копируются: ядра только читают их, поэтому значение — представление
+    // прямо над данными инициализатора (буфер файла или raw_data). Остальные типы
+    // преобразуются один раз, при создании исполнителя
+    for (const auto& [id, tensor] : graph.get_initializers())
+    {
+        if (tensor.get_data_type() == FLOAT && tensor.raw_size() == shape_size(tensor.get_dims()) * sizeof(float))
+        {
+            Span<float> data = tensor.as_span<float>();
+            weights[id] = Value::const_view(data.data(), tensor.get_dims());
+        }
+        else
+        {
+            weights[id] = Value::from_tensor(tensor);
+        }
+        has_weight[id] = true;
+    }
+
+    const std::vector<Node>& nodes = graph.get_nodes();
+    kernels.resize(nodes.size());
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        // узлы без типа (мусор после битых полей) пропускаем, как и при выводе
+        if (nodes[i].get_op_type().empty()) continue;
+
+        kernels[i] = find_kernel(nodes[i].get_op_type());
+        if (!kernels[i])
+        {
+            throw std::runtime_error("Операция не поддерживается: " + nodes[i].get_op_type());
+        }
+
+        // ядра Winograd весов Conv не зависят от входа: считаются один раз, а не в каждом run()
+        const std::vector<TensorId>& inputs = nodes[i].get_inputs();
+        if (nodes[i].get_op_type() != "Conv" || inputs.size() < 2 || inputs[1] == NO_TENSOR) continue;
+
+        Value& w = weights[inputs[1]];
+        if (has_weight[inputs[1]] && w.get_data_type() == FLOAT && !w.winograd_data() &&
+            conv_may_use_winograd(nodes[i], w.get_shape()))
+        {
+            // веса только читаются (у весов из файла изменяемый data() бросает исключение)
+            const float* w_data = std::as_const(w).data();
+            w.set_winograd_data(winograd_kernels(w_data, w.get_shape()[0], w.get_shape()[1]));
+        }
+    }
+
+    // порядок выполнения (и проверка на циклы) — заранее
+    graph.topological_order();
+}
+
+void Executor::use_memory_plan(const MemoryPlan& plan)
+{
+    const size_t tensor_count = graph.tensor_count();
+    arena_offsets.assign(tensor_count, SIZE_MAX);
+    arena_sizes.assign(tensor_count, 0);
+
+    for (const BufferAssignment& buffer : plan.buffers)
+    {
+        arena_offsets[buffer.tensor] = buffer.offset / sizeof(float);
+        arena_sizes[buffer.tensor] = buffer.size / sizeof(float);
+    }
+
+    // запас на выравнивание начала арены
+    arena.assign(plan.arena_size / sizeof(float) + ARENA_ALIGNMENT / sizeof(float), 0.0f);
+}
+
+void Executor::set_threads(size_t threads, bool pin_threads)
+{
+    if (threads <= 1)
+    {
+        pool.reset();
+        return;
+    }
+
+    pool = std::make_unique<ThreadPool>(threads, pin_threads);
+    if (pin_threads) first_touch_weights();
+
+    // число узлов-предшественников: узел готов, когда все они выполнены
+    const std::vector<Node>& nodes = graph.get_nodes();
+    dependency_counts.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        dependency_counts[i] = static_cast<uint32_t>(graph.predecessors(static_cast<NodeId>(i)).size());
+    }
+}
+
+void Executor::set_profile(ExecutionProfile* execution_profile)
+{
+    profile = execution_profile;
+    if (profile) profile->reset(graph.get_nodes().size());
+}
+
+void Executor::first_touch_weights()
+{
+    // новая память не инициализируется: страницы выделит ОС при первой записи
+    const size_t align = ARENA_ALIGNMENT / sizeof(float);
+    std::vector<size_t> offsets(weights.size(), SIZE_MAX);
+    size_t total = 0;
+
+    for (size_t id = 0; id < weights.size(); id++)
+    {
+        if (!has_weight[id] || weights[id].get_data_type() != FLOAT || weights[id].element_count() == 0) continue;
+        offsets[id] = total;
+        total += (weights[id].element_count() + align - 1) / align * align;
+    }
+    if (total == 0) return;
+
+    std::unique_ptr<float[]> memory(new float[total + align]);
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory.get());
+    float* base = memory.get() + ((ARENA_ALIGNMENT - address % ARENA_ALIGNMENT) % ARENA_ALIGNMENT) / sizeof(float);
+
+    // часть k каждого веса (по первой оси) копирует поток k: страницы расходятся по узлам
+    const size_t parts = pool->size();
+    TaskGroup group;
+    for (size_t k = 0; k < parts; k++)
+    {
+        pool->submit_to(k, group, [&, k]() {
+            for (size_t id = 0; id < weights.size(); id++)
+            {
+                if (offsets[id] == SIZE_MAX) continue;
+
+                const Value& weight = weights[id];
+                size_t rows = weight.get_shape().empty() ? 1 : static_cast<size_t>(weight.get_shape()[0]);
+                size_t row_size = weight.element_count() / std::max<size_t>(rows, 1);
+                size_t begin = partition_begin(rows, parts, k) * row_size;
+                size_t end = partition_begin(rows, parts, k + 1) * row_size;
+                std::copy(weight.data() + begin, weight.data() + end, base + offsets[id] + begin);
+            }
+        });
+    }
+    pool->wait(group);
+
+    for (size_t id = 0; id < weights.size(); id++)
+    {
+        if (offsets[id] == SIZE_MAX) continue;
+        Value moved = Value::view(base + offsets[id], weights[id].get_shape());
+        moved.share_winograd_data(weights[id]);
+        weights[id] = std::move(moved);
+    }
+    weight_memory = std::move(memory);
+}
+
+void Executor::run_node(NodeId i, RunState& state, std::vector<const Value*>& node_inputs,
+                        std::vector<Value>& node_outputs) const
+{
+    const Node& node = graph.get_nodes()[i];
+    if (!kernels[i]) return;
+
+    node_inputs.clear();
+    for (TensorId in : node.get_inputs())
+    {
+        if (in != NO_TENSOR && state.slots[in] == nullptr)
+        {
+            throw std::runtime_error(node.get_op_type() + ": нет значения для входа " + graph.tensor_name(in));
+        }
+        node_inputs.push_back(in == NO_TENSOR ? nullptr : state.slots[in]);
+    }
+
+    node_outputs.assign(node.get_outputs().size(), Value());
+    if (state.arena_base)
+    {
+        for (size_t k = 0; k < node_outputs.size(); k++)
+        {
+            TensorId out = node.get_outputs()[k];
+            if (out == NO_TENSOR || arena_offsets[out] == SIZE_MAX) continue;
+            node_outputs[k] = Value::arena_slot(state.arena_base + arena_offsets[out], arena_sizes[out]);
+        }
+    }
+    auto start = profile ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    // эпилоги слитых узлов ядро применяет само — к готовым плиткам выхода (см. apply_fused_op)
+    kernels[i](node, node_inputs, node_outputs);
+
+    if (profile)
+    {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        profile->record(i, seconds, node_cost(node, node_inputs, node_outputs));
+    }
+
+    for (size_t k = 0; k < node_outputs.size(); k++)
+    {
+        TensorId out = node.get_outputs()[k];
+        if (out == NO_TENSOR) continue;
+
+        state.activations[out] = std::move(node_outputs[k]);
+        state.slots[out] = &state.activations[out];
+    }
+}
+
+void Executor::run_parallel(RunState& state) const
+{
+    const std::vector<Node>& nodes = graph.get_nodes();
+
+    // счётчики невыполненных предшественников; уменьшает их тот, кто выполнил предшественника
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining(new std::atomic<uint32_t>[nodes.size()]);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        remaining[i].store(dependency_counts[i], std::memory_order_relaxed);
+    }
+
+    TaskGroup group;
+    std::function<void(NodeId)> schedule = [&](NodeId first) {
+        pool->submit(group, [&, first]() {
+            std::vector<const Value*> node_inputs;
+            std::vector<Value> node_outputs;
+            NodeId current = first;
+
+            // цепочка выполняется в этом же потоке: первый готовый последователь — сразу,
+            // остальные — в очередь, откуда их могут украсть свободные потоки
+            while (current != NO_NODE && !group.failed())
+            {
+                run_node(current, state, node_inputs, node_outputs);
+
+                // части parallel_for, закреплённые за этим потоком, не ждут конца цепочки:
+                // иначе их выполнит владелец разбиения, и работа не разделится
+                pool->run_pinned();
+
+                NodeId next_inline = NO_NODE;
+                for (NodeId next : graph.successors(current))
+                {
+                    // acq_rel: выходы current видны тому, кто выполнит next
+                    if (remaining[next].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+
+                    if (next_inline == NO_NODE) next_inline = next;
+                    else schedule(next);
+                }
+                current = next_inline;
+            }
+        });
+    };
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (dependency_counts[i] == 0) schedule(static_cast<NodeId>(i));
+    }
+
+    pool->wait(group);
+}
+
+std::unordered_map<std::string, Value> Executor::run(const std::unordered_map<std::string, Value>& inputs) const
+{
+    const size_t tensor_count = graph.tensor_count();
+    const std::vector<Node>& nodes = graph.get_nodes();
+
+    // TensorId → значение: веса, входы (без копирования) или результаты узлов
+    RunState state;
+    state.slots.assign(tensor_count, nullptr);
+    state.activations.resize(tensor_count);
+
+    for (size_t id = 0; id < tensor_count; id++)
+    {
+        if (has_weight[id]) state.slots[id] = &weights[id];
+    }
+
+    for (const auto& [name, value] : inputs)
+    {
+        TensorId id = graph.find_tensor(name);
+        if (id == NO_TENSOR) throw std::runtime_error("В графе нет входа " + name);
+        state.slots[id] = &value;
+    }
+
+    // начало арены, выровненное как смещения в плане. План рассчитан на
+    // последовательный порядок, поэтому параллельно узлы пишут в свою память
+    if (!arena.empty() && !pool)
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(arena.data());
+        uintptr_t aligned = (address + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+        state.arena_base = arena.data() + (aligned - address) / sizeof(float);
+    }
+
+    if (pool)
+    {
+        run_parallel(state);
+    }
+    else
+    {
+        std::vector<const Value*> node_inputs;
+        std::vector<Value> node_outputs;
+        for (NodeId i : graph.topological_order())
+        {
+            run_node(i, state, node_inputs, node_outputs);
+        }
+    }
+
+    // выходы графа; если они не разобраны — тензоры, которые никто не читает
+    std::vector<TensorId> result_ids = graph.get_outputs();
+    if (result_ids.empty())
+    {
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            if (!kernels[i]) continue;
+            for (TensorId out : nodes[i].get_outputs())
+            {
+                if (out != NO_TENSOR && graph.consumers_of(out).empty()) result_ids.push_back(out);
+            }
+        }
+    }
+
+    std::unordered_map<std::string, Value> results;
+    for (TensorId id : result_ids)
+    {
+        if (state.slots[id] == nullptr) throw std::runtime_error("Выход не вычислен: " + graph.tensor_name(id));
+        results.emplace(graph.tensor_name(id), *state.slots[id]);
+    }
+
+    return results;
+}
@@ -0,0 +1,128 @@
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "executor.h"
+#include "ops.h"
+
+size_t fold_constants(Graph& graph, const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes)
+{
+    const std::vector<Node>& nodes = graph.get_nodes();
+    const size_t tensor_count = graph.tensor_count();
+
+    // известные формы входов графа (для Shape)
+    std::vector<const std::vector<int64_t>*> known_shapes(tensor_count, nullptr);
+    for (const auto& [name, shape] : input_shapes)
+    {
+        TensorId id = graph.find_tensor(name);
+        if (id != NO_TENSOR) known_shapes[id] = &shape;
+    }
+
+    // выходы графа остаются выходами узлов; если список выходов не разобран — выходом
+    // считается тензор, который никто не читает (как в Executor::run)
+    std::vector<bool> graph_output(tensor_count, false);
+    for (TensorId out : graph.get_outputs()) graph_output[out] = true;
+    const bool outputs_unknown = graph.get_outputs().empty();
+
+    // в моделях IR < 4 веса перечислены и среди входов графа: такие инициализаторы не удаляем,
+    // иначе вход станет обязательным при выполнении
+    std::vector<bool> graph_input(tensor_count, false);
+    for (TensorId in : graph.get_inputs()) graph_input[in] = true;
+
+    std::vector<bool> removed(nodes.size(), false);
+    std::vector<TensorId> folded_inputs; // кандидаты на удаление после свёртки
+    size_t folded = 0;
+
+    // в топологическом порядке: результат свёртки сразу виден следующим узлам
+    const std::vector<NodeId> order = graph.topological_order();
+
+    for (NodeId i : order)
+    {
+        const Node& node = nodes[i];
+        if (node.get_op_type().empty()) continue;
+
+        OpKernel kernel = find_kernel(node.get_op_type());
+        if (!kernel) continue;
+
+        bool terminal = false;
+        for (TensorId out : node.get_outputs())
+        {
+            if (out == NO_TENSOR) continue;
+            if (graph_output[out] || (outputs_unknown && graph.consumers_of(out).empty())) terminal = true;
+        }
+        if (terminal) continue;
+
+        std::vector<Value> outputs(node.get_outputs().size());
+        const std::vector<TensorId>& inputs = node.get_inputs();
+
+        if (node.get_op_type() == "Shape" && !inputs.empty() && inputs[0] != NO_TENSOR &&
+            known_shapes[inputs[0]] != nullptr)
+        {
+            // Shape от входа с известной формой — данные входа не нужны
+            std::vector<int64_t> dims = shape_slice(node, *known_shapes[inputs[0]]);
+            int64_t count = static_cast<int64_t>(dims.size());
+            outputs[0] = Value::of_ints({count}, std::move(dims));
+        }
+        else
+        {
+            bool constant = true;
+            for (TensorId in : inputs)
+            {
+                if (in != NO_TENSOR && graph.find_initializer(in) == nullptr) constant = false;
+            }
+            if (!constant) continue;
+
+            // веса без данных (внешний файл) или неподдерживаемого типа — узел остаётся как есть
+            std::vector<Value> values(inputs.size());
+            std::vector<const Value*> pointers(inputs.size(), nullptr);
+            // так же, если ядро отвергает константные входы (например, несовместимая форма Reshape)
+            try
+            {
+                for (size_t k = 0; k < inputs.size(); k++)
+                {
+                    if (inputs[k] == NO_TENSOR) continue;
+                    values[k] = Value::from_tensor(*graph.find_initializer(inputs[k]));
+                    pointers[k] = &values[k];
+                }
+
+                kernel(node, pointers, outputs);   // со слитыми эпилогами узла
+            }
+            catch (const std::runtime_error&)
+            {
+                continue;
+            }
+        }
+
+        // выходы, которые никто не читает (необязательные выходы узла), не становятся весами
+        for (size_t k = 0; k < outputs.size(); k++)
+        {
+            TensorId out = node.get_outputs()[k];
+            if (out == NO_TENSOR || graph.consumers_of(out).empty()) continue;
+            graph.add_tensor(outputs[k].to_tensor(graph.tensor_name(out)));
+        }
+
+        for (TensorId in : inputs)
+        {
+            if (in != NO_TENSOR) folded_inputs.push_back(in);
+        }
+
+        removed[i] = true;
+        folded++;
+    }
+
+    if (folded == 0) return 0;
+    graph.remove_nodes(removed);
+
+    // инициализаторы, которые читали только свёрнутые узлы, больше не нужны
+    for (TensorId in : folded_inputs)
+    {
+        if (graph.consumers_of(in).empty() && graph.find_initializer(in) != nullptr && !graph_output[in] &&
+            !graph_input[in])
+        {
+            graph.remove_initializer(in);
+        }
+    }
+
+    return folded;
+}
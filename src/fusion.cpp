@@ -0,0 +1,86 @@
+#include <string>
+#include <vector>
+
+#include "parser.h"
+
+// узлы, к которым можно прицепить эпилог, и число их собственных входов
+// (второй операнд эпилога кладётся после них, чтобы не занять место
+// необязательного входа вроде C у Gemm или B у Conv)
+static size_t anchor_arity(const std::string& op_type)
+{
+    if (op_type == "Conv" || op_type == "Gemm") return 3;
+    if (op_type == "MatMul") return 2;
+    return 0;
+}
+
+static bool is_epilogue(const std::string& op_type)
+{
+    return op_type == "Relu" || op_type == "Add" || op_type == "Mul";
+}
+
+size_t Graph::fuse_epilogues()
+{
+    const GraphIndex& graph_index = get_index();
+    std::vector<bool> removed(nodes.size(), false);
+
+    // выходы графа должны остаться выходами какого-то узла — их не поглощаем
+    std::vector<bool> is_output(tensor_names.size(), false);
+    for (TensorId out : outputs) is_output[out] = true;
+
+    size_t fused_count = 0;
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        Node& anchor = nodes[i];
+        size_t arity = anchor_arity(anchor.get_op_type());
+        if (arity == 0 || removed[i]) continue;
+
+        // цепочка Conv → Relu → Mul → Add сливается целиком: после каждого шага
+        // выход узла — выход поглощённой операции, и проверка повторяется
+        while (anchor.get_outputs().size() == 1)
+        {
+            TensorId out = anchor.get_outputs()[0];
+            if (out == NO_TENSOR || is_output[out]) break;
+
+            // индекс построен до слияний, но потребители тензоров при слиянии не меняются:
+            // поглощённый узел исчезает вместе со своими входами
+            Span<NodeId> consumers = graph_index.consumers_of(out);
+            if (consumers.size() != 1) break;
+
+            NodeId next_id = consumers[0];
+            Node& next = nodes[next_id];
+            if (removed[next_id] || !is_epilogue(next.get_op_type()) || next.get_outputs().size() != 1) break;
+
+            FusedOp op;
+            op.op_type = next.get_op_type();
+            op.name = next.get_name();
+
+            if (op.op_type == "Relu")
+            {
+                if (next.get_inputs().size() != 1) break;
+            }
+            else
+            {
+                // Add/Mul коммутативны: второй операнд — тот вход, что не является нашим выходом
+                const std::vector<TensorId>& next_inputs = next.get_inputs();
+                if (next_inputs.size() != 2 || next_inputs[0] == next_inputs[1]) break;
+                TensorId operand = next_inputs[0] == out ? next_inputs[1] : next_inputs[0];
+
+                // NO_TENSOR на месте пропущенных необязательных входов, дальше — операнд
+                while (anchor.get_inputs().size() < arity) anchor.add_input(NO_TENSOR);
+                op.operand = static_cast<int32_t>(anchor.get_inputs().size());
+                anchor.add_input(operand);
+            }
+
+            // выход поглощённого узла становится выходом узла-производителя
+            anchor.add_fused(std::move(op));
+            anchor.set_output(0, next.get_outputs()[0]);
+
+            removed[next_id] = true;
+            fused_count++;
+        }
+    }
+
+    if (fused_count != 0) remove_nodes(removed);
+    return fused_count;
+}
@@ -0,0 +1,591 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gemm.h"
+#include "thread_pool.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GEMM_HAS_X86_KERNELS 1
+#endif
+
+// Блочное умножение по схеме GotoBLAS/BLIS:
+//   jc (NC столбцов) → pc (KC по K, панель B в L3) → ic (MC строк, блок A в L2)
+//   → микроядро MR x NR, аккумуляторы в регистрах.
+// Блоки A и B перед умножением упаковываются в непрерывные панели,
+// поэтому микроядро читает память строго последовательно при любых transA/transB.
+static const size_t MC = 96;    // кратно MR всех бэкендов
+static const size_t KC = 256;
+static const size_t NC = 1024;  // кратно NR всех бэкендов
+
+static const size_t MAX_MR = 6;
+static const size_t MAX_NR = 32;
+
+// ядра одного бэкенда
+struct GemmKernels
+{
+    size_t mr, nr;
+
+    // C[MR x NR] = A_panel * B_panel (+ beta * C, если beta != 0)
+    void (*micro)(size_t kc, const float* a, const float* b, float* c, size_t ldc, float beta);
+
+    // скалярное произведение и y += alpha * x — для умножения вектора на матрицу (M == 1)
+    float (*dot)(size_t n, const float* x, const float* y);
+    void (*axpy)(size_t n, float alpha, const float* x, float* y);
+};
+
+// === SCALAR: переносимый C++, компилятор сам векторизует циклы по NR ===
+
+static void micro_scalar(size_t kc, const float* a, const float* b, float* c, size_t ldc, float beta)
+{
+    float acc[4][8] = {};
+
+    for (size_t p = 0; p < kc; p++)
+    {
+        for (size_t r = 0; r < 4; r++)
+        {
+            for (size_t j = 0; j < 8; j++)
+            {
+                acc[r][j] += a[r] * b[j];
+            }
+        }
+        a += 4;
+        b += 8;
+    }
+
+    for (size_t r = 0; r < 4; r++)
+    {
+        float* row = c + r * ldc;
+        for (size_t j = 0; j < 8; j++)
+        {
+            row[j] = beta != 0.0f ? acc[r][j] + beta * row[j] : acc[r][j];
+        }
+    }
+}
+
+static float dot_scalar(size_t n, const float* x, const float* y)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) sum += x[i] * y[i];
+    return sum;
+}
+
+static void axpy_scalar(size_t n, float alpha, const float* x, float* y)
+{
+    for (size_t i = 0; i < n; i++) y[i] += alpha * x[i];
+}
+
+static const GemmKernels SCALAR_KERNELS = {4, 8, micro_scalar, dot_scalar, axpy_scalar};
+
+#ifdef GEMM_HAS_X86_KERNELS
+
+// === AVX2 + FMA: 6 строк x 16 столбцов = 12 аккумуляторов ymm ===
+
+__attribute__((target("avx2,fma")))
+static void micro_avx2(size_t kc, const float* a, const float* b, float* c, size_t ldc, float beta)
+{
+    __m256 acc[6][2];
+    for (size_t r = 0; r < 6; r++)
+    {
+        acc[r][0] = _mm256_setzero_ps();
+        acc[r][1] = _mm256_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; p++)
+    {
+        __m256 b0 = _mm256_loadu_ps(b);
+        __m256 b1 = _mm256_loadu_ps(b + 8);
+
+        for (size_t r = 0; r < 6; r++)
+        {
+            __m256 av = _mm256_broadcast_ss(a + r);
+            acc[r][0] = _mm256_fmadd_ps(av, b0, acc[r][0]);
+            acc[r][1] = _mm256_fmadd_ps(av, b1, acc[r][1]);
+        }
+        a += 6;
+        b += 16;
+    }
+
+    __m256 vbeta = _mm256_set1_ps(beta);
+    for (size_t r = 0; r < 6; r++)
+    {
+        float* row = c + r * ldc;
+        if (beta != 0.0f)
+        {
+            acc[r][0] = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(row), acc[r][0]);
+            acc[r][1] = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(row + 8), acc[r][1]);
+        }
+        _mm256_storeu_ps(row, acc[r][0]);
+        _mm256_storeu_ps(row + 8, acc[r][1]);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static float dot_avx2(size_t n, const float* x, const float* y)
+{
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), s1);
+    }
+    for (; i + 8 <= n; i += 8)
+    {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), s0);
+    }
+
+    // горизонтальная сумма 8 полос
+    __m256 s = _mm256_add_ps(s0, s1);
+    __m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+    h = _mm_add_ss(h, _mm_movehdup_ps(h));
+    float sum = _mm_cvtss_f32(h);
+
+    for (; i < n; i++) sum += x[i] * y[i];
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+static void axpy_avx2(size_t n, float alpha, const float* x, float* y)
+{
+    __m256 va = _mm256_set1_ps(alpha);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; i++) y[i] += alpha * x[i];
+}
+
+static const GemmKernels AVX2_KERNELS = {6, 16, micro_avx2, dot_avx2, axpy_avx2};
+
+// === AVX-512F: 6 строк x 32 столбца = 12 аккумуляторов zmm ===
+
+__attribute__((target("avx512f")))
+static void micro_avx512(size_t kc, const float* a, const float* b, float* c, size_t ldc, float beta)
+{
+    __m512 acc[6][2];
+    for (size_t r = 0; r < 6; r++)
+    {
+        acc[r][0] = _mm512_setzero_ps();
+        acc[r][1] = _mm512_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; p++)
+    {
+        __m512 b0 = _mm512_loadu_ps(b);
+        __m512 b1 = _mm512_loadu_ps(b + 16);
+
+        for (size_t r = 0; r < 6; r++)
+        {
+            __m512 av = _mm512_set1_ps(a[r]);
+            acc[r][0] = _mm512_fmadd_ps(av, b0, acc[r][0]);
+            acc[r][1] = _mm512_fmadd_ps(av, b1, acc[r][1]);
+        }
+        a += 6;
+        b += 32;
+    }
+
+    __m512 vbeta = _mm512_set1_ps(beta);
+    for (size_t r = 0; r < 6; r++)
+    {
+        float* row = c + r * ldc;
+        if (beta != 0.0f)
+        {
+            acc[r][0] = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(row), acc[r][0]);
+            acc[r][1] = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(row + 16), acc[r][1]);
+        }
+        _mm512_storeu_ps(row, acc[r][0]);
+        _mm512_storeu_ps(row + 16, acc[r][1]);
+    }
+}
+
+__attribute__((target("avx512f")))
+static float dot_avx512(size_t n, const float* x, const float* y)
+{
+    __m512 s0 = _mm512_setzero_ps();
+    __m512 s1 = _mm512_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        s0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), s0);
+        s1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), s1);
+    }
+
+    // хвост — маской, без скалярного цикла
+    if (i < n)
+    {
+        size_t rest = std::min<size_t>(n - i, 16);
+        __mmask16 mask = static_cast<__mmask16>((1u << rest) - 1);
+        s0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), s0);
+        i += rest;
+    }
+    if (i < n)
+    {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i), s1);
+    }
+
+    return _mm512_reduce_add_ps(_mm512_add_ps(s0, s1));
+}
+
+__attribute__((target("avx512f")))
+static void axpy_avx512(size_t n, float alpha, const float* x, float* y)
+{
+    __m512 va = _mm512_set1_ps(alpha);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+    }
+    if (i < n)
+    {
+        __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __m512 vy = _mm512_maskz_loadu_ps(mask, y + i);
+        _mm512_mask_storeu_ps(y + i, mask, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(mask, x + i), vy));
+    }
+}
+
+static const GemmKernels AVX512_KERNELS = {6, 32, micro_avx512, dot_avx512, axpy_avx512};
+
+#endif // GEMM_HAS_X86_KERNELS
+
+bool gemm_backend_available(GemmBackend backend)
+{
+    switch (backend)
+    {
+    case GemmBackend::SCALAR:
+        return true;
+#ifdef GEMM_HAS_X86_KERNELS
+    case GemmBackend::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case GemmBackend::AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+GemmBackend gemm_backend()
+{
+    static const GemmBackend best = []() {
+        if (gemm_backend_available(GemmBackend::AVX512)) return GemmBackend::AVX512;
+        if (gemm_backend_available(GemmBackend::AVX2)) return GemmBackend::AVX2;
+        return GemmBackend::SCALAR;
+    }();
+    return best;
+}
+
+const char* gemm_backend_name(GemmBackend backend)
+{
+    switch (backend)
+    {
+    case GemmBackend::AVX2: return "avx2";
+    case GemmBackend::AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+static const GemmKernels& kernels_for(GemmBackend backend)
+{
+    if (!gemm_backend_available(backend))
+    {
+        throw std::runtime_error(std::string("GEMM: бэкенд ") + gemm_backend_name(backend) +
+                                 " не поддерживается процессором");
+    }
+
+#ifdef GEMM_HAS_X86_KERNELS
+    if (backend == GemmBackend::AVX512) return AVX512_KERNELS;
+    if (backend == GemmBackend::AVX2) return AVX2_KERNELS;
+#endif
+    return SCALAR_KERNELS;
+}
+
+// C = beta * C (при beta == 0 — просто нули, старое содержимое не читается)
+static void scale_c(size_t m, size_t n, float beta, float* c, size_t ldc)
+{
+    for (size_t i = 0; i < m; i++)
+    {
+        float* row = c + i * ldc;
+        if (beta == 0.0f)
+        {
+            std::fill(row, row + n, 0.0f);
+        }
+        else if (beta != 1.0f)
+        {
+            for (size_t j = 0; j < n; j++) row[j] *= beta;
+        }
+    }
+}
+
+// упаковка блока alpha * op(A)[row0.., col0..] размера mc x kc в панели по mr строк:
+// панель i хранит элементы столбец за столбцом, недостающие строки — нули
+static void pack_a(bool trans_a, const float* a, size_t lda, size_t row0, size_t col0,
+                   size_t mc, size_t kc, size_t mr, float alpha, float* dst)
+{
+    for (size_t i = 0; i < mc; i += mr)
+    {
+        size_t rows = std::min(mr, mc - i);
+
+        for (size_t p = 0; p < kc; p++)
+        {
+            for (size_t r = 0; r < rows; r++)
+            {
+                size_t row = row0 + i + r;
+                size_t col = col0 + p;
+                dst[r] = alpha * (trans_a ? a[col * lda + row] : a[row * lda + col]);
+            }
+            for (size_t r = rows; r < mr; r++) dst[r] = 0.0f;
+            dst += mr;
+        }
+    }
+}
+
+// упаковка блока op(B)[row0.., col0..] размера kc x nc в панели по nr столбцов
+static void pack_b(bool trans_b, const float* b, size_t ldb, size_t row0, size_t col0,
+                   size_t kc, size_t nc, size_t nr, float* dst)
+{
+    for (size_t j = 0; j < nc; j += nr)
+    {
+        size_t cols = std::min(nr, nc - j);
+
+        for (size_t p = 0; p < kc; p++)
+        {
+            size_t row = row0 + p;
+            if (!trans_b)
+            {
+                std::memcpy(dst, b + row * ldb + col0 + j, cols * sizeof(float));
+            }
+            else
+            {
+                for (size_t q = 0; q < cols; q++) dst[q] = b[(col0 + j + q) * ldb + row];
+            }
+            for (size_t q = cols; q < nr; q++) dst[q] = 0.0f;
+            dst += nr;
+        }
+    }
+}
+
+// M == 1 (полносвязный слой на одном примере): упаковка B стоила бы столько же,
+// сколько само умножение, поэтому считаем вектор на матрицу напрямую
+static void gemv_row(const GemmKernels& kern, bool trans_a, bool trans_b, size_t n, size_t k, float alpha,
+                     const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c,
+                     const GemmEpilogue* epilogue)
+{
+    thread_local std::vector<float> x;
+    x.resize(k);
+    for (size_t p = 0; p < k; p++)
+    {
+        x[p] = alpha * (trans_a ? a[p * lda] : a[p]);
+    }
+
+    if (trans_b)
+    {
+        // строки B непрерывны: каждый выход — скалярное произведение
+        for (size_t j = 0; j < n; j++)
+        {
+            float sum = kern.dot(k, x.data(), b + j * ldb);
+            c[j] = beta != 0.0f ? sum + beta * c[j] : sum;
+        }
+    }
+    else
+    {
+        // C += x[p] * строка p матрицы B
+        scale_c(1, n, beta, c, n);
+        for (size_t p = 0; p < k; p++)
+        {
+            kern.axpy(n, x[p], b + p * ldb, c);
+        }
+    }
+
+    if (epilogue) epilogue->apply(epilogue->context, c, n);
+}
+
+// упакованное умножение при k > 0 и alpha != 0 (любое m, в том числе 1)
+static void gemm_packed(const GemmKernels& kern, bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                        float alpha, const float* a, size_t lda, const float* b, size_t ldb,
+                        float beta, float* c, size_t ldc, const GemmEpilogue* epilogue)
+{
+    const size_t mr = kern.mr;
+    const size_t nr = kern.nr;
+
+    // буферы упаковки живут в потоке: повторные вызовы не выделяют память
+    thread_local std::vector<float> packed_a;
+    thread_local std::vector<float> packed_b;
+    packed_a.resize(MC * KC);
+    packed_b.resize(KC * NC);
+
+    float tile[MAX_MR * MAX_NR];
+
+    for (size_t jc = 0; jc < n; jc += NC)
+    {
+        size_t nc = std::min(NC, n - jc);
+
+        for (size_t pc = 0; pc < k; pc += KC)
+        {
+            size_t kc = std::min(KC, k - pc);
+            pack_b(trans_b, b, ldb, pc, jc, kc, nc, nr, packed_b.data());
+
+            // beta применяется только к первому блоку по K, дальше — накопление
+            float beta_block = pc == 0 ? beta : 1.0f;
+
+            for (size_t ic = 0; ic < m; ic += MC)
+            {
+                size_t mc = std::min(MC, m - ic);
+                pack_a(trans_a, a, lda, ic, pc, mc, kc, mr, alpha, packed_a.data());
+
+                for (size_t jr = 0; jr < nc; jr += nr)
+                {
+                    size_t cols = std::min(nr, nc - jr);
+                    const float* bp = packed_b.data() + jr * kc;
+
+                    for (size_t ir = 0; ir < mc; ir += mr)
+                    {
+                        size_t rows = std::min(mr, mc - ir);
+                        const float* ap = packed_a.data() + ir * kc;
+                        float* cp = c + (ic + ir) * ldc + jc + jr;
+
+                        if (rows == mr && cols == nr)
+                        {
+                            kern.micro(kc, ap, bp, cp, ldc, beta_block);
+                            continue;
+                        }
+
+                        // край матрицы: считаем полную плитку во временный буфер
+                        kern.micro(kc, ap, bp, tile, nr, 0.0f);
+                        for (size_t r = 0; r < rows; r++)
+                        {
+                            float* row = cp + r * ldc;
+                            const float* src = tile + r * nr;
+                            for (size_t q = 0; q < cols; q++)
+                            {
+                                row[q] = beta_block != 0.0f ? src[q] + beta_block * row[q] : src[q];
+                            }
+                        }
+                    }
+                }
+
+                // после последнего блока по K блок C [mc x nc] готов и ещё лежит в L2:
+                // эпилог по его строкам (длинные отрезки, а не строки плиток MR x NR)
+                if (epilogue && pc + kc == k)
+                {
+                    for (size_t r = 0; r < mc; r++) epilogue->apply(epilogue->context, c + (ic + r) * ldc + jc, nc);
+                }
+            }
+        }
+    }
+}
+
+static void gemm_blocked(const GemmKernels& kern, bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                         float alpha, const float* a, size_t lda, const float* b, size_t ldb,
+                         float beta, float* c, size_t ldc, const GemmEpilogue* epilogue)
+{
+    if (m == 0 || n == 0) return;
+
+    if (k == 0 || alpha == 0.0f)
+    {
+        scale_c(m, n, beta, c, ldc);
+        if (epilogue)
+        {
+            for (size_t i = 0; i < m; i++) epilogue->apply(epilogue->context, c + i * ldc, n);
+        }
+        return;
+    }
+
+    if (m == 1)
+    {
+        gemv_row(kern, trans_a, trans_b, n, k, alpha, a, lda, b, ldb, beta, c, epilogue);
+        return;
+    }
+
+    gemm_packed(kern, trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, epilogue);
+}
+
+// внутри пула потоков (см. thread_pool.h) C делится на независимые полосы: по столбцам N,
+// если их больше, чем строк (полносвязный слой: каждая часть читает свои строки весов
+// при transB), иначе по строкам M. Границы полос совпадают с границами плиток MR x NR
+// и векторов gemv, поэтому каждый элемент C считается так же, как без деления —
+// результат не зависит от числа потоков
+static void gemm_parallel(const GemmKernels& kern, bool trans_a, bool trans_b, size_t m, size_t n, size_t k,
+                          float alpha, const float* a, size_t lda, const float* b, size_t ldb,
+                          float beta, float* c, size_t ldc, const GemmEpilogue* epilogue)
+{
+    const size_t min_work = size_t(1) << 18;   // умножений-сложений на часть
+    bool by_columns = n >= m;
+    size_t strip = by_columns ? MAX_NR : MC;   // кратно NR (MR) всех бэкендов
+    size_t units = ((by_columns ? n : m) + strip - 1) / strip;
+    size_t unit_work = strip * (by_columns ? m : n) * k;
+    size_t grain = std::max<size_t>(1, min_work / std::max<size_t>(unit_work, 1));
+
+    if (k == 0 || alpha == 0.0f || parallel_parts(units, grain) == 1)
+    {
+        gemm_blocked(kern, trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, epilogue);
+        return;
+    }
+
+    parallel_for(0, units, grain, [&](size_t u0, size_t u1) {
+        size_t first = u0 * strip;
+        size_t count = std::min(u1 * strip, by_columns ? n : m) - first;
+
+        if (by_columns)
+        {
+            const float* b_part = trans_b ? b + first * ldb : b + first;
+            gemm_blocked(kern, trans_a, trans_b, m, count, k, alpha, a, lda, b_part, ldb, beta, c + first, ldc,
+                         epilogue);
+        }
+        else
+        {
+            // m > n >= 1: последняя полоса из одной строки всё равно идёт упакованным путём
+            const float* a_part = trans_a ? a + first : a + first * lda;
+            gemm_packed(kern, trans_a, trans_b, count, n, k, alpha, a_part, lda, b, ldb, beta,
+                        c + first * ldc, ldc, epilogue);
+        }
+    });
+}
+
+void sgemm(GemmBackend backend, bool trans_a, bool trans_b, size_t m, size_t n, size_t k, float alpha,
+           const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc)
+{
+    gemm_parallel(kernels_for(backend), trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, nullptr);
+}
+
+void sgemm(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, float alpha,
+           const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc,
+           const GemmEpilogue* epilogue)
+{
+    static const GemmKernels& kern = kernels_for(gemm_backend());
+    gemm_parallel(kern, trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, epilogue);
+}
+
+void sgemm_reference(bool trans_a, bool trans_b, size_t m, size_t n, size_t k, float alpha,
+                     const float* a, size_t lda, const float* b, size_t ldb, float beta, float* c, size_t ldc)
+{
+    for (size_t i = 0; i < m; i++)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            float sum = 0.0f;
+            for (size_t p = 0; p < k; p++)
+            {
+                float av = trans_a ? a[p * lda + i] : a[i * lda + p];
+                float bv = trans_b ? b[j * ldb + p] : b[p * ldb + j];
+                sum += av * bv;
+            }
+
+            float* out = c + i * ldc + j;
+            *out = beta != 0.0f ? alpha * sum + beta * *out : alpha * sum;
+        }
+    }
+}
@@ -0,0 +1,191 @@
+#include <vector>
+
+#include "parser.h"
+
+// построение CSR-индекса: два прохода (подсчёт степеней, затем заполнение)
+void GraphIndex::build(const std::vector<Node>& nodes, size_t tensor_count)
+{
+    const size_t node_count = nodes.size();
+
+    // производители: первый узел, записавший тензор
+    producers.assign(tensor_count, NO_NODE);
+    for (size_t i = 0; i < node_count; i++)
+    {
+        for (TensorId out : nodes[i].get_outputs())
+        {
+            if (out != NO_TENSOR && producers[out] == NO_NODE)
+            {
+                producers[out] = static_cast<NodeId>(i);
+            }
+        }
+    }
+
+    // потребители тензоров; seen[t] == i — узел i уже учтён для тензора t
+    std::vector<NodeId> seen(tensor_count, NO_NODE);
+    consumer_offsets.assign(tensor_count + 1, 0);
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        for (TensorId in : nodes[i].get_inputs())
+        {
+            if (in == NO_TENSOR || seen[in] == i) continue;
+            seen[in] = static_cast<NodeId>(i);
+            consumer_offsets[in + 1]++;
+        }
+    }
+
+    for (size_t t = 0; t < tensor_count; t++)
+    {
+        consumer_offsets[t + 1] += consumer_offsets[t];
+    }
+
+    consumer_list.resize(consumer_offsets[tensor_count]);
+    std::vector<uint32_t> fill(consumer_offsets.begin(), consumer_offsets.end() - 1);
+    seen.assign(tensor_count, NO_NODE);
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        for (TensorId in : nodes[i].get_inputs())
+        {
+            if (in == NO_TENSOR || seen[in] == i) continue;
+            seen[in] = static_cast<NodeId>(i);
+            consumer_list[fill[in]++] = static_cast<NodeId>(i);
+        }
+    }
+
+    // предшественники узлов; mark[p] == i — ребро p → i уже учтено
+    std::vector<NodeId> mark(node_count, NO_NODE);
+    pred_offsets.assign(node_count + 1, 0);
+
+    auto for_each_pred = [&](size_t i, auto&& fn) {
+        for (TensorId in : nodes[i].get_inputs())
+        {
+            if (in == NO_TENSOR) continue;
+
+            NodeId p = producers[in];
+            if (p == NO_NODE || p == i || mark[p] == i) continue;
+
+            mark[p] = static_cast<NodeId>(i);
+            fn(p);
+        }
+    };
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        for_each_pred(i, [&](NodeId) { pred_offsets[i + 1]++; });
+    }
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        pred_offsets[i + 1] += pred_offsets[i];
+    }
+
+    pred_list.resize(pred_offsets[node_count]);
+    mark.assign(node_count, NO_NODE);
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        uint32_t pos = pred_offsets[i];
+        for_each_pred(i, [&](NodeId p) { pred_list[pos++] = p; });
+    }
+
+    // последователи — транспонированный список предшественников
+    succ_offsets.assign(node_count + 1, 0);
+    for (NodeId p : pred_list)
+    {
+        succ_offsets[p + 1]++;
+    }
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        succ_offsets[i + 1] += succ_offsets[i];
+    }
+
+    succ_list.resize(succ_offsets[node_count]);
+    fill.assign(succ_offsets.begin(), succ_offsets.end() - 1);
+
+    for (size_t i = 0; i < node_count; i++)
+    {
+        for (uint32_t k = pred_offsets[i]; k < pred_offsets[i + 1]; k++)
+        {
+            succ_list[fill[pred_list[k]]++] = static_cast<NodeId>(i);
+        }
+    }
+}
+
+// топологическая сортировка по уровням (волнами): O(узлы + рёбра)
+void Graph::build_order() const
+{
+    const GraphIndex& graph_index = get_index();
+    const size_t node_count = nodes.size();
+
+    // число ещё не выполненных предшественников каждого узла
+    std::vector<uint32_t> in_degree(node_count);
+    for (size_t i = 0; i < node_count; i++)
+    {
+        in_degree[i] = static_cast<uint32_t>(graph_index.predecessors(static_cast<NodeId>(i)).size());
+    }
+
+    topo_order.clear();
+    topo_order.reserve(node_count);
+    level_offsets.assign(1, 0);
+    node_levels.assign(node_count, 0);
+
+    // уровень 0 — узлы без предшественников, в порядке файла
+    for (size_t i = 0; i < node_count; i++)
+    {
+        if (in_degree[i] == 0) topo_order.push_back(static_cast<NodeId>(i));
+    }
+
+    // волна за волной: узлы текущего уровня освобождают узлы следующего
+    size_t begin = 0;
+    while (begin < topo_order.size())
+    {
+        size_t end = topo_order.size();
+        uint32_t next_level = static_cast<uint32_t>(level_offsets.size());
+        level_offsets.push_back(static_cast<uint32_t>(end));
+
+        for (size_t k = begin; k < end; k++)
+        {
+            for (NodeId succ : graph_index.successors(topo_order[k]))
+            {
+                if (--in_degree[succ] == 0)
+                {
+                    node_levels[succ] = next_level;
+                    topo_order.push_back(succ);
+                }
+            }
+        }
+
+        begin = end;
+    }
+
+    // не все узлы освободились — остались узлы на цикле
+    if (topo_order.size() != node_count)
+    {
+        for (size_t i = 0; i < node_count; i++)
+        {
+            if (in_degree[i] != 0)
+            {
+                throw std::runtime_error("Граф содержит цикл, не упорядочен узел " + nodes[i].get_name() +
+                                         " (" + nodes[i].get_op_type() + ")");
+            }
+        }
+    }
+
+    order_valid = true;
+}
+
+void Graph::remove_nodes(const std::vector<bool>& removed)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (removed[i]) continue;
+        if (kept != i) nodes[kept] = std::move(nodes[i]);
+        kept++;
+    }
+    nodes.resize(kept);
+
+    invalidate_analysis();
+}
@@ -0,0 +1,700 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "graph_cache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+// строка в пуле: [offset, offset + length)
+struct CacheString
+{
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+// элементы [first, first + count) общего массива
+struct CacheRange
+{
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+struct CacheNode
+{
+    CacheString name;
+    CacheString op_type;
+    CacheRange inputs;  // в ids
+    CacheRange outputs; // в ids
+    CacheRange attrs;   // в attrs
+    CacheRange fused;   // в fused
+};
+
+// в какой словарь Node попадает атрибут
+enum CacheAttrKind : uint32_t
+{
+    ATTR_KIND_INT = 0,
+    ATTR_KIND_FLOAT = 1,
+    ATTR_KIND_INTS = 2,
+    ATTR_KIND_STRING = 3,
+    ATTR_KIND_FLOATS = 4,
+};
+
+struct CacheAttr
+{
+    CacheString name;
+    uint32_t kind = ATTR_KIND_INT;
+    float float_value = 0.0f;
+    int64_t int_value = 0;
+    CacheRange values;        // INTS — в int64s, FLOATS — в floats
+    CacheString string_value;
+};
+
+struct CacheFused
+{
+    CacheString op_type;
+    CacheString name;
+    int32_t operand = -1;
+    uint32_t reserved = 0;
+};
+
+struct CacheTensor
+{
+    TensorId id = NO_TENSOR;
+    int32_t data_type = UNDEFINED;
+    CacheRange dims;               // в int64s
+    uint64_t data_offset = 0; // в файле кеша (внешние данные — в файле location)
+    uint64_t data_length = 0;
+    CacheString external_location; // пусто — данные в кеше
+    uint32_t external_missing = 0; // файла внешних данных не было при записи
+    uint32_t reserved = 0;
+};
+
+struct CacheInfo
+{
+    TensorId id = NO_TENSOR;
+    int32_t data_type = UNDEFINED;
+    uint32_t has_shape = 0;
+    uint32_t reserved = 0;
+    CacheRange dims;       // в int64s
+    CacheRange dim_params; // в str_refs
+};
+
+// секции файла в порядке записи
+enum CacheSection
+{
+    SECTION_STRINGS,
+    SECTION_SYMBOLS,
+    SECTION_NODES,
+    SECTION_IDS,
+    SECTION_ATTRS,
+    SECTION_INT64S,
+    SECTION_FLOATS,
+    SECTION_FUSED,
+    SECTION_TENSORS,
+    SECTION_INFOS,
+    SECTION_STR_REFS,
+    SECTION_COUNT
+};
+
+struct CacheSectionRecord
+{
+    uint64_t offset = 0;
+    uint64_t size = 0; // байт
+};
+
+constexpr char CACHE_MAGIC[8] = {'O', 'N', 'N', 'X', 'G', 'R', 'P', 'H'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version = GRAPH_CACHE_VERSION;
+    uint32_t byte_order = BYTE_ORDER_MARK; // другой порядок байтов — другой формат
+    uint64_t header_size = sizeof(CacheHeader);
+    uint64_t file_size = 0;
+
+    // исходная модель
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+    int64_t source_ctime = 0;   // меняется при любой записи; восстановить mtime его не вернёт
+    uint64_t source_inode = 0;  // файл заменён другим (переименованием поверх)
+    uint64_t source_hash = 0;
+
+    int64_t ir_version = 0;
+    CacheString producer_name;
+    CacheString producer_version;
+    CacheString graph_name;
+    CacheRange inputs;  // в ids
+    CacheRange outputs; // в ids
+    uint32_t reserved[2] = {0, 0};
+
+    CacheSectionRecord sections[SECTION_COUNT];
+};
+
+static_assert(sizeof(CacheHeader) == 128 + SECTION_COUNT * sizeof(CacheSectionRecord), "заголовок без выравнивающих дыр");
+static_assert(std::is_trivially_copyable_v<CacheHeader> && std::is_trivially_copyable_v<CacheAttr> &&
+                  std::is_trivially_copyable_v<CacheTensor> && std::is_trivially_copyable_v<CacheInfo>,
+              "записи кеша копируются побайтно");
+
+static size_t align_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// хэш содержимого: FNV-1a по 8-байтовым словам с перемешиванием старших битов
+static uint64_t content_hash(ByteView bytes)
+{
+    const uint64_t prime = 0x100000001b3ULL;
+    uint64_t hash = 0xcbf29ce484222325ULL ^ bytes.size();
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 32;
+    }
+    for (; i < bytes.size(); i++) hash = (hash ^ bytes[i]) * prime;
+    return hash;
+}
+
+// размер, время изменения и (где есть stat) ctime и inode модели в поля source_* заголовка;
+// false — файла нет
+static bool source_stat(const std::string& model_path, CacheHeader& source)
+{
+    std::error_code error;
+    auto file_size = std::filesystem::file_size(model_path, error);
+    if (error) return false;
+    auto time = std::filesystem::last_write_time(model_path, error);
+    if (error) return false;
+
+    source.source_size = file_size;
+    source.source_mtime = static_cast<int64_t>(time.time_since_epoch().count());
+
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat info;
+    if (stat(model_path.c_str(), &info) != 0) return false;
+#ifdef __APPLE__
+    int64_t ctime_nsec = info.st_ctimespec.tv_nsec;
+#else
+    int64_t ctime_nsec = info.st_ctim.tv_nsec;
+#endif
+    source.source_ctime = static_cast<int64_t>(info.st_ctime) * 1000000000 + ctime_nsec;
+    source.source_inode = static_cast<uint64_t>(info.st_ino);
+#endif
+    return true;
+}
+
+// хэш содержимого модели по ограниченной выборке: начало и конец файла (заголовок protobuf,
+// метаданные, последние веса) и блоки с равным шагом между ними — не больше
+// SAMPLE_EDGE * 2 + SAMPLE_BLOCKS * SAMPLE_BLOCK байт при любом размере модели, чтобы проверка
+// кеша не читала многогигабайтную модель целиком. Небольшие модели хэшируются полностью.
+// Правку внутри непрочитанного блока выборка не заметит — её ловят ctime и inode
+constexpr uint64_t SAMPLE_EDGE = 64 * 1024;
+constexpr uint64_t SAMPLE_BLOCK = 4 * 1024;
+constexpr uint64_t SAMPLE_BLOCKS = 64;
+
+static uint64_t source_hash(const std::string& model_path, uint64_t size)
+{
+    std::ifstream file(model_path, std::ios::binary);
+    std::vector<uint8_t> sample;
+
+    auto read_at = [&](uint64_t offset, uint64_t length) {
+        size_t old_size = sample.size();
+        sample.resize(old_size + length);
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(reinterpret_cast<char*>(sample.data() + old_size), static_cast<std::streamsize>(length));
+        sample.resize(old_size + static_cast<size_t>(file.gcount()));
+        file.clear();
+    };
+
+    if (size <= SAMPLE_EDGE * 2 + SAMPLE_BLOCKS * SAMPLE_BLOCK)
+    {
+        read_at(0, size);
+    }
+    else
+    {
+        read_at(0, SAMPLE_EDGE);
+        uint64_t middle = size - SAMPLE_EDGE * 2 - SAMPLE_BLOCK;
+        for (uint64_t k = 0; k < SAMPLE_BLOCKS; k++)
+        {
+            read_at(SAMPLE_EDGE + middle * k / (SAMPLE_BLOCKS - 1), SAMPLE_BLOCK);
+        }
+        read_at(size - SAMPLE_EDGE, SAMPLE_EDGE);
+    }
+
+    // размер файла входит в хэш: выборки файлов разной длины не совпадут
+    return content_hash(ByteView(sample.data(), sample.size())) ^ size;
+}
+
+// сборка секций при записи
+class CacheWriter
+{
+public:
+    std::string strings;
+    std::vector<CacheString> symbols;
+    std::vector<CacheNode> nodes;
+    std::vector<TensorId> ids;
+    std::vector<CacheAttr> attrs;
+    std::vector<int64_t> int64s;
+    std::vector<float> floats;
+    std::vector<CacheFused> fused;
+    std::vector<CacheTensor> tensors;
+    std::vector<CacheInfo> infos;
+    std::vector<CacheString> str_refs;
+
+    std::vector<ByteView> payloads; // данные инициализаторов в порядке tensors
+    size_t payload_size = 0;        // от начала области данных, с выравниванием
+
+    CacheString add_string(const std::string& text)
+    {
+        CacheString ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size())};
+        strings += text;
+        return ref;
+    }
+
+    template <typename T>
+    CacheRange add_range(std::vector<T>& target, const std::vector<T>& values)
+    {
+        CacheRange range{static_cast<uint32_t>(target.size()), static_cast<uint32_t>(values.size())};
+        target.insert(target.end(), values.begin(), values.end());
+        return range;
+    }
+
+    void add_node(const Node& node)
+    {
+        CacheNode record;
+        record.name = add_string(node.get_name());
+        record.op_type = add_string(node.get_op_type());
+        record.inputs = add_range(ids, node.get_inputs());
+        record.outputs = add_range(ids, node.get_outputs());
+
+        // каждый словарь — в порядке имён: файл кеша не зависит от порядка обхода unordered_map
+        record.attrs.first = static_cast<uint32_t>(attrs.size());
+        for (const auto* entry : sorted_by_name(node.get_int_attrs()))
+        {
+            const auto& [name, value] = *entry;
+            CacheAttr attr;
+            attr.name = add_string(name);
+            attr.kind = ATTR_KIND_INT;
+            attr.int_value = value;
+            attrs.push_back(attr);
+        }
+        for (const auto* entry : sorted_by_name(node.get_float_attrs()))
+        {
+            const auto& [name, value] = *entry;
+            CacheAttr attr;
+            attr.name = add_string(name);
+            attr.kind = ATTR_KIND_FLOAT;
+            attr.float_value = value;
+            attrs.push_back(attr);
+        }
+        for (const auto* entry : sorted_by_name(node.get_ints_attrs()))
+        {
+            const auto& [name, values] = *entry;
+            CacheAttr attr;
+            attr.name = add_string(name);
+            attr.kind = ATTR_KIND_INTS;
+            attr.values = add_range(int64s, values);
+            attrs.push_back(attr);
+        }
+        for (const auto* entry : sorted_by_name(node.get_string_attrs()))
+        {
+            const auto& [name, value] = *entry;
+            CacheAttr attr;
+            attr.name = add_string(name);
+            attr.kind = ATTR_KIND_STRING;
+            attr.string_value = add_string(value);
+            attrs.push_back(attr);
+        }
+        for (const auto* entry : sorted_by_name(node.get_floats_attrs()))
+        {
+            const auto& [name, values] = *entry;
+            CacheAttr attr;
+            attr.name = add_string(name);
+            attr.kind = ATTR_KIND_FLOATS;
+            attr.values = add_range(floats, values);
+            attrs.push_back(attr);
+        }
+        record.attrs.count = static_cast<uint32_t>(attrs.size()) - record.attrs.first;
+
+        record.fused.first = static_cast<uint32_t>(fused.size());
+        for (const FusedOp& op : node.get_fused())
+        {
+            fused.push_back(CacheFused{add_string(op.op_type), add_string(op.name), op.operand, 0});
+        }
+        record.fused.count = static_cast<uint32_t>(node.get_fused().size());
+
+        nodes.push_back(record);
+    }
+
+    void add_tensor(TensorId id, const Tensor& tensor)
+    {
+        CacheTensor record;
+        record.id = id;
+        record.data_type = tensor.get_data_type();
+        record.dims = add_range(int64s, tensor.get_dims());
+
+        if (!tensor.get_external_location().empty())
+        {
+            // ссылка на файл внешних данных, без копии весов
+            record.external_location = add_string(tensor.get_external_location());
+            record.external_missing = tensor.raw_size() == 0 && tensor.element_count() != 0;
+            record.data_offset = tensor.source_offset();
+            record.data_length = tensor.raw_size();
+        }
+        else
+        {
+            // пока смещение от начала области данных, абсолютное — при записи
+            payload_size = align_up(payload_size, GRAPH_CACHE_ALIGNMENT);
+            record.data_offset = payload_size;
+            record.data_length = tensor.raw_size();
+            payload_size += tensor.raw_size();
+            payloads.push_back(tensor.raw_view());
+        }
+        tensors.push_back(record);
+    }
+
+    void add_info(TensorId id, const TensorInfo& info)
+    {
+        CacheInfo record;
+        record.id = id;
+        record.data_type = info.data_type;
+        record.has_shape = info.has_shape;
+        record.dims = add_range(int64s, info.dims);
+        record.dim_params.first = static_cast<uint32_t>(str_refs.size());
+        for (const std::string& param : info.dim_params) str_refs.push_back(add_string(param));
+        record.dim_params.count = static_cast<uint32_t>(info.dim_params.size());
+        infos.push_back(record);
+    }
+};
+
+// секция файла кеша как массив записей, с проверкой границ и выравнивания
+class CacheReader
+{
+    const FileBuffer& file;
+    const CacheHeader& header;
+
+public:
+    CacheReader(const FileBuffer& cache, const CacheHeader& cache_header) : file(cache), header(cache_header) {}
+
+    template <typename T>
+    Span<T> section(CacheSection kind) const
+    {
+        const CacheSectionRecord& record = header.sections[kind];
+        ByteView bytes = file.view(record.offset, record.size); // out_of_range за концом файла
+        if (record.offset % alignof(T) != 0 || record.size % sizeof(T) != 0)
+        {
+            throw std::out_of_range("Misaligned cache section");
+        }
+        return Span<T>(reinterpret_cast<const T*>(bytes.data()), record.size / sizeof(T));
+    }
+};
+
+template <typename T>
+static void check_range(CacheRange range, Span<T> values)
+{
+    if (range.first > values.size() || range.count > values.size() - range.first)
+    {
+        throw std::out_of_range("Cache range out of bounds");
+    }
+}
+
+template <typename T>
+static std::vector<T> read_range(CacheRange range, Span<T> values)
+{
+    check_range(range, values);
+    return std::vector<T>(values.begin() + range.first, values.begin() + range.first + range.count);
+}
+
+static std::string read_string(CacheString ref, Span<char> pool)
+{
+    check_range(CacheRange{ref.offset, ref.length}, pool);
+    return std::string(pool.data() + ref.offset, ref.length);
+}
+
+
+std::string graph_cache_path(const std::string& model_path)
+{
+    return model_path + ".gcache";
+}
+
+bool save_graph_cache(const Graph& graph, const std::string& model_path, const std::string& cache_path)
+{
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    if (!source_stat(model_path, header)) return false;
+    header.source_hash = source_hash(model_path, header.source_size);
+
+    CacheWriter writer;
+    header.ir_version = graph.getIrVersion();
+    header.producer_name = writer.add_string(graph.getProducerName());
+    header.producer_version = writer.add_string(graph.getProducerVersion());
+    header.graph_name = writer.add_string(graph.getGraphName());
+    header.inputs = writer.add_range(writer.ids, graph.get_inputs());
+    header.outputs = writer.add_range(writer.ids, graph.get_outputs());
+
+    const SymbolTable& symbols = graph.get_symbols();
+    for (TensorId id = 0; id < symbols.size(); id++) writer.symbols.push_back(writer.add_string(symbols.name(id)));
+    for (const Node& node : graph.get_nodes()) writer.add_node(node);
+    for (const auto& [id, tensor] : graph.get_initializers()) writer.add_tensor(id, tensor);
+    for (const auto& [id, info] : graph.get_tensor_infos()) writer.add_info(id, info);
+
+    // раскладка: заголовок, секции по 8 байт, данные по GRAPH_CACHE_ALIGNMENT
+    const std::pair<const void*, size_t> sections[SECTION_COUNT] = {
+        {writer.strings.data(), writer.strings.size()},
+        {writer.symbols.data(), writer.symbols.size() * sizeof(CacheString)},
+        {writer.nodes.data(), writer.nodes.size() * sizeof(CacheNode)},
+        {writer.ids.data(), writer.ids.size() * sizeof(TensorId)},
+        {writer.attrs.data(), writer.attrs.size() * sizeof(CacheAttr)},
+        {writer.int64s.data(), writer.int64s.size() * sizeof(int64_t)},
+        {writer.floats.data(), writer.floats.size() * sizeof(float)},
+        {writer.fused.data(), writer.fused.size() * sizeof(CacheFused)},
+        {writer.tensors.data(), writer.tensors.size() * sizeof(CacheTensor)},
+        {writer.infos.data(), writer.infos.size() * sizeof(CacheInfo)},
+        {writer.str_refs.data(), writer.str_refs.size() * sizeof(CacheString)},
+    };
+
+    size_t position = align_up(sizeof(CacheHeader), 8);
+    for (int k = 0; k < SECTION_COUNT; k++)
+    {
+        header.sections[k] = CacheSectionRecord{position, sections[k].second};
+        position = align_up(position + sections[k].second, 8);
+    }
+    const size_t payload_start = align_up(position, GRAPH_CACHE_ALIGNMENT);
+    header.file_size = payload_start + writer.payload_size;
+
+    // смещения данных в кеше — от начала файла
+    for (CacheTensor& record : writer.tensors)
+    {
+        if (record.external_location.length == 0) record.data_offset += payload_start;
+    }
+
+    // уникальное имя временного файла: несколько процессов могут писать кеш одновременно
+    std::string temp_path = cache_path + ".tmp" +
+                            std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                                           static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        size_t written = 0;
+        auto write_at = [&](size_t offset, const void* data, size_t size) {
+            static const char zeros[GRAPH_CACHE_ALIGNMENT] = {};
+            while (written < offset)
+            {
+                size_t gap = std::min(offset - written, sizeof(zeros));
+                out.write(zeros, static_cast<std::streamsize>(gap));
+                written += gap;
+            }
+            if (size) out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            written += size;
+        };
+
+        write_at(0, &header, sizeof(header));
+        for (int k = 0; k < SECTION_COUNT; k++) write_at(header.sections[k].offset, sections[k].first, sections[k].second);
+
+        size_t payload = 0;
+        for (const CacheTensor& record : writer.tensors)
+        {
+            if (record.external_location.length != 0) continue;
+            ByteView bytes = writer.payloads[payload++];
+            write_at(record.data_offset, bytes.data(), bytes.size());
+        }
+        write_at(header.file_size, nullptr, 0);
+
+        if (!out.flush())
+        {
+            out.close();
+            std::filesystem::remove(temp_path);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, cache_path, error);
+    if (error)
+    {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+std::optional<Graph> load_graph_cache(const std::string& cache_path, const std::string& model_path,
+                                      ExternalDataFiles& external_files)
+{
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(cache_path, error)) return std::nullopt;
+
+    try
+    {
+        auto cache = std::make_shared<const FileBuffer>(cache_path);
+        if (cache->get_size() < sizeof(CacheHeader)) return std::nullopt;
+
+        CacheHeader header;
+        std::memcpy(&header, cache->data(), sizeof(header));
+        if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != GRAPH_CACHE_VERSION ||
+            header.byte_order != BYTE_ORDER_MARK || header.header_size != sizeof(CacheHeader) ||
+            header.file_size != cache->get_size())
+        {
+            return std::nullopt;
+        }
+
+        // кеш устарел, если модель изменилась: сначала дешёвые размер, mtime, ctime и inode,
+        // и только если они совпали — хэш выборки (не больше ~0.4 МБ чтения при любом размере модели)
+        CacheHeader source;
+        if (!source_stat(model_path, source)) return std::nullopt;
+        if (source.source_size != header.source_size || source.source_mtime != header.source_mtime ||
+            source.source_ctime != header.source_ctime || source.source_inode != header.source_inode)
+        {
+            return std::nullopt;
+        }
+        if (source_hash(model_path, source.source_size) != header.source_hash) return std::nullopt;
+
+        CacheReader reader(*cache, header);
+        Span<char> strings = reader.section<char>(SECTION_STRINGS);
+        Span<CacheString> symbols = reader.section<CacheString>(SECTION_SYMBOLS);
+        Span<CacheNode> nodes = reader.section<CacheNode>(SECTION_NODES);
+        Span<TensorId> ids = reader.section<TensorId>(SECTION_IDS);
+        Span<CacheAttr> attrs = reader.section<CacheAttr>(SECTION_ATTRS);
+        Span<int64_t> int64s = reader.section<int64_t>(SECTION_INT64S);
+        Span<float> floats = reader.section<float>(SECTION_FLOATS);
+        Span<CacheFused> fused = reader.section<CacheFused>(SECTION_FUSED);
+        Span<CacheTensor> tensors = reader.section<CacheTensor>(SECTION_TENSORS);
+        Span<CacheInfo> infos = reader.section<CacheInfo>(SECTION_INFOS);
+        Span<CacheString> str_refs = reader.section<CacheString>(SECTION_STR_REFS);
+
+        Graph graph;
+        graph.setIrVersion(header.ir_version);
+        graph.setProducerName(read_string(header.producer_name, strings));
+        graph.setProducerVersion(read_string(header.producer_version, strings));
+        graph.setGraphName(read_string(header.graph_name, strings));
+
+        // имена в порядке id: intern выдаёт те же TensorId, что при разборе
+        graph.reserve_tensors(symbols.size());
+        for (size_t id = 0; id < symbols.size(); id++)
+        {
+            check_range(CacheRange{symbols[id].offset, symbols[id].length}, strings);
+            std::string_view name(strings.data() + symbols[id].offset, symbols[id].length);
+            if (graph.intern_tensor(name) != id) return std::nullopt;
+        }
+
+        auto valid_id = [&](TensorId id) { return id == NO_TENSOR || id < symbols.size(); };
+
+        graph.reserve_nodes(nodes.size());
+        for (const CacheNode& record : nodes)
+        {
+            Node& node = graph.emplace_node();
+            node.set_name(read_string(record.name, strings));
+            node.set_op_type(read_string(record.op_type, strings));
+
+            for (TensorId id : read_range(record.inputs, ids))
+            {
+                if (!valid_id(id)) return std::nullopt;
+                node.add_input(id);
+            }
+            for (TensorId id : read_range(record.outputs, ids))
+            {
+                if (!valid_id(id)) return std::nullopt;
+                node.add_output(id);
+            }
+
+            check_range(record.attrs, attrs);
+            for (uint32_t k = record.attrs.first; k < record.attrs.first + record.attrs.count; k++)
+            {
+                const CacheAttr& attr = attrs[k];
+                std::string name = read_string(attr.name, strings);
+                switch (attr.kind)
+                {
+                case ATTR_KIND_INT: node.add_int_attr(std::move(name), attr.int_value); break;
+                case ATTR_KIND_FLOAT: node.add_float_attr(std::move(name), attr.float_value); break;
+                case ATTR_KIND_INTS: node.add_ints_attr(std::move(name), read_range(attr.values, int64s)); break;
+                case ATTR_KIND_STRING: node.add_string_attr(std::move(name), read_string(attr.string_value, strings)); break;
+                case ATTR_KIND_FLOATS: node.add_floats_attr(std::move(name), read_range(attr.values, floats)); break;
+                default: return std::nullopt;
+                }
+            }
+
+            for (const CacheFused& op : read_range(record.fused, fused))
+            {
+                node.add_fused(FusedOp{read_string(op.op_type, strings), read_string(op.name, strings), op.operand});
+            }
+        }
+
+        for (const CacheTensor& record : tensors)
+        {
+            if (record.id >= symbols.size()) return std::nullopt;
+
+            Tensor tensor;
+            tensor.set_name(graph.tensor_name(record.id));
+            tensor.set_data_type(record.data_type);
+            for (int64_t dim : read_range(record.dims, int64s)) tensor.add_dim(dim);
+
+            if (record.external_location.length != 0)
+            {
+                std::string location = read_string(record.external_location, strings);
+                tensor.set_external_location(location);
+
+                std::shared_ptr<const FileBuffer> file = external_files.open(location);
+                // файл, которого не было при записи, появился — кеш устарел
+                if (file && record.external_missing) return std::nullopt;
+                if (file)
+                {
+                    file->view(record.data_offset, record.data_length); // проверка границ
+                    tensor.set_lazy_data(std::move(file), record.data_offset, record.data_length);
+                }
+            }
+            else if (record.data_length != 0)
+            {
+                // веса используются на месте, в отображении файла кеша
+                cache->view(record.data_offset, record.data_length);
+                tensor.set_lazy_data(cache, record.data_offset, record.data_length);
+            }
+            graph.add_tensor(record.id, std::move(tensor));
+        }
+
+        for (const CacheInfo& record : infos)
+        {
+            if (record.id >= symbols.size()) return std::nullopt;
+
+            TensorInfo info;
+            info.data_type = record.data_type;
+            info.has_shape = record.has_shape != 0;
+            info.dims = read_range(record.dims, int64s);
+            for (CacheString param : read_range(record.dim_params, str_refs)) info.dim_params.push_back(read_string(param, strings));
+            graph.set_tensor_info(record.id, std::move(info));
+        }
+
+        for (TensorId id : read_range(header.inputs, ids))
+        {
+            if (id >= symbols.size()) return std::nullopt;
+            graph.add_input(id);
+        }
+        for (TensorId id : read_range(header.outputs, ids))
+        {
+            if (id >= symbols.size()) return std::nullopt;
+            graph.add_output(id);
+        }
+
+        graph.build_index();
+        return graph;
+    }
+    catch (const std::exception&)
+    {
+        // повреждённый или нечитаемый кеш — модель просто разбирается заново
+        return std::nullopt;
+    }
+}
@@ -1,8 +1,21 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <thread>
 #include <unordered_set>
 
+#include "exec_profile.h"
+#include "executor.h"
+#include "graph_cache.h"
+#include "parse_profile.h"
 #include "parser.h"
+#include "shape_inference.h"
+#include "stream_parser.h"
 
 // имена возможных атрибутов
 const std::unordered_set<std::string> ATTR_NAMES = {
@@ -90,27 +103,426 @@ std::string remove_extra_spaces(const std::string& str)
 }
 
 
+// параметры командной строки
+struct Options
+{
+    std::string model_path;
+    bool run = false;                                           // --run: выполнить граф
+    std::vector<std::pair<std::string, std::vector<int64_t>>> input_shapes; // --input name=1,3,28,28
+    std::string golden_path;                                    // --golden file: сверить выходы
+    bool fold = false;                                          // --fold: свернуть константные подграфы
+    bool fuse = false;                                          // --fuse: слить Relu/Add/Mul с Conv/Gemm/MatMul
+    bool infer = false;                                         // --infer: вывести формы всех тензоров
+    bool plan = false;                                          // --plan: план памяти активаций
+    size_t threads = 1;                                         // --threads N: параллельный разбор и выполнение (0 — по числу ядер)
+    bool pin = false;                                           // --pin: закрепить потоки по узлам NUMA
+    std::string cache_path;                                     // --cache file: бинарный кеш графа
+    bool scan = false;                                          // --scan: потоковый подсчёт операций без графа
+    bool parse_profile = false;                                 // --parse-profile: таблица фаз разбора
+    std::string parse_trace_path;                               // --parse-trace file: Chrome trace разбора
+    bool profile = false;                                       // --profile: время, FLOP и байты узлов
+    size_t profile_top = 10;                                    // --top N: самых медленных узлов в сводке
+};
+
+// разбор "name=d0,d1,..."
+static std::pair<std::string, std::vector<int64_t>> parse_input_spec(const std::string& spec)
+{
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos) throw std::runtime_error("Ожидается --input name=d0,d1,...: " + spec);
+
+    std::vector<int64_t> shape;
+    std::stringstream dims(spec.substr(eq + 1));
+    std::string dim;
+    while (std::getline(dims, dim, ','))
+    {
+        shape.push_back(std::stoll(dim));
+    }
+
+    return {spec.substr(0, eq), shape};
+}
+
+static Options parse_options(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--run") options.run = true;
+        else if (arg == "--input" && i + 1 < argc) options.input_shapes.push_back(parse_input_spec(argv[++i]));
+        else if (arg == "--golden" && i + 1 < argc) options.golden_path = argv[++i];
+        else if (arg == "--fold") options.fold = true;
+        else if (arg == "--fuse") options.fuse = true;
+        else if (arg == "--infer") options.infer = true;
+        else if (arg == "--plan") options.plan = true;
+        else if (arg == "--threads" && i + 1 < argc) options.threads = std::stoul(argv[++i]);
+        else if (arg == "--pin") options.pin = true;
+        else if (arg == "--cache" && i + 1 < argc) options.cache_path = argv[++i];
+        else if (arg == "--scan") options.scan = true;
+        else if (arg == "--parse-profile") options.parse_profile = true;
+        else if (arg == "--parse-trace" && i + 1 < argc) options.parse_trace_path = argv[++i];
+        else if (arg == "--profile") options.profile = true;
+        else if (arg == "--top" && i + 1 < argc) options.profile_top = std::stoul(argv[++i]);
+        else if (!arg.empty() && arg[0] == '-' && arg != "-") throw std::runtime_error("Неизвестный параметр: " + arg);
+        else options.model_path = arg;
+    }
+
+    if (!options.golden_path.empty() || options.profile) options.run = true;
+
+    // 0 — все ядра: и для разбора, и для исполнителя (у которого 0 и 1 — последовательно)
+    if (options.threads == 0) options.threads = std::max(1u, std::thread::hardware_concurrency());
+    return options;
+}
+
+// формы входов графа: объявленные в модели, поверх них — заданные через --input.
+// Символьные размерности (batch_size) для выполнения заменяются на 1, иначе вход без
+// явной формы пропускается: свёртка и вывод форм должны сохранить символ
+static std::unordered_map<std::string, std::vector<int64_t>> resolve_input_shapes(const Graph& graph,
+                                                                                 const Options& options,
+                                                                                 bool for_run)
+{
+    std::unordered_map<std::string, std::vector<int64_t>> shapes;
+
+    for (TensorId id : graph.get_inputs())
+    {
+        const TensorInfo* info = graph.find_tensor_info(id);
+        if (graph.find_initializer(id) != nullptr || info == nullptr || !info->has_shape) continue;
+        if (!for_run && !info->is_static()) continue;
+
+        std::vector<int64_t> shape = info->dims;
+        for (int64_t& dim : shape)
+        {
+            if (dim < 0) dim = 1;
+        }
+        shapes[graph.tensor_name(id)] = std::move(shape);
+    }
+
+    for (const auto& [name, shape] : options.input_shapes)
+    {
+        shapes[name] = shape;
+    }
+    return shapes;
+}
+
+// печать "имя: ТИП [d0, d1, ...]" для списка тензоров
+static void print_tensor_infos(const Graph& graph, const std::vector<TensorId>& ids)
+{
+    for (TensorId id : ids)
+    {
+        if (graph.find_initializer(id) != nullptr) continue; // веса в старых IR тоже числятся входами
+
+        std::cout << graph.tensor_name(id) << ":";
+        if (const TensorInfo* info = graph.find_tensor_info(id))
+        {
+            std::cout << " " << data_type_name(info->data_type);
+            if (info->has_shape) std::cout << " " << info->shape_string();
+        }
+        std::cout << "\n";
+    }
+}
+
+// план памяти для конкретных форм входов (символьные размерности — 1, как при --run)
+static MemoryPlan plan_for_run(Graph& graph, const Options& options)
+{
+    infer_shapes(graph, resolve_input_shapes(graph, options, true));
+    return plan_memory(graph);
+}
+
+static void print_memory_plan(const Graph& graph, const MemoryPlan& plan)
+{
+    std::cout << "=== Memory Plan ===\n";
+    for (const BufferAssignment& buffer : plan.buffers)
+    {
+        std::cout << graph.tensor_name(buffer.tensor) << ": " << buffer.size << " bytes at offset "
+                  << buffer.offset << ", steps " << buffer.first_step << "-" << buffer.last_step << "\n";
+    }
+
+    double saved = plan.naive_size ? 100.0 * (1.0 - static_cast<double>(plan.arena_size) / plan.naive_size) : 0.0;
+    std::cout << "Arena: " << plan.arena_size << " bytes for " << plan.buffers.size() << " tensors (naive "
+              << plan.naive_size << " bytes, " << std::fixed << std::setprecision(1) << saved
+              << "% saved; live peak " << plan.live_peak << " bytes)\n\n";
+    std::cout.unsetf(std::ios::fixed);
+}
+
+// детерминированные входные данные в [-1, 1] (по ним посчитаны эталоны в tests/*.golden)
+static Value make_test_input(const std::vector<int64_t>& shape)
+{
+    std::vector<float> data(shape_size(shape));
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<float>((i * 37) % 101) / 50.0f - 1.0f;
+    }
+    return Value(shape, std::move(data));
+}
+
+// сверка выходов с эталоном: строки вида "name: v0 v1 ..."
+static bool check_golden(const std::unordered_map<std::string, Value>& results, const std::string& path)
+{
+    std::ifstream golden(path);
+    if (!golden) throw std::runtime_error("Не удалось открыть эталон: " + path);
+
+    bool ok = true;
+    size_t checked = 0;
+    std::string line;
+
+    while (std::getline(golden, line))
+    {
+        size_t colon = line.find(':');
+        if (line.empty() || line[0] == '#' || colon == std::string::npos) continue;
+
+        std::string name = line.substr(0, colon);
+        auto it = results.find(name);
+        if (it == results.end())
+        {
+            std::cerr << "Golden: нет выхода " << name << "\n";
+            ok = false;
+            continue;
+        }
+
+        std::stringstream values(line.substr(colon + 1));
+        std::vector<float> expected;
+        float v;
+        while (values >> v) expected.push_back(v);
+
+        const Value& actual = it->second;
+        if (expected.size() != actual.element_count())
+        {
+            std::cerr << "Golden: " << name << " — " << actual.element_count()
+                      << " значений вместо " << expected.size() << "\n";
+            ok = false;
+            continue;
+        }
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            float diff = std::fabs(actual.data()[i] - expected[i]);
+            if (diff > 1e-4f + 1e-4f * std::fabs(expected[i]))
+            {
+                std::cerr << "Golden: " << name << "[" << i << "] = " << actual.data()[i]
+                          << ", ожидалось " << expected[i] << "\n";
+                ok = false;
+                break;
+            }
+        }
+        checked++;
+    }
+
+    if (checked == 0) ok = false;
+    std::cout << (ok ? "Golden check passed" : "Golden check FAILED") << " (" << path << ")\n";
+    return ok;
+}
+
+// выполнение графа на тестовых входах и печать выходов
+static bool run_graph(Graph& graph, const Options& options)
+{
+    std::unordered_map<std::string, Value> inputs;
+    for (const auto& [name, shape] : resolve_input_shapes(graph, options, true))
+    {
+        inputs.emplace(name, make_test_input(shape));
+    }
+
+    // активации — в одной арене по плану
+    MemoryPlan plan = plan_for_run(graph, options);
+    Executor executor(graph);
+    executor.use_memory_plan(plan);
+    executor.set_threads(options.threads, options.pin);
+
+    // профиль — второго запуска: первый касается весов и арены, прогревает кэши
+    ExecutionProfile profile;
+    if (options.profile)
+    {
+        executor.run(inputs);
+        executor.set_profile(&profile);
+    }
+    std::unordered_map<std::string, Value> results = executor.run(inputs);
+
+    std::cout << "\n=== Outputs ===\n";
+    for (const auto& [name, value] : results)
+    {
+        std::cout << name << " [";
+        for (size_t d = 0; d < value.get_shape().size(); d++)
+        {
+            std::cout << (d ? " " : "") << value.get_shape()[d];
+        }
+        std::cout << "]:" << std::setprecision(6);
+
+        for (size_t i = 0; i < value.element_count(); i++)
+        {
+            if (value.get_data_type() == INT64) std::cout << " " << value.int_data()[i];
+            else std::cout << " " << value.data()[i];
+        }
+        std::cout << "\n";
+    }
+
+    if (options.profile)
+    {
+        std::cout << "\n";
+        profile.print(graph, std::cout, options.profile_top, measure_machine_peaks(options.threads));
+    }
+
+    if (options.golden_path.empty()) return true;
+    return check_golden(results, options.golden_path);
+}
+
+// потоковый проход по модели: метаданные, число узлов по типам операций и объём весов.
+// Граф не строится, память не зависит от размера модели (подходит и для пайпа)
+static void scan_model(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Ошибка открытия файла .onnx");
+
+    std::map<std::string, size_t, std::less<>> op_counts;
+    size_t node_count = 0, tensor_count = 0;
+    uint64_t data_bytes = 0;
+
+    StreamCallbacks callbacks;
+    callbacks.on_metadata = [](std::string_view key, std::string_view value) {
+        std::cout << key << ": " << value << "\n";
+    };
+    callbacks.on_node = [&](const StreamNode& node) {
+        node_count++;
+        auto it = op_counts.find(node.op_type);
+        if (it == op_counts.end()) it = op_counts.emplace(std::string(node.op_type), 0).first;
+        it->second++;
+    };
+    callbacks.on_tensor = [&](const StreamTensor& tensor) {
+        tensor_count++;
+        data_bytes += tensor.data_length;
+    };
+
+    StreamReader reader(file);
+    ONNXStreamParser(reader, std::move(callbacks)).parse();
+
+    std::cout << "\n=== Scan: " << node_count << " nodes, " << tensor_count << " initializers ("
+              << data_bytes << " bytes of data) ===\n";
+    for (const auto& [op_type, count] : op_counts) std::cout << op_type << ": " << count << "\n";
+}
+
 int main(int argc, char* argv[]) 
 {
     if (argc < 2) 
     { 
-        std::cerr << "Usage: " << argv[0] << " <model.onnx>\n"; 
+        std::cerr << "Usage: " << argv[0] << " <model.onnx> [--fold] [--fuse] [--infer] [--plan] [--run] [--threads N (0 = all cores) [--pin]] [--input name=d0,d1,...]... [--golden file] [--cache file] [--scan] [--parse-profile] [--parse-trace file.json] [--profile [--top N]]\n"; 
         return 1; 
     }
 
     try 
     {
-        std::cout << "=== Loading: " << argv[1] << " ===\n\n";
+        Options options = parse_options(argc, argv);
+
+        if (options.scan)
+        {
+            scan_model(options.model_path);
+            return 0;
+        }
+        std::cout << "=== Loading: " << options.model_path << " ===\n\n";
+
+        bool profile_parse = options.parse_profile || !options.parse_trace_path.empty();
+#ifdef ONNX_PARSE_PROFILE
+        if (profile_parse) parse_profile_reset(!options.parse_trace_path.empty());
+#endif
         
-        ONNXParser parser(argv[1]);
-        Graph graph = parser.parse();
+        ONNXParser parser(options.model_path);
+        parser.set_threads(options.threads);
+
+        // с --cache граф берётся из кеша, если он соответствует модели, иначе
+        // разбирается и кеш записывается для следующего запуска
+        std::optional<Graph> cached;
+        if (!options.cache_path.empty())
+        {
+            cached = load_graph_cache(options.cache_path, options.model_path, parser.external_data());
+        }
+        Graph graph = cached ? std::move(*cached) : parser.parse();
+
+        if (cached)
+        {
+            std::cout << "Graph cache: loaded " << options.cache_path << "\n\n";
+        }
+        else if (!options.cache_path.empty())
+        {
+            bool saved = save_graph_cache(graph, options.model_path, options.cache_path);
+            std::cout << "Graph cache: " << (saved ? "written " : "not written ") << options.cache_path << "\n\n";
+        }
+
+        if (profile_parse)
+        {
+#ifdef ONNX_PARSE_PROFILE
+            if (options.parse_profile) print_parse_profile(std::cout);
+            if (!options.parse_trace_path.empty())
+            {
+                bool written = write_parse_trace(options.parse_trace_path);
+                std::cout << "Parse trace: " << (written ? "written " : "not written ") << options.parse_trace_path << "\n";
+            }
+#else
+            std::cout << "Parse profile: not compiled in (cmake -DONNX_PARSE_PROFILE=ON)\n";
+#endif
+            std::cout << "\n";
+        }
         
         // мета-информация
         std::cout << "=== Parsed Graph Info ===\n";
         std::cout << "IR version: " << graph.getIrVersion() << "\n";
         std::cout << "Producer: " << graph.getProducerName() 
                   << " v" << graph.getProducerVersion() << "\n";
-        std::cout << "Graph name: " << graph.getGraphName() << "\n\n";
+        std::cout << "Graph name: " << graph.getGraphName() << "\n";
+        std::vector<std::string> missing = parser.missing_external_files();
+        if (parser.external_file_count() > 0 || !missing.empty())
+        {
+            std::cout << "External data: " << parser.external_file_count() << " file(s) mapped";
+            if (!missing.empty()) std::cout << ", missing:";
+            for (const std::string& location : missing) std::cout << " " << location;
+            std::cout << "\n";
+        }
+        std::cout << "\n";
+
+        std::cout << "=== Graph Inputs ===\n";
+        print_tensor_infos(graph, graph.get_inputs());
+        std::cout << "\n=== Graph Outputs ===\n";
+        print_tensor_infos(graph, graph.get_outputs());
+        std::cout << "\n";
+
+        if (options.fold)
+        {
+            // известные формы входов позволяют свернуть и Shape от входов графа
+            size_t folded = fold_constants(graph, resolve_input_shapes(graph, options, false));
+            std::cout << "Folded " << folded << " constant nodes into initializers\n\n";
+        }
+
+        if (options.fuse)
+        {
+            size_t fused = graph.fuse_epilogues();
+            std::cout << "Fused " << fused << " elementwise nodes into their producers\n\n";
+        }
+
+        bool shapes_consistent = true;
+        if (options.infer)
+        {
+            ShapeInferenceResult inference = infer_shapes(graph, resolve_input_shapes(graph, options, false));
+
+            std::cout << "=== Shapes ===\n";
+            for (const auto& node : graph.get_nodes())
+            {
+                if (node.get_op_type().empty()) continue;
+                print_tensor_infos(graph, node.get_outputs());
+            }
+            for (const std::string& skipped : inference.skipped)
+            {
+                std::cout << "Skipped " << skipped << "\n";
+            }
+            for (const std::string& mismatch : inference.mismatches)
+            {
+                std::cerr << "Shape mismatch: " << mismatch << "\n";
+            }
+            std::cout << "Inferred " << inference.inferred << " tensor shapes, "
+                      << inference.mismatches.size() << " mismatches\n\n";
+            shapes_consistent = inference.mismatches.empty();
+        }
+
+        if (options.plan)
+        {
+            print_memory_plan(graph, plan_for_run(graph, options));
+        }
         
         std::cout << "=== Nodes ===\n";
         for (const auto& node : graph.get_nodes()) 
@@ -119,13 +531,14 @@ int main(int argc, char* argv[])
             if (node.get_op_type().empty()) continue;
             
             // вывод типа операции
-            std::cout << "Op: " << node.get_op_type() << "\n";
+            std::cout << "Op: " << node.display_type() << "\n";
             
             // вывод входов 
             std::cout << "  Inputs: ";
             std::string inputs_str;
-            for (const auto& in : node.get_inputs()) 
+            for (TensorId in_id : node.get_inputs()) 
             {
+                const std::string& in = graph.tensor_name(in_id);
                 if (ATTR_NAMES.count(in) == 0 && !in.empty()) 
                 {
                     inputs_str += in + " ";
@@ -136,8 +549,9 @@ int main(int argc, char* argv[])
             // Вывод выходов
             std::cout << "  Outputs: ";
             std::string outputs_str;
-            for (const auto& out : node.get_outputs()) 
+            for (TensorId out_id : node.get_outputs()) 
             {
+                const std::string& out = graph.tensor_name(out_id);
                 if (!out.empty()) 
                 {
                     outputs_str += out + " ";
@@ -145,25 +559,37 @@ int main(int argc, char* argv[])
             }
             std::cout << remove_extra_spaces(outputs_str) << "\n";
             
-            // Int-атрибуты
-            for (const auto& [name, vals] : node.get_ints_attrs()) 
+            // Int-атрибуты (в каждом словаре — в порядке имён)
+            for (const auto* attr : sorted_by_name(node.get_ints_attrs()))
             {
+                const auto& [name, vals] = *attr;
                 std::cout << "  [" << name << ": ";
                 for (auto v : vals) std::cout << v << " ";
                 std::cout << "]\n";
             }
             
             // Float-атрибуты
-            for (const auto& [name, val] : node.get_float_attrs()) 
+            for (const auto* attr : sorted_by_name(node.get_float_attrs()))
             {
+                const auto& [name, val] = *attr;
                 std::cout << "  [" << name << ": " << val << "]\n";
             }
             
             // String-атрибуты
-            for (const auto& [name, val] : node.get_string_attrs()) 
+            for (const auto* attr : sorted_by_name(node.get_string_attrs()))
             {
+                const auto& [name, val] = *attr;
                 std::cout << "  [" << name << ": " << val << "]\n";
             }
+
+            // Списки float
+            for (const auto* attr : sorted_by_name(node.get_floats_attrs()))
+            {
+                const auto& [name, vals] = *attr;
+                std::cout << "  [" << name << ": ";
+                for (float v : vals) std::cout << v << " ";
+                std::cout << "]\n";
+            }
             
             std::cout << "\n";  
         }
@@ -172,7 +598,9 @@ int main(int argc, char* argv[])
 
         graph.export_to_dot("graph.dot");
 
-        return 0;
+        if (options.run && !run_graph(graph, options)) return 1;
+
+        return shapes_consistent ? 0 : 1;
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
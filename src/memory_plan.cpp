@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "memory_plan.h"
+
+static size_t align_up(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+}
+
+// байт под тензор со статической float-формой; 0 — тензор не планируется
+static size_t planned_size(const TensorInfo* info)
+{
+    if (info == nullptr || !info->has_shape || !info->is_static() || info->data_type != FLOAT) return 0;
+
+    size_t count = 1;
+    for (int64_t dim : info->dims) count *= static_cast<size_t>(dim);
+    return align_up(count * sizeof(float));
+}
+
+// размещённые буферы по времени жизни: поиск тех, что живы хотя бы на одном шаге [first, last],
+// без перебора всех. Живые на шаге first — отрезки в дереве отрезков по шагам (отрезок лежит
+// в O(log шагов) узлах, путь от листа first к корню проходит ровно через один из них),
+// начавшиеся позже first — в индексе по первому шагу. Поиск — O(log шагов + найденных)
+class LifetimeIndex
+{
+public:
+    explicit LifetimeIndex(size_t steps) : leaves(steps), nodes(2 * steps) {}
+
+    void insert(size_t index, size_t first, size_t last)
+    {
+        for (size_t l = first + leaves, r = last + 1 + leaves; l < r; l >>= 1, r >>= 1)
+        {
+            if (l & 1) nodes[l++].push_back(index);
+            if (r & 1) nodes[--r].push_back(index);
+        }
+        by_first.emplace(first, index);
+    }
+
+    template <typename Fn>
+    void for_each_overlapping(size_t first, size_t last, Fn&& fn) const
+    {
+        for (size_t node = first + leaves; node > 0; node >>= 1)
+        {
+            for (size_t index : nodes[node]) fn(index);
+        }
+        for (auto it = by_first.upper_bound(first); it != by_first.end() && it->first <= last; ++it)
+        {
+            fn(it->second);
+        }
+    }
+
+private:
+    size_t leaves;
+    std::vector<std::vector<size_t>> nodes;
+    std::multimap<size_t, size_t> by_first;
+};
+
+MemoryPlan plan_memory(const Graph& graph)
+{
+    MemoryPlan plan;
+    const std::vector<Node>& nodes = graph.get_nodes();
+    const std::vector<NodeId>& order = graph.topological_order();
+    const size_t tensor_count = graph.tensor_count();
+    const size_t step_count = order.size();
+
+    // времена жизни: от шага-производителя до последнего шага-читателя
+    std::vector<size_t> buffer_of(tensor_count, std::numeric_limits<size_t>::max());
+    std::vector<bool> consumed(tensor_count, false);
+
+    for (size_t step = 0; step < step_count; step++)
+    {
+        const Node& node = nodes[order[step]];
+        if (node.get_op_type().empty()) continue;
+
+        for (TensorId in : node.get_inputs())
+        {
+            if (in == NO_TENSOR || buffer_of[in] == std::numeric_limits<size_t>::max()) continue;
+            plan.buffers[buffer_of[in]].last_step = step;
+            consumed[in] = true;
+        }
+
+        for (TensorId out : node.get_outputs())
+        {
+            if (out == NO_TENSOR || graph.find_initializer(out) != nullptr) continue;
+
+            size_t size = planned_size(graph.find_tensor_info(out));
+            if (size == 0) continue;
+
+            BufferAssignment buffer;
+            buffer.tensor = out;
+            buffer.size = size;
+            buffer.first_step = step;
+            buffer.last_step = step;
+            buffer_of[out] = plan.buffers.size();
+            plan.buffers.push_back(buffer);
+        }
+    }
+
+    // выходы графа читает вызывающий код после последнего шага. Тензоры, которые никто
+    // не читает, тоже: если выходы графа не разобраны, run() возвращает именно их
+    for (TensorId out : graph.get_outputs())
+    {
+        if (buffer_of[out] != std::numeric_limits<size_t>::max()) plan.buffers[buffer_of[out]].last_step = step_count;
+    }
+    for (BufferAssignment& buffer : plan.buffers)
+    {
+        if (!consumed[buffer.tensor]) buffer.last_step = step_count;
+    }
+
+    // нижняя граница: сумма живых тензоров на самом нагруженном шаге — проходом по концам
+    // времён жизни: тензор прибавляется на первом шаге и вычитается после последнего
+    std::vector<size_t> born(step_count + 1, 0), died(step_count + 2, 0);
+    for (const BufferAssignment& buffer : plan.buffers)
+    {
+        plan.naive_size += buffer.size;
+        born[buffer.first_step] += buffer.size;
+        died[buffer.last_step + 1] += buffer.size;
+    }
+    size_t live = 0;
+    for (size_t step = 0; step <= step_count; step++)
+    {
+        live = live + born[step] - died[step];
+        plan.live_peak = std::max(plan.live_peak, live);
+    }
+
+    // крупные тензоры размещаются первыми: мелкие потом заполняют промежутки
+    std::vector<size_t> by_size(plan.buffers.size());
+    for (size_t i = 0; i < by_size.size(); i++) by_size[i] = i;
+    std::stable_sort(by_size.begin(), by_size.end(),
+                     [&](size_t a, size_t b) { return plan.buffers[a].size > plan.buffers[b].size; });
+
+    LifetimeIndex placed(step_count + 1);
+    std::vector<size_t> overlapping; // размещённые, живые одновременно с buffer, по возрастанию смещения
+    for (size_t index : by_size)
+    {
+        BufferAssignment& buffer = plan.buffers[index];
+
+        overlapping.clear();
+        placed.for_each_overlapping(buffer.first_step, buffer.last_step,
+                                    [&](size_t other_index) { overlapping.push_back(other_index); });
+        std::sort(overlapping.begin(), overlapping.end(),
+                  [&](size_t a, size_t b) { return plan.buffers[a].offset < plan.buffers[b].offset; });
+
+        size_t prev_end = 0;
+        size_t best_offset = std::numeric_limits<size_t>::max();
+        size_t best_gap = std::numeric_limits<size_t>::max();
+
+        for (size_t other_index : overlapping)
+        {
+            const BufferAssignment& other = plan.buffers[other_index];
+
+            // промежуток перед other, свободный на всё время жизни buffer
+            if (other.offset >= prev_end)
+            {
+                size_t gap = other.offset - prev_end;
+                if (gap >= buffer.size && gap < best_gap)
+                {
+                    best_gap = gap;
+                    best_offset = prev_end;
+                }
+            }
+            prev_end = std::max(prev_end, other.offset + other.size);
+        }
+
+        buffer.offset = best_offset != std::numeric_limits<size_t>::max() ? best_offset : prev_end;
+        plan.arena_size = std::max(plan.arena_size, buffer.offset + buffer.size);
+
+        placed.insert(index, buffer.first_step, buffer.last_step);
+    }
+
+    return plan;
+}
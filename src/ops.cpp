@@ -0,0 +1,852 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "conv.h"
+#include "gemm.h"
+#include "ops.h"
+#include "thread_pool.h"
+
+// минимальная работа на часть при делении ядра между потоками: меньшие части
+// не окупают постановку задачи (умножений-сложений и элементов соответственно)
+static constexpr int64_t INTRA_OP_MIN_WORK = 1 << 18;
+static constexpr size_t INTRA_OP_MIN_ELEMENTS = 1 << 15;
+
+// проверка наличия обязательного входа
+static const Value& require_input(const Node& node, const std::vector<const Value*>& inputs, size_t i)
+{
+    if (i >= inputs.size() || inputs[i] == nullptr)
+    {
+        throw std::runtime_error(node.get_op_type() + ": нет входа #" + std::to_string(i));
+    }
+    return *inputs[i];
+}
+
+// вход, который должен быть float-тензором
+static const Value& require_float(const Node& node, const std::vector<const Value*>& inputs, size_t i)
+{
+    const Value& value = require_input(node, inputs, i);
+    if (value.get_data_type() != FLOAT)
+    {
+        throw std::runtime_error(node.get_op_type() + ": вход #" + std::to_string(i) + " должен быть float");
+    }
+    return value;
+}
+
+// необязательный вход (nullptr, если его нет)
+static const Value* optional_input(const std::vector<const Value*>& inputs, size_t i)
+{
+    return i < inputs.size() ? inputs[i] : nullptr;
+}
+
+// отрицательная ось → положительная
+static size_t normalize_axis(int64_t axis, size_t rank, const std::string& op_type)
+{
+    if (axis < 0) axis += static_cast<int64_t>(rank);
+    if (axis < 0 || axis >= static_cast<int64_t>(rank))
+    {
+        throw std::runtime_error(op_type + ": ось вне диапазона");
+    }
+    return static_cast<size_t>(axis);
+}
+
+std::vector<int64_t> broadcast_shape(const std::vector<int64_t>& a, const std::vector<int64_t>& b)
+{
+    size_t rank = std::max(a.size(), b.size());
+    std::vector<int64_t> result(rank);
+
+    for (size_t i = 0; i < rank; i++)
+    {
+        int64_t da = i < rank - a.size() ? 1 : a[i - (rank - a.size())];
+        int64_t db = i < rank - b.size() ? 1 : b[i - (rank - b.size())];
+
+        if (da != db && da != 1 && db != 1)
+        {
+            throw std::runtime_error("Формы несовместимы для broadcasting");
+        }
+        result[i] = da == 1 ? db : da;
+    }
+
+    return result;
+}
+
+// шаги по элементам для чтения тензора формы shape как тензора формы out_shape
+// (по размерностям, растянутым broadcasting'ом, шаг равен 0)
+static std::vector<size_t> broadcast_strides(const std::vector<int64_t>& shape, const std::vector<int64_t>& out_shape)
+{
+    size_t rank = out_shape.size();
+    std::vector<size_t> strides(rank, 0);
+    size_t stride = 1;
+
+    for (size_t i = shape.size(); i-- > 0;)
+    {
+        size_t out_i = i + (rank - shape.size());
+        strides[out_i] = shape[i] == 1 ? 0 : stride;
+        stride *= static_cast<size_t>(shape[i]);
+    }
+
+    return strides;
+}
+
+// поэлементная бинарная операция с broadcasting; out не должен совпадать с a или b
+template <typename Fn>
+static void broadcast_binary(const Value& a, const Value& b, Value& out, Fn fn)
+{
+    std::vector<int64_t> out_shape = broadcast_shape(a.get_shape(), b.get_shape());
+    out.bind_output(out_shape);
+
+    const float* pa = a.data();
+    const float* pb = b.data();
+    float* po = out.data();
+    size_t count = out.element_count();
+
+    // быстрые пути: одинаковые формы и скаляр справа (непрерывными частями по потокам)
+    if (a.get_shape() == b.get_shape())
+    {
+        parallel_for(0, count, INTRA_OP_MIN_ELEMENTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) po[i] = fn(pa[i], pb[i]);
+        });
+        return;
+    }
+
+    if (b.element_count() == 1 && a.get_shape() == out_shape)
+    {
+        parallel_for(0, count, INTRA_OP_MIN_ELEMENTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) po[i] = fn(pa[i], pb[0]);
+        });
+        return;
+    }
+
+    // общий случай: многомерный счётчик по выходу
+    size_t rank = out_shape.size();
+    std::vector<size_t> sa = broadcast_strides(a.get_shape(), out_shape);
+    std::vector<size_t> sb = broadcast_strides(b.get_shape(), out_shape);
+    std::vector<int64_t> index(rank, 0);
+    size_t ia = 0, ib = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        po[i] = fn(pa[ia], pb[ib]);
+
+        for (size_t d = rank; d-- > 0;)
+        {
+            ia += sa[d];
+            ib += sb[d];
+            if (++index[d] < out_shape[d]) break;
+
+            ia -= sa[d] * out_shape[d];
+            ib -= sb[d] * out_shape[d];
+            index[d] = 0;
+        }
+    }
+}
+
+// слитые эпилоги узла (Graph::fuse_epilogues) внутри ядра Conv/Gemm/MatMul: применяются
+// к каждому готовому отрезку выхода, пока он в кэше, а не отдельным проходом по всему
+// выходу. Отрезок задаётся адресом внутри выхода: его положение — смещение от начала.
+// Если операнд Add/Mul растягивает выход (результат больше выхода ядра), эпилоги
+// применяются после ядра обычным apply_fused_op (finish)
+class FusedEpilogue
+{
+private:
+    enum class Kind { RELU, ADD, MUL };
+
+    struct Step
+    {
+        Kind kind;
+        const float* operand = nullptr;
+        size_t operand_count = 0;
+        std::vector<size_t> strides;   // шаги операнда по осям выхода (0 — растянутая ось)
+    };
+
+    const Node& node;
+    const std::vector<const Value*>& inputs;
+    const float* base = nullptr;
+    std::vector<int64_t> shape;
+    size_t count = 0;
+    std::vector<Step> steps;
+    bool separate = false;             // эпилоги — отдельным проходом после ядра
+    GemmEpilogue callback;
+
+    // смещение в операнде для элемента i выхода
+    size_t operand_offset(const Step& step, size_t i) const
+    {
+        size_t offset = 0;
+        for (size_t d = shape.size(); d-- > 0;)
+        {
+            size_t dim = static_cast<size_t>(shape[d]);
+            offset += (i % dim) * step.strides[d];
+            i /= dim;
+        }
+        return offset;
+    }
+
+    template <typename Fn>
+    void apply_operand(const Step& step, float* run, size_t first, size_t length, Fn fn) const
+    {
+        if (step.operand_count == count)
+        {
+            const float* po = step.operand + first;
+            for (size_t i = 0; i < length; i++) run[i] = fn(run[i], po[i]);
+            return;
+        }
+        if (step.operand_count == 1)
+        {
+            const float value = step.operand[0];
+            for (size_t i = 0; i < length; i++) run[i] = fn(run[i], value);
+            return;
+        }
+
+        // по строкам последней оси: внутри строки шаг операнда постоянный
+        const size_t row = static_cast<size_t>(shape.back());
+        const size_t inner = step.strides.back();
+        size_t i = 0;
+        while (i < length)
+        {
+            size_t col = (first + i) % row;
+            size_t span = std::min(row - col, length - i);
+            const float* po = step.operand + operand_offset(step, first + i);
+            for (size_t q = 0; q < span; q++) run[i + q] = fn(run[i + q], po[q * inner]);
+            i += span;
+        }
+    }
+
+    static void apply_callback(const void* context, float* run, size_t length)
+    {
+        static_cast<const FusedEpilogue*>(context)->apply(run, length);
+    }
+
+public:
+    // out — уже привязанный выход ядра (bind_output)
+    FusedEpilogue(const Node& fused_node, const std::vector<const Value*>& node_inputs, Value& out)
+        : node(fused_node), inputs(node_inputs), base(out.data()), shape(out.get_shape()),
+          count(out.element_count()), callback{&FusedEpilogue::apply_callback, this}
+    {
+        for (const FusedOp& op : node.get_fused())
+        {
+            Step step;
+            if (op.op_type == "Relu") step.kind = Kind::RELU;
+            else if (op.op_type == "Add") step.kind = Kind::ADD;
+            else if (op.op_type == "Mul") step.kind = Kind::MUL;
+            else throw std::runtime_error("Слитая операция не поддерживается: " + op.op_type);
+
+            if (step.kind != Kind::RELU)
+            {
+                const Value* operand = op.operand >= 0 ? optional_input(inputs, op.operand) : nullptr;
+                if (operand == nullptr || operand->get_data_type() != FLOAT)
+                {
+                    throw std::runtime_error(op.op_type + " (слитый): нет float-операнда");
+                }
+                if (broadcast_shape(shape, operand->get_shape()) != shape)
+                {
+                    separate = true;
+                    return;
+                }
+                step.operand = operand->data();
+                step.operand_count = operand->element_count();
+                step.strides = broadcast_strides(operand->get_shape(), shape);
+            }
+            steps.push_back(std::move(step));
+        }
+    }
+
+    FusedEpilogue(const FusedEpilogue&) = delete;
+    FusedEpilogue& operator=(const FusedEpilogue&) = delete;
+
+    // для sgemm и conv2d: nullptr — эпилогов нет или они идут отдельным проходом
+    const GemmEpilogue* get() const { return steps.empty() || separate ? nullptr : &callback; }
+
+    // все эпилоги по порядку над отрезком run выхода
+    void apply(float* run, size_t length) const
+    {
+        const size_t first = static_cast<size_t>(run - base);
+        for (const Step& step : steps)
+        {
+            switch (step.kind)
+            {
+            case Kind::RELU:
+                for (size_t i = 0; i < length; i++) run[i] = run[i] > 0.0f ? run[i] : 0.0f;
+                break;
+            case Kind::ADD:
+                apply_operand(step, run, first, length, [](float x, float y) { return x + y; });
+                break;
+            case Kind::MUL:
+                apply_operand(step, run, first, length, [](float x, float y) { return x * y; });
+                break;
+            }
+        }
+    }
+
+    // после ядра: эпилоги, которые нельзя было применить по отрезкам
+    void finish(Value& out) const
+    {
+        if (!separate) return;
+        for (const FusedOp& op : node.get_fused())
+        {
+            apply_fused_op(op, op.operand >= 0 ? optional_input(inputs, op.operand) : nullptr, out);
+        }
+    }
+};
+
+// свёртка NCHW: алгоритм выбирается по геометрии (см. choose_conv_algorithm)
+void op_conv(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    const Value& x = require_float(node, inputs, 0);
+    const Value& w = require_float(node, inputs, 1);
+    const Value* bias = optional_input(inputs, 2);
+
+    ConvGeometry g = conv_geometry(node, x.get_shape(), w.get_shape());
+    if (bias && bias->element_count() != static_cast<size_t>(g.out_channels))
+    {
+        throw std::runtime_error("Conv: размер bias не равен числу выходных каналов");
+    }
+
+    Value& out = outputs[0];
+    out.bind_output({g.batch, g.out_channels, g.out_h, g.out_w});
+
+    ConvAlgorithm algorithm = choose_conv_algorithm(g);
+    const float* pb = bias ? bias->data() : nullptr;
+    FusedEpilogue epilogue(node, inputs, out);
+
+    // im2col и Winograd при group == 1 делятся внутри sgemm по пространственным столбцам:
+    // деление по каналам повторило бы в каждой части преобразование всего входа
+    if (g.group == 1 && algorithm != ConvAlgorithm::DIRECT)
+    {
+        conv2d(algorithm, g, x.data(), w.data(), pb, out.data(), w.winograd_data(), epilogue.get());
+        epilogue.finish(out);
+        return;
+    }
+
+    // остальные — по выходным каналам (при group > 1 — по целым группам): части не делят
+    // работу над входом, и каждая читает только свои строки весов
+    const bool by_group = g.group > 1;
+    const int64_t units = by_group ? g.group : g.out_channels;
+    const int64_t channels_per_unit = by_group ? g.out_channels / g.group : 1;
+    const int64_t in_per_unit = by_group ? g.in_channels / g.group : g.in_channels;
+    const int64_t unit_work = channels_per_unit * (g.in_channels / g.group) * g.kernel_h * g.kernel_w *
+                              g.out_h * g.out_w * g.batch;
+    const size_t grain = static_cast<size_t>(std::max<int64_t>(1, INTRA_OP_MIN_WORK / std::max<int64_t>(unit_work, 1)));
+
+    if (parallel_parts(static_cast<size_t>(units), grain) == 1)
+    {
+        conv2d(algorithm, g, x.data(), w.data(), pb, out.data(), nullptr, epilogue.get());
+        epilogue.finish(out);
+        return;
+    }
+
+    const int64_t in_plane = g.in_h * g.in_w;
+    const int64_t out_plane = g.out_h * g.out_w;
+    const int64_t w_per_channel = (g.in_channels / g.group) * g.kernel_h * g.kernel_w;
+
+    parallel_for(0, static_cast<size_t>(units), grain, [&](size_t u0, size_t u1) {
+        // та же свёртка над частью каналов, по одному примеру батча
+        ConvGeometry part = g;
+        int64_t count = static_cast<int64_t>(u1 - u0);
+        part.batch = 1;
+        part.out_channels = count * channels_per_unit;
+        part.in_channels = by_group ? count * in_per_unit : g.in_channels;
+        part.group = by_group ? count : 1;
+
+        ConvAlgorithm part_algorithm = conv_algorithm_supported(algorithm, part) ? algorithm
+                                                                                  : choose_conv_algorithm(part);
+        int64_t first_channel = static_cast<int64_t>(u0) * channels_per_unit;
+        int64_t first_input = by_group ? static_cast<int64_t>(u0) * in_per_unit : 0;
+
+        for (int64_t n = 0; n < g.batch; n++)
+        {
+            conv2d(part_algorithm, part, x.data() + (n * g.in_channels + first_input) * in_plane,
+                   w.data() + first_channel * w_per_channel, pb ? pb + first_channel : nullptr,
+                   out.data() + (n * g.out_channels + first_channel) * out_plane, nullptr, epilogue.get());
+        }
+    });
+    epilogue.finish(out);
+}
+
+ConvGeometry conv_geometry(const Node& node, const std::vector<int64_t>& x_shape, const std::vector<int64_t>& w_shape)
+{
+    if (x_shape.size() != 4 || w_shape.size() != 4)
+    {
+        throw std::runtime_error("Conv: поддерживаются только 2D-свёртки (NCHW)");
+    }
+
+    ConvGeometry g;
+    g.batch = x_shape[0];
+    g.in_channels = x_shape[1];
+    g.in_h = x_shape[2];
+    g.in_w = x_shape[3];
+    g.out_channels = w_shape[0];
+    g.group = node.get_int("group", 1);
+
+    std::vector<int64_t> kernel = node.get_ints("kernel_shape", {w_shape[2], w_shape[3]});
+    std::vector<int64_t> strides = node.get_ints("strides", {1, 1});
+    std::vector<int64_t> dilations = node.get_ints("dilations", {1, 1});
+    std::vector<int64_t> pads = node.get_ints("pads", {0, 0, 0, 0});
+    std::string auto_pad = node.get_string("auto_pad", "NOTSET");
+
+    if (kernel.size() != 2 || strides.size() != 2 || dilations.size() != 2 || pads.size() != 4)
+    {
+        throw std::runtime_error("Conv: неверная длина атрибутов strides/dilations/pads");
+    }
+    if (g.group <= 0 || g.in_channels % g.group != 0 || g.out_channels % g.group != 0 ||
+        w_shape[1] != g.in_channels / g.group)
+    {
+        throw std::runtime_error("Conv: число каналов не согласовано с group");
+    }
+
+    g.kernel_h = kernel[0];
+    g.kernel_w = kernel[1];
+    g.stride_h = strides[0];
+    g.stride_w = strides[1];
+    g.dilation_h = dilations[0];
+    g.dilation_w = dilations[1];
+
+    int64_t extent_h = (g.kernel_h - 1) * g.dilation_h + 1;
+    int64_t extent_w = (g.kernel_w - 1) * g.dilation_w + 1;
+
+    if (auto_pad == "SAME_UPPER" || auto_pad == "SAME_LOWER")
+    {
+        // выход = ceil(вход / stride), недостающее добивается паддингом
+        g.out_h = (g.in_h + g.stride_h - 1) / g.stride_h;
+        g.out_w = (g.in_w + g.stride_w - 1) / g.stride_w;
+
+        int64_t total_h = std::max<int64_t>(0, (g.out_h - 1) * g.stride_h + extent_h - g.in_h);
+        int64_t total_w = std::max<int64_t>(0, (g.out_w - 1) * g.stride_w + extent_w - g.in_w);
+        bool upper = auto_pad == "SAME_UPPER";
+
+        g.pad_top = upper ? total_h / 2 : total_h - total_h / 2;
+        g.pad_left = upper ? total_w / 2 : total_w - total_w / 2;
+        g.pad_bottom = total_h - g.pad_top;
+        g.pad_right = total_w - g.pad_left;
+    }
+    else
+    {
+        bool valid = auto_pad == "VALID";
+        g.pad_top = valid ? 0 : pads[0];
+        g.pad_left = valid ? 0 : pads[1];
+        g.pad_bottom = valid ? 0 : pads[2];
+        g.pad_right = valid ? 0 : pads[3];
+
+        g.out_h = (g.in_h + g.pad_top + g.pad_bottom - extent_h) / g.stride_h + 1;
+        g.out_w = (g.in_w + g.pad_left + g.pad_right - extent_w) / g.stride_w + 1;
+    }
+
+    if (g.out_h <= 0 || g.out_w <= 0)
+    {
+        throw std::runtime_error("Conv: пустой выход");
+    }
+
+    return g;
+}
+
+// value = fn(value, operand) на месте, если операнд растягивается до формы value;
+// иначе (результат больше value) — обычная операция с broadcasting
+template <typename Fn>
+static void apply_in_place(Value& value, const Value& operand, Fn fn)
+{
+    const std::vector<int64_t> shape = value.get_shape();
+    if (broadcast_shape(shape, operand.get_shape()) != shape)
+    {
+        Value result;
+        broadcast_binary(value, operand, result, fn);
+        value = std::move(result);
+        return;
+    }
+
+    float* pv = value.data();
+    const float* po = operand.data();
+    size_t count = value.element_count();
+
+    // одинаковое число элементов — формы отличаются только единичными осями
+    if (operand.element_count() == count)
+    {
+        parallel_for(0, count, INTRA_OP_MIN_ELEMENTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) pv[i] = fn(pv[i], po[i]);
+        });
+        return;
+    }
+
+    if (operand.element_count() == 1)
+    {
+        parallel_for(0, count, INTRA_OP_MIN_ELEMENTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) pv[i] = fn(pv[i], po[0]);
+        });
+        return;
+    }
+
+    // общий случай: многомерный счётчик по выходу, шаги операнда с нулями
+    size_t rank = shape.size();
+    std::vector<size_t> so = broadcast_strides(operand.get_shape(), shape);
+    std::vector<int64_t> index(rank, 0);
+    size_t io = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        pv[i] = fn(pv[i], po[io]);
+
+        for (size_t d = rank; d-- > 0;)
+        {
+            io += so[d];
+            if (++index[d] < shape[d]) break;
+
+            io -= so[d] * shape[d];
+            index[d] = 0;
+        }
+    }
+}
+
+void apply_fused_op(const FusedOp& op, const Value* operand, Value& value)
+{
+    if (value.get_data_type() != FLOAT)
+    {
+        throw std::runtime_error(op.op_type + " (слитый): выход должен быть float");
+    }
+
+    if (op.op_type == "Relu")
+    {
+        float* pv = value.data();
+        parallel_for(0, value.element_count(), INTRA_OP_MIN_ELEMENTS, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) pv[i] = pv[i] > 0.0f ? pv[i] : 0.0f;
+        });
+        return;
+    }
+
+    if (operand == nullptr || operand->get_data_type() != FLOAT)
+    {
+        throw std::runtime_error(op.op_type + " (слитый): нет float-операнда");
+    }
+
+    if (op.op_type == "Add")
+    {
+        apply_in_place(value, *operand, [](float x, float y) { return x + y; });
+    }
+    else if (op.op_type == "Mul")
+    {
+        apply_in_place(value, *operand, [](float x, float y) { return x * y; });
+    }
+    else
+    {
+        throw std::runtime_error("Слитая операция не поддерживается: " + op.op_type);
+    }
+}
+
+void op_relu(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    const Value& x = require_float(node, inputs, 0);
+    Value& out = outputs[0];
+    out.bind_output(x.get_shape());
+
+    const float* px = x.data();
+    float* po = out.data();
+    parallel_for(0, out.element_count(), INTRA_OP_MIN_ELEMENTS, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) po[i] = px[i] > 0.0f ? px[i] : 0.0f;
+    });
+}
+
+// Y = alpha * A' * B' + beta * C
+void op_gemm(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    const Value& a = require_float(node, inputs, 0);
+    const Value& b = require_float(node, inputs, 1);
+    const Value* c = optional_input(inputs, 2);
+
+    if (a.get_shape().size() != 2 || b.get_shape().size() != 2)
+    {
+        throw std::runtime_error("Gemm: входы должны быть матрицами");
+    }
+
+    bool trans_a = node.get_int("transA", 0) != 0;
+    bool trans_b = node.get_int("transB", 0) != 0;
+    float alpha = node.get_float("alpha", 1.0f);
+    float beta = node.get_float("beta", 1.0f);
+
+    int64_t m = trans_a ? a.get_shape()[1] : a.get_shape()[0];
+    int64_t k = trans_a ? a.get_shape()[0] : a.get_shape()[1];
+    int64_t kb = trans_b ? b.get_shape()[1] : b.get_shape()[0];
+    int64_t n = trans_b ? b.get_shape()[0] : b.get_shape()[1];
+
+    if (k != kb)
+    {
+        throw std::runtime_error("Gemm: внутренние размерности не совпадают");
+    }
+
+    std::vector<int64_t> out_shape = {m, n};
+    Value& out = outputs[0];
+    out.bind_output(out_shape);
+
+    // C растягивается до [M, N] (однонаправленный broadcasting) и идёт в sgemm как beta * C
+    bool use_c = c && beta != 0.0f;
+    if (use_c)
+    {
+        if (broadcast_shape(out_shape, c->get_shape()) != out_shape)
+        {
+            throw std::runtime_error("Gemm: C не растягивается до [M, N]");
+        }
+
+        std::vector<size_t> sc = broadcast_strides(c->get_shape(), out_shape);
+        const float* pc = c->data();
+        float* po = out.data();
+        for (int64_t i = 0; i < m; i++)
+        {
+            for (int64_t j = 0; j < n; j++)
+            {
+                po[i * n + j] = pc[i * sc[0] + j * sc[1]];
+            }
+        }
+    }
+
+    // длины строк — по физическим формам A и B; слитые эпилоги — по плиткам C
+    FusedEpilogue epilogue(node, inputs, out);
+    sgemm(trans_a, trans_b, m, n, k, alpha, a.data(), a.get_shape()[1], b.data(), b.get_shape()[1],
+          use_c ? beta : 0.0f, out.data(), n, epilogue.get());
+    epilogue.finish(out);
+}
+
+// матричное умножение numpy: [..., M, K] x [..., K, N] с broadcasting по батчу
+void op_matmul(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    const Value& a = require_float(node, inputs, 0);
+    const Value& b = require_float(node, inputs, 1);
+
+    std::vector<int64_t> sa = a.get_shape();
+    std::vector<int64_t> sb = b.get_shape();
+    if (sa.empty() || sb.empty())
+    {
+        throw std::runtime_error("MatMul: скалярные входы не поддерживаются");
+    }
+
+    // векторы дополняются до матриц, лишняя размерность потом убирается
+    bool a_vector = sa.size() == 1;
+    bool b_vector = sb.size() == 1;
+    if (a_vector) sa.insert(sa.begin(), 1);
+    if (b_vector) sb.push_back(1);
+
+    int64_t m = sa[sa.size() - 2];
+    int64_t k = sa[sa.size() - 1];
+    int64_t n = sb[sb.size() - 1];
+    if (sb[sb.size() - 2] != k)
+    {
+        throw std::runtime_error("MatMul: внутренние размерности не совпадают");
+    }
+
+    std::vector<int64_t> batch_a(sa.begin(), sa.end() - 2);
+    std::vector<int64_t> batch_b(sb.begin(), sb.end() - 2);
+    std::vector<int64_t> batch = broadcast_shape(batch_a, batch_b);
+
+    std::vector<size_t> stride_a = broadcast_strides(batch_a, batch);
+    std::vector<size_t> stride_b = broadcast_strides(batch_b, batch);
+    size_t batch_count = shape_size(batch);
+
+    std::vector<int64_t> out_shape = batch;
+    if (!a_vector) out_shape.push_back(m);
+    if (!b_vector) out_shape.push_back(n);
+    Value& out = outputs[0];
+    out.bind_output(out_shape);
+    FusedEpilogue epilogue(node, inputs, out);
+
+    // B общая для всего батча (веса слоя), A не растянута: батч сливается
+    // с M в одно умножение [batch * M, K] x [K, N]
+    if (shape_size(batch_b) == 1 && shape_size(batch_a) == batch_count)
+    {
+        sgemm(false, false, batch_count * m, n, k, 1.0f, a.data(), k, b.data(), n, 0.0f, out.data(), n,
+              epilogue.get());
+        epilogue.finish(out);
+        return;
+    }
+
+    std::vector<int64_t> index(batch.size(), 0);
+    for (size_t bi = 0; bi < batch_count; bi++)
+    {
+        size_t offset_a = 0, offset_b = 0;
+        for (size_t d = 0; d < batch.size(); d++)
+        {
+            offset_a += index[d] * stride_a[d];
+            offset_b += index[d] * stride_b[d];
+        }
+
+        sgemm(false, false, m, n, k, 1.0f, a.data() + offset_a * m * k, k, b.data() + offset_b * k * n, n,
+              0.0f, out.data() + bi * m * n, n, epilogue.get());
+
+        for (size_t d = batch.size(); d-- > 0;)
+        {
+            if (++index[d] < batch[d]) break;
+            index[d] = 0;
+        }
+    }
+    epilogue.finish(out);
+}
+
+void op_add(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    broadcast_binary(require_float(node, inputs, 0), require_float(node, inputs, 1), outputs[0],
+                     [](float x, float y) { return x + y; });
+}
+
+void op_mul(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    broadcast_binary(require_float(node, inputs, 0), require_float(node, inputs, 1), outputs[0],
+                     [](float x, float y) { return x * y; });
+}
+
+// новая форма из тензора shape: 0 — скопировать размерность (если не allowzero), -1 — вывести
+void op_reshape(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    const Value& data = require_input(node, inputs, 0);
+    const Value& shape = require_input(node, inputs, 1);
+
+    if (shape.get_data_type() != INT64)
+    {
+        throw std::runtime_error("Reshape: форма должна быть int64");
+    }
+
+    bool allow_zero = node.get_int("allowzero", 0) != 0;
+    const std::vector<int64_t>& requested = shape.int_data();
+    const std::vector<int64_t>& in_shape = data.get_shape();
+
+    std::vector<int64_t> out_shape(requested.size());
+    int64_t known = 1;
+    int infer_axis = -1;
+
+    for (size_t i = 0; i < requested.size(); i++)
+    {
+        int64_t dim = requested[i];
+
+        if (dim == 0 && !allow_zero)
+        {
+            if (i >= in_shape.size()) throw std::runtime_error("Reshape: нет размерности для копирования");
+            dim = in_shape[i];
+        }
+
+        if (dim == -1)
+        {
+            if (infer_axis >= 0) throw std::runtime_error("Reshape: больше одной размерности -1");
+            infer_axis = static_cast<int>(i);
+            continue;
+        }
+
+        out_shape[i] = dim;
+        known *= dim;
+    }
+
+    if (infer_axis >= 0)
+    {
+        int64_t total = static_cast<int64_t>(data.element_count());
+        if (known == 0 || total % known != 0) throw std::runtime_error("Reshape: нельзя вывести размерность -1");
+        out_shape[infer_axis] = total / known;
+    }
+
+    if (data.get_data_type() == INT64)
+    {
+        Value out = data;
+        out.reshape(std::move(out_shape));
+        outputs[0] = std::move(out);
+        return;
+    }
+
+    // float-данные копируются в место выхода (в арене — без выделения памяти)
+    if (shape_size(out_shape) != data.element_count())
+    {
+        throw std::runtime_error("Reshape: число элементов не совпадает");
+    }
+    Value& out = outputs[0];
+    out.bind_output(std::move(out_shape));
+    std::copy(data.data(), data.data() + data.element_count(), out.data());
+}
+
+void op_concat(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    const Value& first = require_input(node, inputs, 0);
+    const std::vector<int64_t>& base = first.get_shape();
+    size_t axis = normalize_axis(node.get_int("axis", 0), base.size(), "Concat");
+    bool is_int = first.get_data_type() == INT64;
+
+    std::vector<int64_t> out_shape = base;
+    out_shape[axis] = 0;
+
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        const Value& in = require_input(node, inputs, i);
+        const std::vector<int64_t>& s = in.get_shape();
+
+        if (s.size() != base.size() || (in.get_data_type() == INT64) != is_int)
+        {
+            throw std::runtime_error("Concat: входы разного ранга или типа");
+        }
+        for (size_t d = 0; d < s.size(); d++)
+        {
+            if (d != axis && s[d] != base[d]) throw std::runtime_error("Concat: формы не совпадают");
+        }
+        out_shape[axis] += s[axis];
+    }
+
+    // внешний цикл — по размерностям до оси, внутри — копирование блоков
+    size_t outer = shape_size(std::vector<int64_t>(base.begin(), base.begin() + axis));
+    size_t inner = shape_size(std::vector<int64_t>(base.begin() + axis + 1, base.end()));
+
+    if (is_int)
+    {
+        std::vector<int64_t> ints;
+        ints.reserve(shape_size(out_shape));
+        for (size_t o = 0; o < outer; o++)
+        {
+            for (const Value* in : inputs)
+            {
+                size_t block = static_cast<size_t>(in->get_shape()[axis]) * inner;
+                const int64_t* src = in->int_data().data() + o * block;
+                ints.insert(ints.end(), src, src + block);
+            }
+        }
+        outputs[0] = Value::of_ints(out_shape, std::move(ints));
+        return;
+    }
+
+    Value& out = outputs[0];
+    out.bind_output(out_shape);
+    float* dst = out.data();
+
+    for (size_t o = 0; o < outer; o++)
+    {
+        for (const Value* in : inputs)
+        {
+            size_t block = static_cast<size_t>(in->get_shape()[axis]) * inner;
+            const float* src = in->data() + o * block;
+            dst = std::copy(src, src + block, dst);
+        }
+    }
+}
+
+// форма входа как int64-вектор, срез [start, end)
+std::vector<int64_t> shape_slice(const Node& node, const std::vector<int64_t>& shape)
+{
+    int64_t rank = static_cast<int64_t>(shape.size());
+
+    int64_t start = node.get_int("start", 0);
+    int64_t end = node.get_int("end", rank);
+    if (start < 0) start += rank;
+    if (end < 0) end += rank;
+    start = std::clamp<int64_t>(start, 0, rank);
+    end = std::clamp<int64_t>(end, start, rank);
+
+    return std::vector<int64_t>(shape.begin() + start, shape.begin() + end);
+}
+
+void op_shape(const Node& node, const std::vector<const Value*>& inputs, std::vector<Value>& outputs)
+{
+    std::vector<int64_t> dims = shape_slice(node, require_input(node, inputs, 0).get_shape());
+    int64_t count = static_cast<int64_t>(dims.size());
+    outputs[0] = Value::of_ints({count}, std::move(dims));
+}
+
+OpKernel find_kernel(const std::string& op_type)
+{
+    if (op_type == "Conv") return op_conv;
+    if (op_type == "Relu") return op_relu;
+    if (op_type == "Gemm") return op_gemm;
+    if (op_type == "MatMul") return op_matmul;
+    if (op_type == "Add") return op_add;
+    if (op_type == "Mul") return op_mul;
+    if (op_type == "Reshape") return op_reshape;
+    if (op_type == "Concat") return op_concat;
+    if (op_type == "Shape") return op_shape;
+    return nullptr;
+}
@@ -0,0 +1,319 @@
+#include "parse_profile.h"
+
+#ifdef ONNX_PARSE_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define PARSE_PROFILE_HAS_RUSAGE 1
+#endif
+
+static constexpr size_t PHASE_COUNT = static_cast<size_t>(ParsePhase::COUNT);
+
+// событий трассировки в сеансе не больше: 10^6 замеров — около 30 МБ
+static constexpr size_t MAX_TRACE_EVENTS = 1 << 20;
+
+static const char* const PHASE_NAMES[PHASE_COUNT] = {
+    "load", "parse", "parseGraph", "parseNode", "parseAttribute", "parseTensor", "parseValueInfo",
+    "read_varint", "read_bytes"};
+
+// итоги фазы, общие для потоков
+struct PhaseTotals
+{
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<int64_t> total_ns{0};
+    std::atomic<int64_t> self_ns{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> allocated_bytes{0};
+    std::atomic<uint64_t> sampled_calls{0};
+    std::atomic<int64_t> sampled_ns{0};
+};
+
+// замер для трассировки
+struct TraceEvent
+{
+    ParsePhase phase;
+    uint32_t tid;
+    int64_t start;   // от начала сеанса
+    int64_t duration;
+    uint64_t bytes;
+};
+
+static PhaseTotals totals[PHASE_COUNT];
+static std::atomic<size_t> total_allocations{0};
+static std::atomic<uint32_t> next_tid{0};
+static std::atomic<int64_t> session_start{0};
+static std::atomic<bool> tracing{false};
+static std::atomic<size_t> dropped_events{0};
+static int64_t clock_overhead_ns = 0;   // пара вызовов часов: вычитается из выборки чтений
+
+static std::mutex trace_mutex;
+static std::vector<TraceEvent> trace_events;
+
+#ifdef PARSE_PROFILE_HAS_RUSAGE
+static struct rusage session_usage;
+#endif
+
+// счётчики чтений потока → общие итоги
+static void flush_reads(ParseProfileThread& thread)
+{
+    for (size_t kind = 0; kind < 2; kind++)
+    {
+        if (thread.read_calls[kind] == 0) continue;
+
+        PhaseTotals& phase = totals[static_cast<size_t>(ParsePhase::VARINT) + kind];
+        phase.calls.fetch_add(thread.read_calls[kind], std::memory_order_relaxed);
+        phase.bytes.fetch_add(thread.read_bytes[kind], std::memory_order_relaxed);
+        phase.sampled_calls.fetch_add(thread.sampled_calls[kind], std::memory_order_relaxed);
+        phase.sampled_ns.fetch_add(thread.sampled_ns[kind], std::memory_order_relaxed);
+
+        thread.read_calls[kind] = 0;
+        thread.read_bytes[kind] = 0;
+        thread.sampled_calls[kind] = 0;
+        thread.sampled_ns[kind] = 0;
+    }
+}
+
+ParseProfileScope::ParseProfileScope(ParsePhase scope_phase, uint64_t scope_bytes)
+    : phase(scope_phase), bytes(scope_bytes), start(parse_profile_now()), parent(parse_profile_thread.current)
+{
+    parse_profile_thread.current = this;
+}
+
+ParseProfileScope::~ParseProfileScope()
+{
+    int64_t elapsed = parse_profile_now() - start;
+
+    ParseProfileThread& thread = parse_profile_thread;
+    thread.current = parent;
+    if (parent) parent->children_ns += elapsed;
+
+    PhaseTotals& phase_totals = totals[static_cast<size_t>(phase)];
+    phase_totals.calls.fetch_add(1, std::memory_order_relaxed);
+    phase_totals.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    phase_totals.total_ns.fetch_add(elapsed, std::memory_order_relaxed);
+    phase_totals.self_ns.fetch_add(elapsed - children_ns, std::memory_order_relaxed);
+    phase_totals.allocations.fetch_add(allocations, std::memory_order_relaxed);
+    phase_totals.allocated_bytes.fetch_add(allocated_bytes, std::memory_order_relaxed);
+    flush_reads(thread);
+
+    if (!tracing.load(std::memory_order_relaxed)) return;
+
+    // запись события выделяет память: не приписываем её разбору
+    thread.busy = true;
+    if (thread.tid == 0) thread.tid = next_tid.fetch_add(1, std::memory_order_relaxed) + 1;
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        if (trace_events.size() < MAX_TRACE_EVENTS)
+        {
+            int64_t origin = session_start.load(std::memory_order_relaxed);
+            trace_events.push_back({phase, thread.tid, start - origin, elapsed, bytes});
+        }
+        else
+        {
+            dropped_events.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    thread.busy = false;
+}
+
+void parse_profile_reset(bool trace)
+{
+    ParseProfileThread& thread = parse_profile_thread;
+    thread.busy = true;
+
+    flush_reads(thread);
+    for (PhaseTotals& phase : totals)
+    {
+        phase.calls = 0;
+        phase.bytes = 0;
+        phase.total_ns = 0;
+        phase.self_ns = 0;
+        phase.allocations = 0;
+        phase.allocated_bytes = 0;
+        phase.sampled_calls = 0;
+        phase.sampled_ns = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        trace_events.clear();
+        if (trace) trace_events.reserve(1 << 16);
+    }
+    dropped_events = 0;
+    tracing = trace;
+
+    // цена замера пустого участка: минимум из серии
+    int64_t overhead = INT64_MAX;
+    for (int i = 0; i < 1000; i++)
+    {
+        int64_t begin = parse_profile_now();
+        overhead = std::min(overhead, parse_profile_now() - begin);
+    }
+    clock_overhead_ns = overhead;
+
+#ifdef PARSE_PROFILE_HAS_RUSAGE
+    getrusage(RUSAGE_SELF, &session_usage);
+#endif
+    session_start = parse_profile_now();
+    thread.busy = false;
+}
+
+std::vector<ParsePhaseStats> parse_profile_stats()
+{
+    // чтения вне замеров (теги ModelProto в parse) ещё в счётчиках вызывающего потока
+    flush_reads(parse_profile_thread);
+
+    std::vector<ParsePhaseStats> stats(PHASE_COUNT);
+    for (size_t k = 0; k < PHASE_COUNT; k++)
+    {
+        const PhaseTotals& phase = totals[k];
+        ParsePhaseStats& result = stats[k];
+        result.name = PHASE_NAMES[k];
+        result.calls = phase.calls.load(std::memory_order_relaxed);
+        result.bytes = phase.bytes.load(std::memory_order_relaxed);
+        result.allocations = phase.allocations.load(std::memory_order_relaxed);
+        result.allocated_bytes = phase.allocated_bytes.load(std::memory_order_relaxed);
+
+        uint64_t sampled_calls = phase.sampled_calls.load(std::memory_order_relaxed);
+        if (k >= static_cast<size_t>(ParsePhase::VARINT))
+        {
+            // среднее по выборке без цены самих часов, умноженное на все вызовы
+            result.estimated = true;
+            if (sampled_calls == 0) continue;
+            double net = static_cast<double>(phase.sampled_ns.load(std::memory_order_relaxed)) -
+                         static_cast<double>(sampled_calls) * static_cast<double>(clock_overhead_ns);
+            result.seconds = std::max(0.0, net) / static_cast<double>(sampled_calls) *
+                             static_cast<double>(result.calls) * 1e-9;
+            result.self_seconds = result.seconds;
+        }
+        else
+        {
+            result.seconds = static_cast<double>(phase.total_ns.load(std::memory_order_relaxed)) * 1e-9;
+            result.self_seconds = static_cast<double>(phase.self_ns.load(std::memory_order_relaxed)) * 1e-9;
+        }
+    }
+    return stats;
+}
+
+// миллисекунды для таблицы; "~" — оценка по выборке
+static std::string format_ms(double seconds, bool estimated)
+{
+    std::ostringstream text;
+    text << (estimated ? "~" : "") << std::fixed << std::setprecision(3) << seconds * 1e3;
+    return text.str();
+}
+
+void print_parse_profile(std::ostream& out)
+{
+    std::vector<ParsePhaseStats> stats = parse_profile_stats();
+    double session = static_cast<double>(parse_profile_now() - session_start.load()) * 1e-9;
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "=== Parse profile ===\n"
+        << std::left << std::setw(16) << "phase" << std::right << std::setw(10) << "calls" << std::setw(12)
+        << "total ms" << std::setw(12) << "self ms" << std::setw(11) << "MiB" << std::setw(11) << "MiB/s"
+        << std::setw(10) << "allocs" << std::setw(12) << "alloc KiB" << "\n";
+
+    out << std::fixed;
+    for (const ParsePhaseStats& phase : stats)
+    {
+        if (phase.calls == 0) continue;
+
+        double mib = static_cast<double>(phase.bytes) / (1 << 20);
+        out << std::left << std::setw(16) << phase.name << std::right << std::setw(10) << phase.calls
+            << std::setw(12) << format_ms(phase.seconds, phase.estimated)
+            << std::setw(12) << format_ms(phase.self_seconds, phase.estimated)
+            << std::setprecision(3) << std::setw(11) << mib << std::setprecision(1) << std::setw(11)
+            << (phase.seconds > 0 ? mib / phase.seconds : 0.0) << std::setw(10) << phase.allocations
+            << std::setprecision(1) << std::setw(12) << static_cast<double>(phase.allocated_bytes) / 1024 << "\n";
+    }
+
+    out << std::setprecision(3) << "session " << session * 1e3 << " ms; ~ read time estimated from 1 in "
+        << PARSE_PROFILE_SAMPLE << " calls; time of threads is summed";
+#ifdef PARSE_PROFILE_HAS_RUSAGE
+    // mmap: чтение файла — это отказы страниц во время разбора, а не фаза load
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    out << "\npage faults: " << usage.ru_minflt - session_usage.ru_minflt << " minor, "
+        << usage.ru_majflt - session_usage.ru_majflt << " major (I/O)";
+#endif
+    if (dropped_events > 0) out << "\ntrace events dropped: " << dropped_events.load();
+    out << "\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool write_parse_trace(const std::string& path)
+{
+    std::vector<ParsePhaseStats> stats = parse_profile_stats();
+
+    std::ofstream file(path);
+    if (!file) return false;
+
+    // "X" — событие с длительностью, время в микросекундах
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        bool first = true;
+        for (const TraceEvent& event : trace_events)
+        {
+            file << (first ? "\n" : ",\n") << "{\"name\":\"" << PHASE_NAMES[static_cast<size_t>(event.phase)]
+                 << "\",\"cat\":\"parse\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.tid
+                 << ",\"ts\":" << static_cast<double>(event.start) * 1e-3
+                 << ",\"dur\":" << static_cast<double>(event.duration) * 1e-3
+                 << ",\"args\":{\"bytes\":" << event.bytes << "}}";
+            first = false;
+        }
+    }
+
+    // чтения слишком часты для событий: только итоги
+    file << "\n],\"otherData\":{";
+    for (size_t k = 0; k < stats.size(); k++)
+    {
+        file << (k ? "," : "") << "\"" << stats[k].name << "\":{\"calls\":" << stats[k].calls
+             << ",\"bytes\":" << stats[k].bytes << ",\"ms\":" << stats[k].seconds * 1e3
+             << ",\"allocations\":" << stats[k].allocations << "}";
+    }
+    file << "}}\n";
+    return static_cast<bool>(file);
+}
+
+size_t parse_profile_allocation_count()
+{
+    return total_allocations.load(std::memory_order_relaxed);
+}
+
+// выделения памяти приписываются самому вложенному открытому замеру потока
+void* operator new(size_t size)
+{
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    ParseProfileThread& thread = parse_profile_thread;
+    if (thread.current && !thread.busy)
+    {
+        thread.current->allocations++;
+        thread.current->allocated_bytes += size;
+    }
+
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+#endif
@@ -1,20 +1,27 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "parser.h"
+#include "thread_pool.h"
 
 // очистка строки от мусора
-std::string clean_string(const std::vector<uint8_t>& bytes) 
+std::string_view clean_view(std::string_view bytes) 
 {
-    std::string result;
-    
-    for (uint8_t b : bytes) {
+    size_t len = 0;
+
+    for (char c : bytes) {
+        uint8_t b = static_cast<uint8_t>(c);
+
         // разрешаем только: буквы, цифры, underscore, точка, дефис, слэш, это всё, что может быть в валидном имени тензора ONNX
         if ((b >= 'a' && b <= 'z') || 
             (b >= 'A' && b <= 'Z') || 
             (b >= '0' && b <= '9') ||
             b == '_' || b == '.' || b == '-' || b == '/') {
-            result += static_cast<char>(b);
+            len++;
         }
 
         else 
@@ -23,23 +30,34 @@ std::string clean_string(const std::vector<uint8_t>& bytes)
         }
     }
     
-    return result;
+    return bytes.substr(0, len);
+}
+
+std::string clean_string(std::string_view bytes) 
+{
+    return std::string(clean_view(bytes));
+}
+
+std::string clean_string(const std::vector<uint8_t>& bytes) 
+{
+    return clean_string(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
 }
 
 
 Graph ONNXParser::parse()
 {
+    PARSE_PROFILE_SCOPE(ParsePhase::PARSE, reader.get_buffer()->get_size());
+
     bool graph_parsed = false;
 
     while (!reader.check_eof() && !graph_parsed)
     {
         try
         {
-            uint8_t cur_byte = reader.watch_cur_byte();
-            int wire_type = cur_byte & 0x07;
-            int field_number = cur_byte >> 3;
-
-            reader.read_byte();
+            // тег — varint: номера полей от 16 (например, training_info = 20) двухбайтовые
+            uint64_t tag = reader.read_varint();
+            int wire_type = tag & 0x07;
+            uint64_t field_number = tag >> 3;
 
             switch (field_number)
             {
@@ -52,9 +70,7 @@ Graph ONNXParser::parse()
                 if (wire_type == 2) // LEN
                 {
                     uint64_t len = reader.read_varint();
-                    auto bytes = reader.read_bytes(len);
-
-                    graph.setProducerName(std::string(bytes.begin(), bytes.end()));
+                    graph.setProducerName(std::string(reader.read_string_view(len)));
                 }
                 break;
 
@@ -62,9 +78,7 @@ Graph ONNXParser::parse()
                 if (wire_type == 2) // LEN
                 {
                     uint64_t len = reader.read_varint();
-                    auto bytes = reader.read_bytes(len);
-
-                    graph.setProducerVersion(std::string(bytes.begin(), bytes.end()));
+                    graph.setProducerVersion(std::string(reader.read_string_view(len)));
                 }
                 break;
 
@@ -79,9 +93,9 @@ Graph ONNXParser::parse()
 
             default:
                 if (wire_type == 0) reader.read_varint();
-                else if (wire_type == 1) reader.read_bytes(8);
-                else if (wire_type == 2) { uint64_t l = reader.read_varint(); reader.read_bytes(l); }
-                else if (wire_type == 5) reader.read_bytes(4);
+                else if (wire_type == 1) reader.skip(8);
+                else if (wire_type == 2) { uint64_t l = reader.read_varint(); reader.skip(l); }
+                else if (wire_type == 5) reader.skip(4);
                 break;
             }
         }
@@ -96,12 +110,15 @@ Graph ONNXParser::parse()
         }
     }
 
-    return graph;
+    graph.build_index();
+    return std::move(graph);
 }
 
 // вспомогательная функция для парсинга атрибутов
 void ONNXParser::parseAttribute(Node& node, uint64_t attr_len)
 {
+    PARSE_PROFILE_SCOPE(ParsePhase::ATTRIBUTE, attr_len);
+
     size_t start_pos = reader.get_cur_pos();
     size_t end_pos = start_pos + attr_len;
     
@@ -110,14 +127,18 @@ void ONNXParser::parseAttribute(Node& node, uint64_t attr_len)
     float single_float = 0.0f;
     std::string string_val;
     std::vector<int64_t> ints_vals;
+    std::vector<float> floats_vals;
     bool has_int_value = false;
+    bool has_float_value = false;
+    bool has_string_value = false;
+    int64_t attr_type = ATTR_UNDEFINED;
     
     while (reader.get_cur_pos() < end_pos)
     {
         // проверка: есть ли байт для tag
         if (reader.get_cur_pos() + 1 > end_pos) break;
         
-        uint8_t tag = reader.read_byte();
+        uint64_t tag = reader.read_varint(); // type (поле 20) кодируется двумя байтами
         int field_number = tag >> 3;
         int wire_type = tag & 0x07;
         
@@ -127,16 +148,16 @@ void ONNXParser::parseAttribute(Node& node, uint64_t attr_len)
             {
                 uint64_t len = reader.read_varint();
                 if (reader.get_cur_pos() + len > end_pos) break;
-                auto bytes = reader.read_bytes(len);
-                attr_name = clean_string(bytes);
+                attr_name = clean_string(reader.read_string_view(len));
             }
             break;
             
         case 2: // f (float)
             {
                 if (reader.get_cur_pos() + 4 > end_pos) break;
-                auto bytes = reader.read_bytes(4);
+                ByteView bytes = reader.read_view(4);
                 std::memcpy(&single_float, bytes.data(), 4);
+                has_float_value = true;
             }
             break;
             
@@ -157,25 +178,42 @@ void ONNXParser::parseAttribute(Node& node, uint64_t attr_len)
             }
             break;
             
-        case 6: // s (string) — auto_pad
+        case 4: // s (string) — auto_pad
             {
                 uint64_t len = reader.read_varint();
                 if (reader.get_cur_pos() + len > end_pos) break;
-                auto bytes = reader.read_bytes(len);
-                string_val = clean_string(bytes);
+                string_val = clean_string(reader.read_string_view(len));
+                has_string_value = true;
             }
             break;
             
-        case 7: // floats
+        case 7: // floats: упакованные (LEN) — одним копированием, или по одному fixed32
             {
+                if (wire_type == 5)
+                {
+                    if (reader.get_cur_pos() + 4 > end_pos) break;
+                    float value;
+                    std::memcpy(&value, reader.read_view(4).data(), 4);
+                    floats_vals.push_back(value);
+                    break;
+                }
+
                 uint64_t len = reader.read_varint();
                 if (reader.get_cur_pos() + len > end_pos) break;
-                reader.read_bytes(len);
+                reader.read_packed_floats(len, floats_vals);
             }
             break;
             
-        case 8: // ints (repeated) 
+        case 8: // ints (repeated): по одному varint или упакованные (LEN) целиком
             {
+                if (wire_type == 2)
+                {
+                    uint64_t len = reader.read_varint();
+                    if (reader.get_cur_pos() + len > end_pos) break;
+                    reader.read_packed_varints(len, ints_vals);
+                    break;
+                }
+
                 if (reader.get_cur_pos() < end_pos) 
                 {
                     ints_vals.push_back(reader.read_varint());
@@ -188,11 +226,11 @@ void ONNXParser::parseAttribute(Node& node, uint64_t attr_len)
             }
             break;
             
-        case 20: // type (enum) — просто пропускаем
+        case 20: // type (enum) — по нему решаем, куда сохранить значение
             {
                 if (reader.get_cur_pos() < end_pos) 
                 {
-                    reader.read_varint();
+                    attr_type = static_cast<int64_t>(reader.read_varint());
                 }
             }
             break;
@@ -203,65 +241,73 @@ void ONNXParser::parseAttribute(Node& node, uint64_t attr_len)
             }
             else if (wire_type == 2) { 
                 uint64_t l = reader.read_varint(); 
-                if (reader.get_cur_pos() + l <= end_pos) reader.read_bytes(l);
+                if (reader.get_cur_pos() + l <= end_pos) reader.skip(l);
             }
             else if (wire_type == 5) {
-                if (reader.get_cur_pos() + 4 <= end_pos) reader.read_bytes(4);
+                if (reader.get_cur_pos() + 4 <= end_pos) reader.skip(4);
             }
             break;
         }
     }
     
-    while (reader.get_cur_pos() < end_pos) 
+    if (reader.get_cur_pos() < end_pos) 
     {
-        reader.read_byte();
+        reader.skip(end_pos - reader.get_cur_pos());
     }
     
-    // Сохраняем атрибуты
-    if (!ints_vals.empty() && 
-        (attr_name == "strides" || attr_name == "dilations" || 
-         attr_name == "pads" || attr_name == "kernel_shape" || attr_name == "allowzero"))
-    {
-        node.add_ints_attr(attr_name, ints_vals);
-    }
+    if (attr_name.empty()) return;
 
-    if (has_int_value && single_int != 0 && attr_name == "group")
+    // тип атрибута из поля 20; если его нет (старые файлы) — по найденным полям
+    if (attr_type == ATTR_UNDEFINED)
     {
-        node.add_ints_attr(attr_name, {single_int});
+        if (!ints_vals.empty()) attr_type = ATTR_INTS;
+        else if (!floats_vals.empty()) attr_type = ATTR_FLOATS;
+        else if (has_int_value) attr_type = ATTR_INT;
+        else if (has_float_value) attr_type = ATTR_FLOAT;
+        else if (has_string_value) attr_type = ATTR_STRING;
     }
 
-    if (single_int != 0 && (attr_name == "group" || attr_name == "transA" || attr_name == "transB"))
+    // Сохраняем атрибуты (одиночные int — как список из одного значения)
+    switch (attr_type)
     {
-        node.add_ints_attr(attr_name, {single_int});
-    }
-    
-    // Для allowzero сохраняем даже 0
-    if (attr_name == "allowzero") {
-        node.add_ints_attr(attr_name, {single_int});
-    }
+    case ATTR_INT:
+        if (has_int_value) node.add_ints_attr(std::move(attr_name), {single_int});
+        break;
 
-    if (single_float != 0.0f && (attr_name == "alpha" || attr_name == "beta"))
-    {
-        node.add_float_attr(attr_name, single_float);
-    }
+    case ATTR_INTS:
+        node.add_ints_attr(std::move(attr_name), std::move(ints_vals));
+        break;
 
-    if (!string_val.empty())
-    {
-        node.add_string_attr(attr_name, string_val);
+    case ATTR_FLOAT:
+        if (has_float_value) node.add_float_attr(std::move(attr_name), single_float);
+        break;
+
+    case ATTR_FLOATS:
+        node.add_floats_attr(std::move(attr_name), std::move(floats_vals));
+        break;
+
+    case ATTR_STRING:
+        if (has_string_value) node.add_string_attr(std::move(attr_name), std::move(string_val));
+        break;
+
+    default: // тензоры, графы и списки строк пока не сохраняем
+        break;
     }
 }
 
 // вспомогательная функция для парсинга одной ноды
 Node ONNXParser::parseNode(uint64_t node_size)
 {
+    PARSE_PROFILE_SCOPE(ParsePhase::NODE, node_size);
+
     Node result;
     size_t end_pos = reader.get_cur_pos() + node_size;
     
     while (reader.get_cur_pos() < end_pos)
     {
-        uint8_t cur_byte = reader.read_byte();
-        int wire_type = cur_byte & 0x07;
-        int field_number = cur_byte >> 3;
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
         
         switch (field_number)
         {
@@ -270,8 +316,7 @@ Node ONNXParser::parseNode(uint64_t node_size)
             uint64_t len = reader.read_varint(); // длина очередной строки
             if (reader.get_cur_pos() + len > end_pos) break;
 
-            auto bytes = reader.read_bytes(len);
-            result.add_input(clean_string(bytes));  // добавляем в вектор inputs
+            result.add_input(graph.intern_tensor(clean_view(reader.read_string_view(len))));  // добавляем в вектор inputs
 
             break;
         }
@@ -281,8 +326,7 @@ Node ONNXParser::parseNode(uint64_t node_size)
             uint64_t len = reader.read_varint(); // длина очередной строки
             if (reader.get_cur_pos() + len > end_pos) break;
 
-            auto bytes = reader.read_bytes(len);
-            result.add_output(clean_string(bytes)); // добавляем в вектор outputs
+            result.add_output(graph.intern_tensor(clean_view(reader.read_string_view(len)))); // добавляем в вектор outputs
 
             break;
         }
@@ -292,8 +336,7 @@ Node ONNXParser::parseNode(uint64_t node_size)
             uint64_t len = reader.read_varint();
             if (reader.get_cur_pos() + len > end_pos) break;
 
-            auto bytes = reader.read_bytes(len);
-            result.set_name(clean_string(bytes));
+            result.set_name(clean_string(reader.read_string_view(len)));
 
             break;
         }
@@ -306,8 +349,7 @@ Node ONNXParser::parseNode(uint64_t node_size)
                 break;
             }
 
-            auto bytes = reader.read_bytes(len);
-            result.set_op_type(clean_string(bytes));
+            result.set_op_type(clean_string(reader.read_string_view(len)));
 
             break;
         }
@@ -320,17 +362,17 @@ Node ONNXParser::parseNode(uint64_t node_size)
             break;
         }
             
-        default: // для неизвестных полей внутри узла
+        default: // для неизвестных полей внутри узла (doc_string, domain, ...)
         {
-            if (wire_type == 0) {
-                reader.read_varint();
-                } else if (wire_type == 2) {
-                    uint64_t len = reader.read_varint();
-                    if (reader.get_cur_pos() + len > end_pos) break;
+            if (wire_type == 2) {
+                uint64_t len = reader.read_varint();
+                if (reader.get_cur_pos() + len > end_pos) break;
 
-                    reader.read_bytes(len);
-                }
-                break;
+                reader.skip(len);
+            } else {
+                skipField(wire_type);
+            }
+            break;
         } 
         }
     
@@ -338,7 +380,7 @@ Node ONNXParser::parseNode(uint64_t node_size)
 
     size_t current = reader.get_cur_pos();
     if (current < end_pos) {
-        reader.read_bytes(end_pos - current);  // дочитываем до конца узла
+        reader.skip(end_pos - current);  // дочитываем до конца узла
     }
 
     return result;
@@ -348,23 +390,70 @@ Node ONNXParser::parseNode(uint64_t node_size)
 // вспомогательная функция для парсинга одного тензора
 Tensor ONNXParser::parseTensor(uint64_t tensor_size)
 {
+    PARSE_PROFILE_SCOPE(ParsePhase::TENSOR, tensor_size);
+
     Tensor result;
 
     size_t end_pos = reader.get_cur_pos() + tensor_size;
-    uint8_t cur_byte = reader.watch_cur_byte();
+
+    // значения не из raw_data: поштучные float_data / double_data и целые поля
+    // int32_data / int64_data / uint64_data (varint, упакованные или по одному)
+    std::vector<float> float_values;
+    std::vector<double> double_values;
+    std::vector<int64_t> int_values;
+
+    // внешние данные (data_location = EXTERNAL): файл относительно модели, смещение, длина
+    bool external = false;
+    std::string location;
+    uint64_t external_offset = 0;
+    uint64_t external_length = 0;
+    bool has_external_length = false;
+    std::vector<int64_t> dims;
+
+    // float_data и double_data повторяются: значения приходят несколькими упакованными
+    // кусками или поштучно. Единственный упакованный кусок остаётся ленивой ссылкой в файл,
+    // а следующее значение того же поля переносит его в вектор и дописывает себя туда же
+    uint64_t lazy_field = 0; // поле, чьи данные сейчас ленивая ссылка (0 — нет)
+    auto take_lazy = [&](auto& values) {
+        using T = typename std::decay_t<decltype(values)>::value_type;
+        ByteView bytes = result.raw_view();
+        if (bytes.size() % sizeof(T) != 0)
+        {
+            throw std::runtime_error("Тензор " + result.get_name() + ": длина упакованного поля не кратна размеру элемента");
+        }
+        size_t first = values.size();
+        values.resize(first + bytes.size() / sizeof(T));
+        std::memcpy(values.data() + first, bytes.data(), bytes.size());
+        result.set_raw_data(std::vector<uint8_t>());
+        lazy_field = 0;
+    };
+    auto check_bounds = [&](uint64_t length) {
+        if (reader.get_cur_pos() + length > end_pos)
+        {
+            throw std::runtime_error("Тензор " + result.get_name() + ": поле данных выходит за границу тензора");
+        }
+    };
 
     while (reader.get_cur_pos() < end_pos)
     {
-        cur_byte = reader.watch_cur_byte();
-        int field_number = cur_byte >> 3;
-        reader.read_byte();
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
 
         switch(field_number)
         {
-            case 1: // dims
+            case 1: // dims: по одному varint или упакованные
             {
-                uint64_t dim = reader.read_varint(); 
-                result.add_dim(dim);
+                if (wire_type == 2)
+                {
+                    uint64_t len = reader.read_varint();
+                    if (reader.get_cur_pos() + len > end_pos) break;
+                    reader.read_packed_varints(len, dims);
+                }
+                else
+                {
+                    dims.push_back(static_cast<int64_t>(reader.read_varint()));
+                }
                 break;
             }
 
@@ -375,44 +464,622 @@ Tensor ONNXParser::parseTensor(uint64_t tensor_size)
                 break;
             }
 
-            case 3: // name
+            case 8: // name
             {
                 uint64_t str_size = reader.read_varint();
                 if (reader.get_cur_pos() + str_size > end_pos) break;
 
-                auto bytes = reader.read_bytes(str_size);
-                std::string tensor_name = clean_string(bytes);
-
-                result.set_name(tensor_name);
+                result.set_name(clean_string(reader.read_string_view(str_size)));
                 break;
             }
 
-            case 5: // float_data
+            case 4:  // float_data (packed, те же байты little-endian, что и raw_data)
+            case 10: // double_data (packed, аналогично)
+            case 9:  // raw_data
             {
+                if (field_number == 4 && wire_type == 5) // неупакованный float_data
+                {
+                    check_bounds(4);
+                    if (lazy_field == 4) take_lazy(float_values);
+                    float value;
+                    std::memcpy(&value, reader.read_view(4).data(), 4);
+                    float_values.push_back(value);
+                    break;
+                }
+                if (field_number == 10 && wire_type == 1) // неупакованный double_data
+                {
+                    check_bounds(8);
+                    if (lazy_field == 10) take_lazy(double_values);
+                    double value;
+                    std::memcpy(&value, reader.read_view(8).data(), 8);
+                    double_values.push_back(value);
+                    break;
+                }
+                if (wire_type != 2)
+                {
+                    skipField(wire_type);
+                    break;
+                }
+
                 uint64_t len = reader.read_varint();
-                if (reader.get_cur_pos() + len > end_pos) break;
+                check_bounds(len);
+
+                // следующий кусок float_data/double_data — дописываем к уже прочитанным значениям
+                if (field_number == 4 && (lazy_field == 4 || !float_values.empty()))
+                {
+                    if (lazy_field == 4) take_lazy(float_values);
+                    reader.read_packed_floats(len, float_values);
+                    break;
+                }
+                if (field_number == 10 && (lazy_field == 10 || !double_values.empty()))
+                {
+                    if (lazy_field == 10) take_lazy(double_values);
+                    if (len % sizeof(double) != 0)
+                    {
+                        throw std::runtime_error("Тензор " + result.get_name() + ": длина упакованного поля не кратна размеру элемента");
+                    }
+                    size_t first = double_values.size();
+                    double_values.resize(first + len / sizeof(double));
+                    std::memcpy(double_values.data() + first, reader.read_view(len).data(), len);
+                    break;
+                }
 
-                std::vector<uint8_t> bytes = reader.read_bytes(len);
-                    
-                result.set_raw_data(bytes);  
+                // не копируем веса: запоминаем смещение в буфере файла (raw_data не повторяется:
+                // следующее значение заменяет предыдущее)
+                result.set_lazy_data(reader.get_buffer(), reader.get_cur_pos(), len);
+                lazy_field = field_number;
+                reader.skip(len);
                 break;
             }
 
-            case 9: // raw_data
+            case 5:  // int32_data: INT32, INT16/UINT16, INT8/UINT8, BOOL и биты FLOAT16/BFLOAT16
+            case 7:  // int64_data
+            case 11: // uint64_data: UINT32, UINT64
+            {
+                if (wire_type == 2)
+                {
+                    uint64_t len = reader.read_varint();
+                    if (reader.get_cur_pos() + len > end_pos) break;
+                    reader.read_packed_varints(len, int_values);
+                }
+                else
+                {
+                    int_values.push_back(static_cast<int64_t>(reader.read_varint()));
+                }
+                break;
+            }
+
+            case 13: // external_data: location, offset, length (и checksum — не проверяем)
             {
                 uint64_t len = reader.read_varint();
                 if (reader.get_cur_pos() + len > end_pos) break;
 
-                result.set_raw_data(reader.read_bytes(len));
+                std::string key, value;
+                parseStringEntry(len, key, value);
 
+                // смещение и длина записаны десятичной строкой
+                auto to_number = [&value]() {
+                    uint64_t number = 0;
+                    auto [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+                    if (error != std::errc() || ptr != value.data() + value.size())
+                    {
+                        throw std::runtime_error("Некорректное число во внешних данных тензора: " + value);
+                    }
+                    return number;
+                };
+
+                if (key == "location") location = std::move(value);
+                else if (key == "offset") external_offset = to_number();
+                else if (key == "length")
+                {
+                    external_length = to_number();
+                    has_external_length = true;
+                }
+                break;
+            }
+
+            case 14: // data_location: 1 — EXTERNAL
+            {
+                external = reader.read_varint() == 1;
                 break;
             }
+
+            default: // segment, string_data, doc_string и прочие поля пропускаем
+            {
+                skipField(wire_type);
+                break;
+            }
+        }
+    }
+
+    for (int64_t dim : dims) result.add_dim(dim);
+
+    // поштучные значения — в raw_data тем же little-endian представлением
+    auto as_bytes = [](const auto& values) {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(values.data());
+        return std::vector<uint8_t>(begin, begin + values.size() * sizeof(values[0]));
+    };
+    // целые поля хранят каждый элемент varint'ом; в raw_data элемент занимает
+    // data_type_size байтов (data_type может прийти после данных, поэтому сужаем в конце)
+    auto narrow = [&](auto type_tag) {
+        using T = decltype(type_tag);
+        std::vector<T> narrowed(int_values.size());
+        for (size_t i = 0; i < int_values.size(); i++) narrowed[i] = static_cast<T>(int_values[i]);
+        return as_bytes(narrowed);
+    };
+
+    if (external)
+    {
+        // файл отображается один раз на все тензоры; данные остаются ленивым участком файла
+        result.set_external_location(location);
+        std::shared_ptr<const FileBuffer> file = external_files->open(location);
+        if (!file) return result; // файла нет: тензор без данных
+
+        if (!has_external_length && external_offset <= file->get_size()) external_length = file->get_size() - external_offset;
+        if (external_offset > file->get_size() || external_length > file->get_size() - external_offset)
+        {
+            throw std::runtime_error("Тензор " + result.get_name() + ": внешние данные выходят за конец файла " + location);
+        }
+        result.set_lazy_data(std::move(file), external_offset, external_length);
+    }
+    else if (!float_values.empty()) result.set_raw_data(as_bytes(float_values));
+    else if (!double_values.empty()) result.set_raw_data(as_bytes(double_values));
+    else if (!int_values.empty())
+    {
+        switch (data_type_size(result.get_data_type()))
+        {
+        case 1: result.set_raw_data(narrow(uint8_t())); break;
+        case 2: result.set_raw_data(narrow(uint16_t())); break;
+        case 4: result.set_raw_data(narrow(uint32_t())); break;
+        default: result.set_raw_data(as_bytes(int_values)); break;
         }
     }
 
     return result;
 }
 
+void ONNXParser::parseStringEntry(uint64_t length, std::string& key, std::string& value)
+{
+    size_t end_pos = reader.get_cur_pos() + length;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        if ((field_number == 1 || field_number == 2) && wire_type == 2)
+        {
+            uint64_t str_size = reader.read_varint();
+            if (reader.get_cur_pos() + str_size > end_pos) break;
+
+            (field_number == 1 ? key : value) = std::string(reader.read_string_view(str_size));
+        }
+        else
+        {
+            skipField(wire_type);
+        }
+    }
+}
+
+void ONNXParser::skipField(int wire_type)
+{
+    if (wire_type == 0) reader.read_varint();
+    else if (wire_type == 1) reader.skip(8);
+    else if (wire_type == 2) reader.skip(reader.read_varint());
+    else if (wire_type == 5) reader.skip(4);
+}
+
+TensorInfo ONNXParser::parseValueInfo(uint64_t length, std::string_view& name)
+{
+    PARSE_PROFILE_SCOPE(ParsePhase::VALUE_INFO, length);
+
+    TensorInfo info;
+    size_t end_pos = reader.get_cur_pos() + length;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        if (field_number == 1 && wire_type == 2) // name
+        {
+            name = reader.read_string_view(reader.read_varint());
+        }
+        else if (field_number == 2 && wire_type == 2) // type: TypeProto
+        {
+            uint64_t type_len = reader.read_varint();
+            size_t type_end = reader.get_cur_pos() + type_len;
+
+            while (reader.get_cur_pos() < type_end)
+            {
+                uint64_t type_tag = reader.read_varint();
+
+                // tensor_type (1): остальные варианты (sequence, map, ...) не поддерживаются
+                if ((type_tag >> 3) != 1 || (type_tag & 0x07) != 2)
+                {
+                    skipField(type_tag & 0x07);
+                    continue;
+                }
+
+                uint64_t tensor_len = reader.read_varint();
+                size_t tensor_end = reader.get_cur_pos() + tensor_len;
+                while (reader.get_cur_pos() < tensor_end)
+                {
+                    uint64_t tensor_tag = reader.read_varint();
+                    uint64_t tensor_field = tensor_tag >> 3;
+
+                    if (tensor_field == 1 && (tensor_tag & 0x07) == 0) // elem_type
+                    {
+                        info.data_type = static_cast<int32_t>(reader.read_varint());
+                    }
+                    else if (tensor_field == 2 && (tensor_tag & 0x07) == 2) // shape
+                    {
+                        parseShape(reader.read_varint(), info);
+                    }
+                    else
+                    {
+                        skipField(tensor_tag & 0x07);
+                    }
+                }
+            }
+        }
+        else // doc_string и прочее
+        {
+            skipField(wire_type);
+        }
+    }
+
+    return info;
+}
+
+void ONNXParser::parseShape(uint64_t length, TensorInfo& info)
+{
+    size_t end_pos = reader.get_cur_pos() + length;
+    info.has_shape = true;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        if ((tag >> 3) != 1 || (tag & 0x07) != 2) // не dim
+        {
+            skipField(tag & 0x07);
+            continue;
+        }
+
+        // Dimension: dim_value (1) или dim_param (2); без обоих — неизвестна
+        int64_t dim = -1;
+        std::string param;
+        uint64_t dim_len = reader.read_varint();
+        size_t dim_end = reader.get_cur_pos() + dim_len;
+
+        while (reader.get_cur_pos() < dim_end)
+        {
+            uint64_t dim_tag = reader.read_varint();
+            if ((dim_tag >> 3) == 1 && (dim_tag & 0x07) == 0)
+            {
+                dim = static_cast<int64_t>(reader.read_varint());
+            }
+            else if ((dim_tag >> 3) == 2 && (dim_tag & 0x07) == 2)
+            {
+                param = clean_string(reader.read_string_view(reader.read_varint()));
+            }
+            else
+            {
+                skipField(dim_tag & 0x07);
+            }
+        }
+
+        info.dims.push_back(dim);
+        info.dim_params.push_back(std::move(param));
+    }
+}
+
+// поле GraphProto, размеченное первым проходом многопоточного разбора
+struct GraphField
+{
+    uint64_t field_number = 0;
+    size_t index = 0;    // номер среди полей своего вида: узлов, инициализаторов или ValueInfo
+    size_t offset = 0;   // начало значения в буфере файла
+    size_t length = 0;
+};
+
+// полей на одну задачу пула: мельче — больше накладных расходов, крупнее — хуже баланс
+static constexpr size_t PARSE_CHUNK_FIELDS = 512;
+
+void ONNXParser::parseGraphParallel(size_t end_pos)
+{
+    const size_t start_pos = reader.get_cur_pos();
+
+    // фаза 1: только теги и длины. Узлы (1), инициализаторы (5) и ValueInfo (11, 12, 13)
+    // размечаются, имя графа читается сразу, неизвестные поля пропускаются
+    std::vector<GraphField> fields;
+    size_t node_count = 0, tensor_count = 0, info_count = 0;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        size_t field_start = reader.get_cur_pos();
+        try
+        {
+            uint64_t tag = reader.read_varint();
+            int wire_type = tag & 0x07;
+            uint64_t field_number = tag >> 3;
+
+            bool known = field_number == 1 || field_number == 2 || field_number == 5 ||
+                         (field_number >= 11 && field_number <= 13);
+            if (!known)
+            {
+                skipField(wire_type);
+                continue;
+            }
+
+            uint64_t len = wire_type == 2 ? reader.read_varint() : 0;
+            if (wire_type != 2 || len > end_pos - std::min(end_pos, reader.get_cur_pos()))
+            {
+                reader.seek(field_start);
+                break;
+            }
+
+            GraphField field;
+            field.field_number = field_number;
+            field.offset = reader.get_cur_pos();
+            field.length = len;
+
+            if (field_number == 2) graph.setGraphName(clean_string(reader.read_string_view(len)));
+            else reader.skip(len);
+
+            if (field_number == 1) field.index = node_count++;
+            else if (field_number == 5) field.index = tensor_count++;
+            else if (field_number != 2) field.index = info_count++;
+            if (field_number != 2) fields.push_back(field);
+        }
+        catch (const std::exception&)
+        {
+            // обрезанное поле: последовательный разбор встретит ту же ошибку
+            reader.seek(field_start);
+            break;
+        }
+    }
+
+    if (fields.empty()) return;
+
+    // фаза 2: порции полей разбираются независимыми парсерами над тем же буфером.
+    // Каждая порция собирает имена тензоров в свою таблицу в том же порядке, в каком
+    // их добавил бы в граф последовательный разбор (узлы, инициализаторы, ValueInfo)
+    std::vector<Node> nodes(node_count);
+    std::vector<Tensor> tensors(tensor_count);
+    std::vector<TensorId> tensor_ids(tensor_count);
+    std::vector<TensorInfo> infos(info_count);
+    std::vector<TensorId> info_ids(info_count);
+
+    const size_t chunks = (fields.size() + PARSE_CHUNK_FIELDS - 1) / PARSE_CHUNK_FIELDS;
+    std::vector<Graph> chunk_graphs(chunks);
+
+    auto decode_chunk = [&](size_t chunk) {
+        ONNXParser worker(reader, external_files);
+        size_t last = std::min(fields.size(), (chunk + 1) * PARSE_CHUNK_FIELDS);
+
+        for (size_t k = chunk * PARSE_CHUNK_FIELDS; k < last; k++)
+        {
+            const GraphField& field = fields[k];
+            worker.reader.seek(field.offset);
+
+            if (field.field_number == 1)
+            {
+                nodes[field.index] = worker.parseNode(field.length);
+            }
+            else if (field.field_number == 5)
+            {
+                tensors[field.index] = worker.parseTensor(field.length);
+                tensor_ids[field.index] = worker.graph.intern_tensor(tensors[field.index].get_name());
+            }
+            else
+            {
+                std::string_view name;
+                infos[field.index] = worker.parseValueInfo(field.length, name);
+                info_ids[field.index] = worker.graph.intern_tensor(clean_view(name));
+            }
+        }
+        chunk_graphs[chunk] = std::move(worker.graph);
+    };
+
+    try
+    {
+        if (chunks == 1)
+        {
+            decode_chunk(0);
+        }
+        else
+        {
+            ThreadPool pool(threads);
+            TaskGroup group;
+            for (size_t chunk = 0; chunk < chunks; chunk++)
+            {
+                pool.submit(group, [&, chunk]() {
+                    if (!group.failed()) decode_chunk(chunk);
+                });
+            }
+            pool.wait(group);
+        }
+    }
+    catch (const std::exception&)
+    {
+        // повреждённый граф: в граф ещё ничего не добавлено, последовательный разбор
+        // с начала даст тот же результат и те же ошибки, что и без потоков
+        reader.seek(start_pos);
+        return;
+    }
+
+    // фаза 3: слияние в порядке файла. Имена порции добавляются в граф по возрастанию
+    // локальных id — это порядок первых упоминаний, как при последовательном разборе, —
+    // дальше узлы и тензоры порции получают id графа без поиска по имени
+    size_t name_count = graph.tensor_count();
+    for (const Graph& chunk_graph : chunk_graphs) name_count += chunk_graph.tensor_count();
+    graph.reserve_tensors(name_count);
+    graph.reserve_nodes(graph.get_nodes().size() + node_count);
+
+    for (size_t chunk = 0; chunk < chunks; chunk++)
+    {
+        std::vector<TensorId> remap = graph.merge_symbols(chunk_graphs[chunk]);
+        auto global_id = [&](TensorId local) { return local == NO_TENSOR ? NO_TENSOR : remap[local]; };
+
+        size_t last = std::min(fields.size(), (chunk + 1) * PARSE_CHUNK_FIELDS);
+        for (size_t k = chunk * PARSE_CHUNK_FIELDS; k < last; k++)
+        {
+            const GraphField& field = fields[k];
+
+            if (field.field_number == 1)
+            {
+                Node& node = nodes[field.index];
+                for (size_t i = 0; i < node.get_inputs().size(); i++)
+                {
+                    node.set_input(i, global_id(node.get_inputs()[i]));
+                }
+                for (size_t i = 0; i < node.get_outputs().size(); i++)
+                {
+                    node.set_output(i, global_id(node.get_outputs()[i]));
+                }
+                graph.add_node(std::move(node));
+            }
+            else if (field.field_number == 5)
+            {
+                graph.add_tensor(global_id(tensor_ids[field.index]), std::move(tensors[field.index]));
+            }
+            else
+            {
+                TensorId id = global_id(info_ids[field.index]);
+                if (id == NO_TENSOR) continue;
+
+                if (field.field_number == 11) graph.add_input(id);
+                if (field.field_number == 12) graph.add_output(id);
+                graph.set_tensor_info(id, std::move(infos[field.index]));
+            }
+        }
+    }
+}
+
+const char* data_type_name(int32_t data_type)
+{
+    switch (data_type)
+    {
+    case FLOAT: return "FLOAT";
+    case UINT8: return "UINT8";
+    case INT8: return "INT8";
+    case UINT16: return "UINT16";
+    case INT16: return "INT16";
+    case INT32: return "INT32";
+    case INT64: return "INT64";
+    case STRING: return "STRING";
+    case BOOL: return "BOOL";
+    case FLOAT16: return "FLOAT16";
+    case DOUBLE: return "DOUBLE";
+    case UINT32: return "UINT32";
+    case UINT64: return "UINT64";
+    case BFLOAT16: return "BFLOAT16";
+    default: return "UNDEFINED";
+    }
+}
+
+size_t data_type_size(int32_t data_type)
+{
+    switch (data_type)
+    {
+    case UINT8: case INT8: case BOOL: return 1;
+    case UINT16: case INT16: case FLOAT16: case BFLOAT16: return 2;
+    case FLOAT: case INT32: case UINT32: return 4;
+    case INT64: case DOUBLE: case UINT64: return 8;
+    default: return 0;
+    }
+}
+
+float half_to_float(uint16_t bits)
+{
+    uint32_t sign = static_cast<uint32_t>(bits & 0x8000) << 16;
+    uint32_t exponent = (bits >> 10) & 0x1F;
+    uint32_t mantissa = bits & 0x3FF;
+
+    uint32_t result;
+    if (exponent == 0x1F) // бесконечность и NaN
+    {
+        result = sign | 0x7F800000u | (mantissa << 13);
+    }
+    else if (exponent != 0) // нормальное: сдвиг порядка 15 → 127
+    {
+        result = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0) // ±0
+    {
+        result = sign;
+    }
+    else // субнормальное half — нормальное float: нормализуем мантиссу
+    {
+        uint32_t shift = 0;
+        while ((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            shift++;
+        }
+        result = sign | ((113 - shift) << 23) | ((mantissa & 0x3FF) << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &result, sizeof(value));
+    return value;
+}
+
+float bfloat16_to_float(uint16_t bits)
+{
+    uint32_t result = static_cast<uint32_t>(bits) << 16;
+    float value;
+    std::memcpy(&value, &result, sizeof(value));
+    return value;
+}
+
+std::vector<float> Tensor::to_floats() const
+{
+    switch (data_type)
+    {
+    case FLOAT:
+    {
+        Span<float> values = as_span<float>();
+        return std::vector<float>(values.begin(), values.end());
+    }
+    case DOUBLE:
+    {
+        Span<double> values = as_span<double>();
+        return std::vector<float>(values.begin(), values.end());
+    }
+    case FLOAT16:
+    case BFLOAT16:
+    {
+        Span<uint16_t> values = as_span<uint16_t>();
+        std::vector<float> result(values.size());
+        float (*convert)(uint16_t) = data_type == FLOAT16 ? half_to_float : bfloat16_to_float;
+        for (size_t i = 0; i < values.size(); i++) result[i] = convert(values[i]);
+        return result;
+    }
+    default:
+        throw std::runtime_error("Тензор " + name + ": тип " + data_type_name(data_type)
+                                 + " не преобразуется в float");
+    }
+}
+
+std::string TensorInfo::shape_string() const
+{
+    if (!has_shape) return "[?]";
+
+    std::string result = "[";
+    for (size_t i = 0; i < dims.size(); i++)
+    {
+        if (i) result += ", ";
+        if (i < dim_params.size() && !dim_params[i].empty()) result += dim_params[i];
+        else if (dims[i] < 0) result += "?";
+        else result += std::to_string(dims[i]);
+    }
+    return result + "]";
+}
+
 // вспомогательная функция для строки для DOT
 static std::string escape_dot(const std::string& str) 
 {
@@ -501,6 +1168,13 @@ void Graph::export_to_dot(const std::string& filename) const
     dot << "        legend_conv [label=\"Conv\", style=filled, fillcolor=lightblue, shape=box];\n";
     dot << "        legend_relu [label=\"Relu\", style=filled, fillcolor=lightgreen, shape=ellipse];\n";
     dot << "        legend_gemm [label=\"Gemm/MatMul\", style=filled, fillcolor=lightyellow, shape=box];\n";
+
+    // слитые узлы (после fuse_epilogues) — двойная рамка
+    bool has_fused = std::any_of(nodes.begin(), nodes.end(), [](const Node& n) { return !n.get_fused().empty(); });
+    if (has_fused)
+    {
+        dot << "        legend_fused [label=\"Conv+Relu (fused)\", style=filled, fillcolor=lightblue, shape=box, peripheries=2];\n";
+    }
     dot << "    }\n\n";
 
     // узлы
@@ -520,8 +1194,9 @@ void Graph::export_to_dot(const std::string& filename) const
         // вектор атрибутов
         std::vector<std::string> attrs;
     
-        for (const auto& [name, vals] : node.get_ints_attrs()) 
+        for (const auto* attr : sorted_by_name(node.get_ints_attrs()))
         {
+            const auto& [name, vals] = *attr;
             if (!vals.empty()) 
             {
                 std::string attr_str = name + "=[";
@@ -540,13 +1215,15 @@ void Graph::export_to_dot(const std::string& filename) const
             }
         }
 
-        for (const auto& [name, val] : node.get_float_attrs()) 
+        for (const auto* attr : sorted_by_name(node.get_float_attrs()))
         {
+            const auto& [name, val] = *attr;
             attrs.push_back(name + "=" + std::to_string(val));
         }
 
-        for (const auto& [name, val] : node.get_string_attrs()) 
+        for (const auto* attr : sorted_by_name(node.get_string_attrs()))
         {
+            const auto& [name, val] = *attr;
             attrs.push_back(name + "=" + val);
         }
     
@@ -561,6 +1238,13 @@ void Graph::export_to_dot(const std::string& filename) const
         dot << escape_html(op_type);  
 
         dot << "</B></TD></TR>";
+
+        // слитые эпилоги — по строке в цвете своей операции
+        for (const FusedOp& op : node.get_fused())
+        {
+            dot << "<TR><TD BGCOLOR=\"" << get_node_color(op.op_type) << "\"><I>+ ";
+            dot << escape_html(op.op_type) << "</I></TD></TR>";
+        }
     
         // атрибуты 
         for (const auto& attr : attrs) 
@@ -572,28 +1256,16 @@ void Graph::export_to_dot(const std::string& filename) const
     
         dot << "</TABLE>>";
         dot << ", style=filled, fillcolor=" << get_node_color(op_type) << ", ";
-        dot << "shape=" << get_node_shape(op_type) << "];\n";
+        dot << "shape=" << get_node_shape(op_type);
+        if (!node.get_fused().empty()) dot << ", peripheries=2";
+        dot << "];\n";
     }
 
     // === Рёбра  ===
     dot << "    // === Рёбра ===\n";
     
-    // имя тензора → список узлов, которые его производят
-    std::unordered_map<std::string, std::vector<std::string>> tensor_producers;
-
-    for (size_t i = 0; i < nodes.size(); i++) 
-    {
-        const auto& node = nodes[i];
-        std::string node_id = "n" + std::to_string(i);
-
-        for (const auto& out : node.get_outputs()) 
-        {
-            if (!out.empty()) 
-            {
-                tensor_producers[out].push_back(node_id);
-            }
-        }
-    }
+    // производители тензоров берём из индекса смежности
+    const GraphIndex& graph_index = get_index();
     
     // делаем  рёбра: вход тензора → узел-потребитель
     for (size_t i = 0; i < nodes.size(); i++) 
@@ -601,9 +1273,10 @@ void Graph::export_to_dot(const std::string& filename) const
         const auto& node = nodes[i];
         std::string node_id = "n" + std::to_string(i);
         
-        for (const auto& inp : node.get_inputs()) 
+        for (TensorId inp_id : node.get_inputs()) 
         {
-            if (inp.empty()) continue;
+            if (inp_id == NO_TENSOR) continue;
+            const std::string& inp = tensor_names.name(inp_id);
 
             // пропуск не основных входов
             if (inp.find(".weight") != std::string::npos || 
@@ -613,21 +1286,19 @@ void Graph::export_to_dot(const std::string& filename) const
             }
             
             // делаем ребро
-            if (tensor_producers.count(inp)) 
+            NodeId producer = graph_index.producer_of(inp_id);
+            if (producer != NO_NODE) 
             {
-                for (const auto& producer_id : tensor_producers[inp]) 
+                dot << "    n" << producer << " -> " << node_id;
+                
+                // подпись ребра - имя тензора 
+                if (inp.size() < 30) 
                 {
-                    dot << "    " << producer_id << " -> " << node_id;
-                    
-                    // подпись ребра - имя тензора 
-                    if (inp.size() < 30) 
-                    {
-                        dot << " [label=\"" << escape_dot(inp) << "\"]";
-                    }
-                    dot << ";\n";
+                    dot << " [label=\"" << escape_dot(inp) << "\"]";
                 }
+                dot << ";\n";
             } else {
-                std::string input_node_id = "input_" + std::to_string(i) + "_" + std::to_string(tensor_producers.size());
+                std::string input_node_id = "input_" + std::to_string(i) + "_" + std::to_string(inp_id);
                 dot << "    " << input_node_id << " [label=\"" << escape_dot(inp) << "\", ";
                 dot << "shape=plaintext, style=dashed];\n";
                 dot << "    " << input_node_id << " -> " << node_id << ";\n";
@@ -638,25 +1309,18 @@ void Graph::export_to_dot(const std::string& filename) const
     // === выходы графа ===
     if (!outputs.empty()) {
         dot << "\n    // === Выходы ===\n";
-        for (const auto& out_name : outputs) 
+        for (size_t k = 0; k < outputs.size(); k++) 
         {
-            std::string output_node_id = "out_" + std::to_string(&out_name - outputs.data());
-            dot << "    " << output_node_id << " [label=\"" << escape_dot(out_name) << "\", ";
+            TensorId out_id = outputs[k];
+            std::string output_node_id = "out_" + std::to_string(k);
+            dot << "    " << output_node_id << " [label=\"" << escape_dot(tensor_names.name(out_id)) << "\", ";
             dot << "shape=doubleellipse, style=filled, fillcolor=gold];\n";
             
-            // поиск узла, которого производит этот выход
-            for (size_t i = 0; i < nodes.size(); i++) 
+            // узел, который производит этот выход
+            NodeId producer = graph_index.producer_of(out_id);
+            if (producer != NO_NODE) 
             {
-                const auto& node = nodes[i];
-                std::string node_id = "n" + std::to_string(i);
-
-                for (const auto& node_out : node.get_outputs()) 
-                {
-                    if (node_out == out_name) 
-                    {
-                        dot << "    " << node_id << " -> " << output_node_id << " [style=bold];\n";
-                    }
-                }
+                dot << "    n" << producer << " -> " << output_node_id << " [style=bold];\n";
             }
         }
     }
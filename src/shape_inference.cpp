@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "executor.h"
+#include "ops.h"
+#include "shape_inference.h"
+
+// размерность при выводе: число (value >= 0), символ (param) или неизвестна
+struct Dim
+{
+    int64_t value = -1;
+    std::string param;
+
+    bool known() const { return value >= 0; }
+    bool same(const Dim& other) const
+    {
+        if (known() || other.known()) return value == other.value;
+        return !param.empty() && param == other.param;
+    }
+};
+
+using Dims = std::vector<Dim>;
+
+// тензор во время вывода: тип, форма и, для маленьких int64-векторов, значения
+struct Shaped
+{
+    int32_t data_type = UNDEFINED;
+    Dims dims;
+    bool has_value = false;
+    Dims value; // элементы тензора-формы (тоже числа или символы)
+};
+
+static Dims dims_of(const TensorInfo& info)
+{
+    Dims dims(info.dims.size());
+    for (size_t i = 0; i < dims.size(); i++)
+    {
+        dims[i].value = info.dims[i];
+        if (i < info.dim_params.size()) dims[i].param = info.dim_params[i];
+    }
+    return dims;
+}
+
+static Dims numeric_dims(const std::vector<int64_t>& values)
+{
+    Dims dims(values.size());
+    for (size_t i = 0; i < values.size(); i++) dims[i].value = values[i];
+    return dims;
+}
+
+static TensorInfo info_of(const Shaped& shaped)
+{
+    TensorInfo info;
+    info.data_type = shaped.data_type;
+    info.has_shape = true;
+    for (const Dim& dim : shaped.dims)
+    {
+        info.dims.push_back(dim.value);
+        info.dim_params.push_back(dim.known() ? std::string() : dim.param);
+    }
+    return info;
+}
+
+// размерность результата поэлементной операции с broadcasting
+static Dim broadcast_dim(const Dim& a, const Dim& b)
+{
+    if (a.known() && a.value == 1) return b;
+    if (b.known() && b.value == 1) return a;
+    if (a.same(b)) return a;
+
+    // символ против числа > 1: по правилам broadcasting символ обязан равняться числу
+    if (a.known() && !b.known()) return a;
+    if (b.known() && !a.known()) return b;
+
+    if (a.known() && b.known())
+    {
+        throw std::runtime_error("формы несовместимы для broadcasting");
+    }
+    return Dim();
+}
+
+static Dims broadcast_dims(const Dims& a, const Dims& b)
+{
+    size_t rank = std::max(a.size(), b.size());
+    Dims result(rank);
+    Dim one;
+    one.value = 1;
+
+    for (size_t i = 0; i < rank; i++)
+    {
+        const Dim& da = i < rank - a.size() ? one : a[i - (rank - a.size())];
+        const Dim& db = i < rank - b.size() ? one : b[i - (rank - b.size())];
+        result[i] = broadcast_dim(da, db);
+    }
+    return result;
+}
+
+// все размерности известны числами
+static bool all_known(const Dims& dims)
+{
+    return std::all_of(dims.begin(), dims.end(), [](const Dim& d) { return d.known(); });
+}
+
+static std::vector<int64_t> values_of(const Dims& dims)
+{
+    std::vector<int64_t> values;
+    for (const Dim& dim : dims) values.push_back(dim.value);
+    return values;
+}
+
+static Dims infer_conv(const Node& node, const Shaped& x, const Shaped& w)
+{
+    if (x.dims.size() != 4 || w.dims.size() != 4 || !all_known(w.dims))
+    {
+        throw std::runtime_error("нужны вход ранга 4 и веса с известной формой");
+    }
+
+    Dims out(4);
+    out[0] = x.dims[0];
+    out[1] = w.dims[0];
+
+    // пространственные размеры — через ту же геометрию, что у ядра (батч и каналы подставляются)
+    if (x.dims[2].known() && x.dims[3].known())
+    {
+        int64_t channels = x.dims[1].known() ? x.dims[1].value : w.dims[1].value * node.get_int("group", 1);
+        ConvGeometry g = conv_geometry(node, {1, channels, x.dims[2].value, x.dims[3].value}, values_of(w.dims));
+        out[2].value = g.out_h;
+        out[3].value = g.out_w;
+    }
+    return out;
+}
+
+static Dims infer_gemm(const Node& node, const Shaped& a, const Shaped& b)
+{
+    if (a.dims.size() != 2 || b.dims.size() != 2) throw std::runtime_error("входы должны быть матрицами");
+
+    bool trans_a = node.get_int("transA", 0) != 0;
+    bool trans_b = node.get_int("transB", 0) != 0;
+    return {trans_a ? a.dims[1] : a.dims[0], trans_b ? b.dims[0] : b.dims[1]};
+}
+
+static Dims infer_matmul(const Shaped& a, const Shaped& b)
+{
+    Dims sa = a.dims, sb = b.dims;
+    if (sa.empty() || sb.empty()) throw std::runtime_error("скалярные входы не поддерживаются");
+
+    Dim one;
+    one.value = 1;
+    bool a_vector = sa.size() == 1;
+    bool b_vector = sb.size() == 1;
+    if (a_vector) sa.insert(sa.begin(), one);
+    if (b_vector) sb.push_back(one);
+
+    Dims batch = broadcast_dims(Dims(sa.begin(), sa.end() - 2), Dims(sb.begin(), sb.end() - 2));
+    if (!a_vector) batch.push_back(sa[sa.size() - 2]);
+    if (!b_vector) batch.push_back(sb.back());
+    return batch;
+}
+
+// Reshape: 0 — размерность входа (если не allowzero), -1 — остаток числа элементов.
+// Остаток считается и с символами: одинаковые символы во входе и в форме сокращаются
+static Dims infer_reshape(const Node& node, const Shaped& data, const Shaped& shape)
+{
+    if (!shape.has_value) throw std::runtime_error("форма не известна до выполнения");
+
+    bool allowzero = node.get_int("allowzero", 0) != 0;
+    Dims out = shape.value;
+    int64_t infer_index = -1;
+
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        if (out[i].known() && out[i].value == 0 && !allowzero)
+        {
+            if (i >= data.dims.size()) throw std::runtime_error("0 за пределами ранга входа");
+            out[i] = data.dims[i];
+        }
+        else if (out[i].known() || !out[i].param.empty())
+        {
+            continue;
+        }
+        else if (out[i].value == -1 && infer_index < 0)
+        {
+            infer_index = static_cast<int64_t>(i);
+        }
+    }
+
+    if (infer_index < 0) return out;
+
+    // произведение чисел и набор символов входа; из них вычитаются известные размерности формы
+    int64_t in_product = 1;
+    std::vector<std::string> in_params;
+    for (const Dim& dim : data.dims)
+    {
+        if (dim.known()) in_product *= dim.value;
+        else if (!dim.param.empty()) in_params.push_back(dim.param);
+        else return out; // неизвестная размерность — остаток не вычислить
+    }
+
+    int64_t out_product = 1;
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        if (static_cast<int64_t>(i) == infer_index) continue;
+
+        if (out[i].known())
+        {
+            out_product *= out[i].value;
+        }
+        else
+        {
+            auto it = std::find(in_params.begin(), in_params.end(), out[i].param);
+            if (out[i].param.empty() || it == in_params.end()) return out;
+            in_params.erase(it);
+        }
+    }
+
+    if (in_params.size() == 1 && out_product == in_product)
+    {
+        out[infer_index].param = in_params[0]; // остаток — ровно символ входа
+    }
+    else if (in_params.empty() && out_product != 0)
+    {
+        out[infer_index].value = in_product / out_product;
+    }
+    return out;
+}
+
+static size_t concat_axis(const Node& node, size_t rank)
+{
+    int64_t axis = node.get_int("axis", 0);
+    if (axis < 0) axis += static_cast<int64_t>(rank);
+    if (axis < 0 || axis >= static_cast<int64_t>(rank)) throw std::runtime_error("ось вне диапазона");
+    return static_cast<size_t>(axis);
+}
+
+// выходы одного узла по известным входам; runtime_error — входы не согласованы
+static std::vector<Shaped> infer_node(const Node& node, const std::vector<const Shaped*>& in)
+{
+    const std::string& op = node.get_op_type();
+    auto input = [&](size_t k) -> const Shaped& {
+        if (k >= in.size() || in[k] == nullptr) throw std::runtime_error("нет формы входа #" + std::to_string(k));
+        return *in[k];
+    };
+
+    Shaped out;
+    out.data_type = input(0).data_type;
+
+    if (op == "Conv") out.dims = infer_conv(node, input(0), input(1));
+    else if (op == "Relu") out.dims = input(0).dims;
+    else if (op == "Add" || op == "Mul") out.dims = broadcast_dims(input(0).dims, input(1).dims);
+    else if (op == "Gemm") out.dims = infer_gemm(node, input(0), input(1));
+    else if (op == "MatMul") out.dims = infer_matmul(input(0), input(1));
+    else if (op == "Reshape") out.dims = infer_reshape(node, input(0), input(1));
+    else if (op == "Shape")
+    {
+        // срез индексов осей теми же start/end, что у ядра
+        std::vector<int64_t> axes(input(0).dims.size());
+        std::iota(axes.begin(), axes.end(), 0);
+        out.data_type = INT64;
+        out.has_value = true;
+        for (int64_t axis : shape_slice(node, axes)) out.value.push_back(input(0).dims[axis]);
+        out.dims = numeric_dims({static_cast<int64_t>(out.value.size())});
+    }
+    else if (op == "Concat")
+    {
+        out.dims = input(0).dims;
+        size_t axis = concat_axis(node, out.dims.size());
+        out.has_value = true;
+
+        int64_t total = 0;
+        for (size_t k = 0; k < in.size(); k++)
+        {
+            const Shaped& part = input(k);
+            if (part.dims.size() != out.dims.size()) throw std::runtime_error("ранги входов различаются");
+
+            if (total >= 0 && part.dims[axis].known()) total += part.dims[axis].value;
+            else total = -1;
+
+            out.has_value = out.has_value && part.has_value;
+            if (part.has_value) out.value.insert(out.value.end(), part.value.begin(), part.value.end());
+        }
+        out.dims[axis] = Dim();
+        out.dims[axis].value = total;
+        if (!out.has_value) out.value.clear();
+    }
+    else
+    {
+        throw std::runtime_error("вывод форм не поддерживается");
+    }
+
+    // слитые эпилоги: Add/Mul могут растянуть выход broadcasting'ом
+    for (const FusedOp& fused : node.get_fused())
+    {
+        if (fused.operand >= 0) out.dims = broadcast_dims(out.dims, input(fused.operand).dims);
+    }
+
+    std::vector<Shaped> outputs(node.get_outputs().size());
+    if (!outputs.empty()) outputs[0] = std::move(out);
+    return outputs;
+}
+
+// расхождение выведенной формы с объявленной в модели (пустая строка — совпадают)
+static std::string compare_with_declared(const TensorInfo& declared, const TensorInfo& inferred)
+{
+    if (declared.data_type != UNDEFINED && inferred.data_type != UNDEFINED &&
+        declared.data_type != inferred.data_type)
+    {
+        return std::string("тип ") + data_type_name(inferred.data_type) + ", объявлен " +
+               data_type_name(declared.data_type);
+    }
+
+    if (!declared.has_shape) return "";
+
+    bool differ = declared.dims.size() != inferred.dims.size();
+    for (size_t i = 0; !differ && i < declared.dims.size(); i++)
+    {
+        // числа сравниваются с числами; символ или неизвестная размерность с любой стороны не спорит
+        if (declared.dims[i] >= 0 && inferred.dims[i] >= 0) differ = declared.dims[i] != inferred.dims[i];
+    }
+
+    return differ ? "форма " + inferred.shape_string() + ", объявлена " + declared.shape_string() : "";
+}
+
+ShapeInferenceResult infer_shapes(Graph& graph, const std::unordered_map<std::string, std::vector<int64_t>>& input_shapes)
+{
+    ShapeInferenceResult result;
+    const size_t tensor_count = graph.tensor_count();
+    std::vector<Shaped> known(tensor_count);
+    std::vector<bool> has(tensor_count, false);
+
+    // инициализаторы: форма из dims, у маленьких int64-векторов ещё и значения
+    for (const auto& [id, tensor] : graph.get_initializers())
+    {
+        known[id].data_type = tensor.get_data_type();
+        known[id].dims = numeric_dims(tensor.get_dims());
+        has[id] = true;
+
+        if (tensor.get_data_type() == INT64 && tensor.get_dims().size() <= 1 && shape_size(tensor.get_dims()) <= 64)
+        {
+            try
+            {
+                known[id].value = numeric_dims(Value::from_tensor(tensor).int_data());
+                known[id].has_value = true;
+            }
+            catch (const std::runtime_error&)
+            {
+                // данных нет (внешний файл) — значение неизвестно, форма остаётся
+            }
+        }
+    }
+
+    // входы графа: объявленная форма или заданная явно
+    for (TensorId id : graph.get_inputs())
+    {
+        if (has[id]) continue;
+        if (const TensorInfo* info = graph.find_tensor_info(id); info && info->has_shape)
+        {
+            known[id].data_type = info->data_type;
+            known[id].dims = dims_of(*info);
+            has[id] = true;
+        }
+    }
+
+    for (const auto& [name, shape] : input_shapes)
+    {
+        TensorId id = graph.find_tensor(name);
+        if (id == NO_TENSOR) throw std::runtime_error("В графе нет входа " + name);
+
+        if (known[id].data_type == UNDEFINED) known[id].data_type = FLOAT;
+        known[id].dims = numeric_dims(shape);
+        has[id] = true;
+    }
+
+    const std::vector<Node>& nodes = graph.get_nodes();
+    for (NodeId i : graph.topological_order())
+    {
+        const Node& node = nodes[i];
+        if (node.get_op_type().empty()) continue;
+
+        std::vector<const Shaped*> inputs;
+        for (TensorId in : node.get_inputs())
+        {
+            inputs.push_back(in != NO_TENSOR && has[in] ? &known[in] : nullptr);
+        }
+
+        std::vector<Shaped> outputs;
+        try
+        {
+            outputs = infer_node(node, inputs);
+        }
+        catch (const std::runtime_error& e)
+        {
+            // форма не выводится — выходы остаются неизвестными, следующие узлы тоже пропустятся
+            result.skipped.push_back(node.get_op_type() + " " + node.get_name() + ": " + e.what());
+            continue;
+        }
+
+        for (size_t k = 0; k < outputs.size(); k++)
+        {
+            TensorId out = node.get_outputs()[k];
+            if (out == NO_TENSOR) continue;
+
+            TensorInfo inferred = info_of(outputs[k]);
+            if (const TensorInfo* declared = graph.find_tensor_info(out))
+            {
+                std::string problem = compare_with_declared(*declared, inferred);
+                if (!problem.empty()) result.mismatches.push_back(graph.tensor_name(out) + ": " + problem);
+            }
+
+            graph.set_tensor_info(out, std::move(inferred));
+            known[out] = std::move(outputs[k]);
+            has[out] = true;
+            result.inferred++;
+        }
+    }
+
+    return result;
+}
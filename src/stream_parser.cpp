@@ -0,0 +1,503 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "stream_parser.h"
+
+ONNXStreamParser::TextRef ONNXStreamParser::read_text(uint64_t n, bool clean)
+{
+    TextRef ref{static_cast<uint32_t>(text.size()), 0};
+    reader.read_append(static_cast<size_t>(n), text);
+
+    std::string_view bytes(text.data() + ref.offset, static_cast<size_t>(n));
+    ref.length = static_cast<uint32_t>(clean ? clean_view(bytes).size() : bytes.size());
+    text.resize(ref.offset + ref.length);
+    return ref;
+}
+
+std::string_view ONNXStreamParser::view_of(TextRef ref) const
+{
+    return std::string_view(text.data() + ref.offset, ref.length);
+}
+
+void ONNXStreamParser::skipField(int wire_type)
+{
+    if (wire_type == 0) reader.read_varint();
+    else if (wire_type == 1) reader.skip(8);
+    else if (wire_type == 2) reader.skip(reader.read_varint());
+    else if (wire_type == 5) reader.skip(4);
+    else throw std::runtime_error("Неизвестный wire type " + std::to_string(wire_type));
+}
+
+void ONNXStreamParser::read_varints(int wire_type, uint64_t end_pos, std::vector<int64_t>& values)
+{
+    if (wire_type != 2)
+    {
+        values.push_back(static_cast<int64_t>(reader.read_varint()));
+        return;
+    }
+
+    uint64_t len = reader.read_varint();
+    uint64_t stop = reader.get_cur_pos() + len;
+    if (stop > end_pos) throw std::runtime_error("Упакованное поле выходит за границу сообщения");
+    while (reader.get_cur_pos() < stop) values.push_back(static_cast<int64_t>(reader.read_varint()));
+}
+
+void ONNXStreamParser::read_floats(int wire_type, uint64_t end_pos, std::vector<float>& values)
+{
+    uint64_t count = 1;
+    if (wire_type == 2)
+    {
+        uint64_t len = reader.read_varint();
+        if (reader.get_cur_pos() + len > end_pos) throw std::runtime_error("Упакованное поле выходит за границу сообщения");
+        if (len % sizeof(float) != 0) throw std::runtime_error("Длина упакованного поля float не кратна 4");
+        count = len / sizeof(float);
+    }
+
+    for (uint64_t k = 0; k < count; k++)
+    {
+        float value;
+        reader.read_into(&value, sizeof(value));
+        values.push_back(value);
+    }
+}
+
+void ONNXStreamParser::parse()
+{
+    while (!reader.check_eof())
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        // значения метаданных модели — строками
+        auto report = [&](const char* key, std::string_view value) {
+            if (callbacks.on_metadata) callbacks.on_metadata(key, value);
+        };
+
+        text.clear();
+        switch (field_number)
+        {
+        case 1: // ir_version
+        case 5: // model_version
+        {
+            if (wire_type != 0)
+            {
+                skipField(wire_type);
+                break;
+            }
+            std::string value = std::to_string(reader.read_varint());
+            report(field_number == 1 ? "ir_version" : "model_version", value);
+            break;
+        }
+
+        case 2: // producer_name
+        case 3: // producer_version
+        case 4: // domain
+        case 6: // doc_string
+        {
+            if (wire_type != 2)
+            {
+                skipField(wire_type);
+                break;
+            }
+            // без обработчика строки не читаются: doc_string может быть большим
+            uint64_t len = reader.read_varint();
+            if (!callbacks.on_metadata)
+            {
+                reader.skip(len);
+                break;
+            }
+            TextRef value = read_text(len, false);
+            const char* key = field_number == 2 ? "producer_name" : field_number == 3 ? "producer_version"
+                            : field_number == 4 ? "domain" : "doc_string";
+            report(key, view_of(value));
+            break;
+        }
+
+        case 7: // graph
+        {
+            if (wire_type != 2)
+            {
+                skipField(wire_type);
+                break;
+            }
+            parseGraph(reader.read_varint());
+            break;
+        }
+
+        case 8: // opset_import
+        {
+            if (wire_type != 2)
+            {
+                skipField(wire_type);
+                break;
+            }
+            parseOpset(reader.read_varint());
+            break;
+        }
+
+        case 14: // metadata_props
+        {
+            if (wire_type != 2 || !callbacks.on_metadata)
+            {
+                skipField(wire_type);
+                break;
+            }
+            TextRef key, value;
+            parseStringEntry(reader.read_varint(), key, value);
+            if (callbacks.on_metadata) callbacks.on_metadata("metadata:" + std::string(view_of(key)), view_of(value));
+            break;
+        }
+
+        default: // training_info, functions и прочее
+            skipField(wire_type);
+            break;
+        }
+    }
+}
+
+void ONNXStreamParser::parseGraph(uint64_t length)
+{
+    uint64_t end_pos = reader.get_cur_pos() + length;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        if (wire_type != 2 || (field_number != 1 && field_number != 2 && field_number != 5))
+        {
+            // input/output/value_info, doc_string, sparse_initializer, ... — пропускаем
+            skipField(wire_type);
+            continue;
+        }
+
+        uint64_t len = reader.read_varint();
+        if (reader.get_cur_pos() + len > end_pos) throw std::runtime_error("Поле выходит за границу графа");
+
+        if (field_number == 1) parseNode(len);
+        else if (field_number == 5) parseTensor(len);
+        else
+        {
+            text.clear();
+            TextRef name = read_text(len, true);
+            if (callbacks.on_metadata) callbacks.on_metadata("graph_name", view_of(name));
+        }
+    }
+}
+
+void ONNXStreamParser::parseNode(uint64_t length)
+{
+    uint64_t end_pos = reader.get_cur_pos() + length;
+
+    text.clear();
+    input_refs.clear();
+    output_refs.clear();
+    pending.clear();
+    int_pool.clear();
+    float_pool.clear();
+    TextRef name, op_type, domain;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        if (wire_type != 2 || field_number < 1 || field_number > 7 || field_number == 6)
+        {
+            skipField(wire_type); // doc_string и неизвестные поля
+            continue;
+        }
+
+        uint64_t len = reader.read_varint();
+        if (reader.get_cur_pos() + len > end_pos) throw std::runtime_error("Поле выходит за границу узла");
+
+        switch (field_number)
+        {
+        case 1: input_refs.push_back(read_text(len, true)); break;
+        case 2: output_refs.push_back(read_text(len, true)); break;
+        case 3: name = read_text(len, true); break;
+        case 4: op_type = read_text(len, true); break;
+        case 5: parseAttribute(len); break;
+        case 7: domain = read_text(len, false); break;
+        }
+    }
+
+    if (!callbacks.on_node) return;
+
+    // text и пулы больше не растут — теперь можно выдать представления
+    views.clear();
+    for (TextRef ref : input_refs) views.push_back(view_of(ref));
+    for (TextRef ref : output_refs) views.push_back(view_of(ref));
+
+    attributes.clear();
+    for (const PendingAttribute& attr : pending)
+    {
+        StreamAttribute result;
+        result.name = view_of(attr.name);
+        result.type = attr.type;
+        result.i = attr.i;
+        result.f = attr.f;
+        result.s = view_of(attr.s);
+        result.ints = Span<int64_t>(int_pool.data() + attr.ints_begin, attr.ints_end - attr.ints_begin);
+        result.floats = Span<float>(float_pool.data() + attr.floats_begin, attr.floats_end - attr.floats_begin);
+        attributes.push_back(result);
+    }
+
+    StreamNode node;
+    node.name = view_of(name);
+    node.op_type = view_of(op_type);
+    node.domain = view_of(domain);
+    node.inputs = Span<std::string_view>(views.data(), input_refs.size());
+    node.outputs = Span<std::string_view>(views.data() + input_refs.size(), output_refs.size());
+    node.attributes = Span<StreamAttribute>(attributes.data(), attributes.size());
+    callbacks.on_node(node);
+}
+
+void ONNXStreamParser::parseAttribute(uint64_t length)
+{
+    uint64_t end_pos = reader.get_cur_pos() + length;
+    PendingAttribute attr;
+    attr.ints_begin = attr.ints_end = int_pool.size();
+    attr.floats_begin = attr.floats_end = float_pool.size();
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        switch (field_number)
+        {
+        case 1: // name
+        case 4: // s
+        {
+            if (wire_type != 2)
+            {
+                skipField(wire_type);
+                break;
+            }
+            uint64_t len = reader.read_varint();
+            if (reader.get_cur_pos() + len > end_pos) throw std::runtime_error("Поле выходит за границу атрибута");
+            (field_number == 1 ? attr.name : attr.s) = read_text(len, field_number == 1);
+            break;
+        }
+
+        case 2: // f
+        {
+            if (wire_type != 5)
+            {
+                skipField(wire_type);
+                break;
+            }
+            reader.read_into(&attr.f, sizeof(attr.f));
+            break;
+        }
+
+        case 3: // i
+        case 20: // type
+        {
+            if (wire_type != 0)
+            {
+                skipField(wire_type);
+                break;
+            }
+            int64_t value = static_cast<int64_t>(reader.read_varint());
+            (field_number == 3 ? attr.i : attr.type) = value;
+            break;
+        }
+
+        case 7: // floats
+            read_floats(wire_type, end_pos, float_pool);
+            attr.floats_end = float_pool.size();
+            break;
+
+        case 8: // ints
+            read_varints(wire_type, end_pos, int_pool);
+            attr.ints_end = int_pool.size();
+            break;
+
+        default: // t, g, strings, tensors, graphs, doc_string — пропускаем
+            skipField(wire_type);
+            break;
+        }
+    }
+
+    pending.push_back(attr);
+}
+
+void ONNXStreamParser::parseTensor(uint64_t length)
+{
+    uint64_t end_pos = reader.get_cur_pos() + length;
+
+    text.clear();
+    int_pool.clear();
+    TextRef name, location;
+    StreamTensor tensor;
+    bool external = false;
+    uint64_t external_offset = 0, external_length = 0;
+
+    // смещения и длины данных: поле данных пропускается целиком
+    auto note_data = [&](uint64_t offset, uint64_t bytes) {
+        if (tensor.data_length == 0) tensor.data_offset = offset;
+        tensor.data_length += bytes;
+    };
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        switch (field_number)
+        {
+        case 1: // dims
+            read_varints(wire_type, end_pos, int_pool);
+            break;
+
+        case 2: // data_type
+            if (wire_type != 0)
+            {
+                skipField(wire_type);
+                break;
+            }
+            tensor.data_type = static_cast<int32_t>(reader.read_varint());
+            break;
+
+        case 8: // name
+        {
+            if (wire_type != 2)
+            {
+                skipField(wire_type);
+                break;
+            }
+            uint64_t len = reader.read_varint();
+            if (reader.get_cur_pos() + len > end_pos) throw std::runtime_error("Поле выходит за границу тензора");
+            name = read_text(len, true);
+            break;
+        }
+
+        case 4: case 5: case 7: case 9: case 10: case 11: // float/int32/int64/raw/double/uint64 data
+        {
+            uint64_t start = reader.get_cur_pos();
+            if (wire_type == 2)
+            {
+                uint64_t len = reader.read_varint();
+                note_data(reader.get_cur_pos(), len);
+                reader.skip(len);
+            }
+            else
+            {
+                skipField(wire_type);
+                note_data(start, reader.get_cur_pos() - start);
+            }
+            break;
+        }
+
+        case 13: // external_data
+        {
+            if (wire_type != 2)
+            {
+                skipField(wire_type);
+                break;
+            }
+            uint64_t len = reader.read_varint();
+            if (reader.get_cur_pos() + len > end_pos) throw std::runtime_error("Поле выходит за границу тензора");
+
+            size_t mark = text.size();
+            TextRef key, value;
+            parseStringEntry(len, key, value);
+
+            std::string_view key_view = view_of(key);
+            if (key_view == "location")
+            {
+                location = value;
+                break; // строка остаётся в text
+            }
+            if (key_view == "offset" || key_view == "length")
+            {
+                uint64_t number = std::strtoull(std::string(view_of(value)).c_str(), nullptr, 10);
+                (key_view == "offset" ? external_offset : external_length) = number;
+            }
+            text.resize(mark);
+            break;
+        }
+
+        case 14: // data_location
+            if (wire_type != 0)
+            {
+                skipField(wire_type);
+                break;
+            }
+            external = reader.read_varint() == 1;
+            break;
+
+        default:
+            skipField(wire_type);
+            break;
+        }
+    }
+
+    if (!callbacks.on_tensor) return;
+
+    tensor.name = view_of(name);
+    tensor.dims = Span<int64_t>(int_pool.data(), int_pool.size());
+    if (external)
+    {
+        tensor.external_location = view_of(location);
+        tensor.data_offset = external_offset;
+        tensor.data_length = external_length;
+    }
+    callbacks.on_tensor(tensor);
+}
+
+void ONNXStreamParser::parseOpset(uint64_t length)
+{
+    uint64_t end_pos = reader.get_cur_pos() + length;
+    TextRef domain;
+    uint64_t version = 0;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        if (field_number == 1 && wire_type == 2) domain = read_text(reader.read_varint(), false);
+        else if (field_number == 2 && wire_type == 0) version = reader.read_varint();
+        else skipField(wire_type);
+    }
+
+    if (callbacks.on_metadata)
+    {
+        // пустой домен — стандартный ai.onnx
+        std::string_view domain_name = domain.length ? view_of(domain) : std::string_view("ai.onnx");
+        callbacks.on_metadata("opset:" + std::string(domain_name), std::to_string(version));
+    }
+}
+
+void ONNXStreamParser::parseStringEntry(uint64_t length, TextRef& key, TextRef& value)
+{
+    uint64_t end_pos = reader.get_cur_pos() + length;
+
+    while (reader.get_cur_pos() < end_pos)
+    {
+        uint64_t tag = reader.read_varint();
+        int wire_type = tag & 0x07;
+        uint64_t field_number = tag >> 3;
+
+        if ((field_number == 1 || field_number == 2) && wire_type == 2)
+        {
+            uint64_t len = reader.read_varint();
+            if (reader.get_cur_pos() + len > end_pos) throw std::runtime_error("Поле выходит за границу записи");
+            (field_number == 1 ? key : value) = read_text(len, false);
+        }
+        else
+        {
+            skipField(wire_type);
+        }
+    }
+}
@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "thread_pool.h"
+
+// пул и очередь, которыми владеет текущий поток (задачи из задач идут в свою очередь)
+static thread_local ThreadPool* current_pool = nullptr;
+static thread_local size_t current_queue = 0;
+
+// поток выполняет часть parallel_for: вложенные разбиения идут последовательно
+static thread_local bool in_part = false;
+
+// "0-3,8-11" → {0, 1, 2, 3, 8, 9, 10, 11}
+static std::vector<int> parse_cpu_list(const std::string& list)
+{
+    std::vector<int> result;
+    std::stringstream ranges(list);
+    std::string range;
+
+    while (std::getline(ranges, range, ','))
+    {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) result.push_back(cpu);
+    }
+    return result;
+}
+
+// ядра по порядку узлов NUMA (Linux sysfs); без NUMA — 0..N-1
+static std::vector<int> cpus_by_numa_node()
+{
+    std::vector<int> cpus;
+
+    for (int node = 0;; node++)
+    {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list)) break;
+
+        std::vector<int> node_cpus = parse_cpu_list(list);
+        cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+    }
+
+    if (cpus.empty())
+    {
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); cpu++)
+        {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+ThreadPool::ThreadPool(size_t threads, bool pin_threads)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (pin_threads) cpus = cpus_by_numa_node();
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    for (size_t i = 1; i < threads; i++)
+    {
+        workers.emplace_back([this, i]() { worker_loop(i); });
+
+#ifdef __linux__
+        // закрепление до первой задачи: страницы, которых поток коснётся первым, лягут на его узел
+        if (cpu_of(i) >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu_of(i), &set);
+            pthread_setaffinity_np(workers.back().native_handle(), sizeof(set), &set);
+        }
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers) worker.join();
+}
+
+ThreadPool* ThreadPool::current()
+{
+    return current_pool;
+}
+
+size_t ThreadPool::current_thread()
+{
+    return current_queue;
+}
+
+// потоки спят на wake только проверив условие под sleep_mutex после sleeping++,
+// поэтому будить нужно, лишь если кто-то спит (seq_cst на счётчиках задач и sleeping)
+void ThreadPool::wake_one()
+{
+    if (sleeping.load() == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wake_all()
+{
+    if (sleeping.load() == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_all();
+}
+
+std::function<void()> ThreadPool::wrap_task(TaskGroup& group, std::function<void()> task)
+{
+    group.pending.fetch_add(1);
+
+    return [this, &group, task = std::move(task)]() {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            bool expected = false;
+            if (group.error.compare_exchange_strong(expected, true)) group.first_error = std::current_exception();
+        }
+
+        // после уменьшения счётчика группа может быть уже уничтожена ждущим потоком
+        if (group.pending.fetch_sub(1) == 1) wake_all();
+    };
+}
+
+void ThreadPool::submit(TaskGroup& group, std::function<void()> task)
+{
+    std::function<void()> wrapped = wrap_task(group, std::move(task));
+
+    size_t index = current_pool == this ? current_queue : next_queue.fetch_add(1) % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(wrapped));
+    }
+    queued.fetch_add(1);
+    wake_one();
+}
+
+void ThreadPool::submit_to(size_t thread, TaskGroup& group, std::function<void()> task)
+{
+    std::function<void()> wrapped = wrap_task(group, std::move(task));
+
+    WorkQueue& queue = *queues[thread % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.pinned.push_back(std::move(wrapped));
+    }
+    queue.pinned_count.fetch_add(1);
+
+    // нужен именно поток thread — будим всех
+    wake_all();
+}
+
+std::function<void()> ThreadPool::take_pinned(size_t index)
+{
+    WorkQueue& own = *queues[index];
+    if (own.pinned_count.load() == 0) return nullptr;
+
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.pinned.empty()) return nullptr;
+
+    std::function<void()> task = std::move(own.pinned.front());
+    own.pinned.pop_front();
+    own.pinned_count.fetch_sub(1);
+    return task;
+}
+
+void ThreadPool::run_pinned()
+{
+    if (current_pool != this) return;
+
+    while (std::function<void()> task = take_pinned(current_queue))
+    {
+        task();
+    }
+}
+
+bool ThreadPool::try_run_one(size_t index)
+{
+    // сначала закреплённые за этим потоком: их больше никто не выполнит
+    std::function<void()> task = take_pinned(index);
+
+    bool stolen_or_own = false;
+    for (size_t k = 0; k < queues.size() && !task; k++)
+    {
+        WorkQueue& queue = *queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+
+        // своя очередь — с конца (LIFO), чужая — с начала (самая старая задача)
+        if (k == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        stolen_or_own = true;
+    }
+
+    if (!task) return false;
+
+    if (stolen_or_own) queued.fetch_sub(1);
+    task();
+    return true;
+}
+
+void ThreadPool::sleep_until_work(size_t index, const std::function<bool()>& done)
+{
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    sleeping.fetch_add(1);
+    wake.wait(lock, [&]() { return queued.load() > 0 || queues[index]->pinned_count.load() > 0 || done(); });
+    sleeping.fetch_sub(1);
+}
+
+void ThreadPool::worker_loop(size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+
+    while (true)
+    {
+        if (try_run_one(index)) continue;
+        if (stopping.load() && queued.load() == 0 && queues[index]->pinned_count.load() == 0) return;
+
+        sleep_until_work(index, [this]() { return stopping.load(); });
+    }
+}
+
+void ThreadPool::wait(TaskGroup& group)
+{
+    // посторонний поток работает из очереди 0, поток пула — из своей
+    ThreadPool* saved_pool = current_pool;
+    size_t saved_queue = current_queue;
+    size_t index = current_pool == this ? current_queue : 0;
+    current_pool = this;
+    current_queue = index;
+
+    while (group.pending.load() != 0)
+    {
+        if (try_run_one(index)) continue;
+
+        // задач нет, но группа не завершена: её задачи выполняются в других потоках
+        sleep_until_work(index, [&]() { return group.pending.load() == 0; });
+    }
+
+    current_pool = saved_pool;
+    current_queue = saved_queue;
+
+    if (group.error.load())
+    {
+        std::exception_ptr error = std::exchange(group.first_error, nullptr);
+        group.error.store(false);
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::join(const std::function<bool()>& done)
+{
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    finished.wait(lock, done);
+}
+
+void ThreadPool::notify_joined()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    finished.notify_all();
+}
+
+size_t parallel_parts(size_t n, size_t grain)
+{
+    ThreadPool* pool = ThreadPool::current();
+    if (pool == nullptr || pool->size() <= 1 || in_part) return 1;
+
+    size_t by_grain = n / std::max<size_t>(grain, 1);
+    return std::max<size_t>(1, std::min(pool->size(), by_grain));
+}
+
+// общее состояние одного разбиения. Закреплённая задача может выполниться уже после
+// возврата из parallel_for (часть забрал владелец), поэтому состояние — в куче, а run
+// вызывается только для захваченной части, пока владелец ждёт
+struct PartsState
+{
+    std::function<void(size_t)> run;
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+    std::atomic<size_t> done{0};
+    std::atomic<bool> error{false};
+    std::exception_ptr first_error;    // пишется один раз, под флагом error
+    TaskGroup group;                   // для submit_to; задачи исключений не бросают
+
+    bool claim(size_t k) { return !claimed[k].exchange(true); }
+
+    void run_claimed(size_t k)
+    {
+        in_part = true;
+        try
+        {
+            run(k);
+        }
+        catch (...)
+        {
+            bool expected = false;
+            if (error.compare_exchange_strong(expected, true)) first_error = std::current_exception();
+        }
+        in_part = false;
+    }
+};
+
+void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& fn)
+{
+    if (end <= begin) return;
+
+    size_t n = end - begin;
+    size_t parts = parallel_parts(n, grain);
+    if (parts == 1)
+    {
+        fn(begin, end);
+        return;
+    }
+
+    ThreadPool& pool = *ThreadPool::current();
+    size_t self = ThreadPool::current_thread();
+
+    auto state = std::make_shared<PartsState>();
+    state->run = [&fn, begin, n, parts](size_t k) {
+        fn(begin + partition_begin(n, parts, k), begin + partition_begin(n, parts, k + 1));
+    };
+    state->claimed.reset(new std::atomic<bool>[parts]);
+    for (size_t k = 0; k < parts; k++) state->claimed[k].store(false, std::memory_order_relaxed);
+
+    for (size_t k = 0; k < parts; k++)
+    {
+        if (k == self) continue;
+        pool.submit_to(k, state->group, [&pool, state, k, parts]() {
+            if (!state->claim(k)) return;
+            state->run_claimed(k);
+            if (state->done.fetch_add(1) + 1 == parts) pool.notify_joined();
+        });
+    }
+
+    // своя часть — сразу, затем части, которые их потоки ещё не начали (заняты другой
+    // работой): ждать приходится только уже идущие части, а они никого не ждут
+    size_t done_here = 0;
+    for (size_t i = 0; i < parts; i++)
+    {
+        size_t k = (self + i) % parts;
+        if (!state->claim(k)) continue;
+        state->run_claimed(k);
+        done_here++;
+    }
+
+    // части ссылаются на этот кадр стека: ждём их и при исключении
+    if (state->done.fetch_add(done_here) + done_here != parts)
+    {
+        pool.join([&]() { return state->done.load() == parts; });
+    }
+
+    if (state->error.load()) std::rethrow_exception(state->first_error);
+}
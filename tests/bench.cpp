@@ -0,0 +1,1190 @@
+// Бенчмарки парсера. Запускаются из ctest (см. CMakeLists.txt):
+//   parser_bench alloc [model.onnx ...]   — число выделений памяти на узел
+//   parser_bench gemm [--quick]           — GFLOP/s sgemm по бэкендам против наивного цикла
+//   parser_bench conv [--quick]           — время алгоритмов свёртки против прямого цикла
+//   parser_bench parallel [--quick]       — параллельный исполнитель на ветвистом графе и на цепочке
+//   parser_bench parse [--quick]          — многопоточный разбор большой синтетической модели
+//   parser_bench varint [model.onnx ...]  — varint'ов в секунду: быстрый декодер против побайтового
+//   parser_bench cache [--quick]          — загрузка графа из бинарного кеша против разбора
+//   parser_bench stream [--quick]         — потоковый разбор: МБ/с и память, не зависящая от модели
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+#include "conv.h"
+#include "executor.h"
+#include "gemm.h"
+#include "graph_cache.h"
+#include "parser.h"
+#include "stream_parser.h"
+
+#ifdef ONNX_PARSE_PROFILE
+// operator new уже подменён профилировщиком разбора и считает выделения сам
+static size_t allocations_so_far() { return parse_profile_allocation_count(); }
+#else
+// счётчик выделений памяти: подменяем глобальный operator new
+static std::atomic<size_t> allocation_count{0};
+
+void* operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+static size_t allocations_so_far() { return allocation_count.load(std::memory_order_relaxed); }
+#endif
+
+// число выделений памяти во время вызова fn
+template <typename Fn>
+static size_t count_allocations(Fn&& fn)
+{
+    size_t before = allocations_so_far();
+    fn();
+    return allocations_so_far() - before;
+}
+
+// имена как в больших трансформерах: длиннее SSO-буфера std::string
+static std::string tensor_name(size_t layer, const char* suffix)
+{
+    return "/model/layers." + std::to_string(layer) + "/self_attn/" + suffix;
+}
+
+// сборка графа из n узлов: копирование аргументов или перемещение
+static size_t build_graph(size_t n, bool use_move)
+{
+    Graph graph;
+
+    return count_allocations([&]() {
+        for (size_t i = 0; i < n; i++)
+        {
+            std::string name = tensor_name(i, "q_proj/MatMul");
+            std::string op = "MatMul";
+            std::string input = tensor_name(i ? i - 1 : 0, "q_proj/MatMul_output_0"); // цепочка узлов
+            std::string weight = tensor_name(i, "q_proj/weight_transposed");
+            std::string output = tensor_name(i, "q_proj/MatMul_output_0");
+
+            Node node;
+            if (use_move)
+            {
+                node.set_name(std::move(name));
+                node.set_op_type(std::move(op));
+                node.add_input(graph.intern_tensor(input));
+                node.add_input(graph.intern_tensor(weight));
+                node.add_output(graph.intern_tensor(output));
+                graph.add_node(std::move(node));
+            }
+            else
+            {
+                node.set_name(name);
+                node.set_op_type(op);
+                node.add_input(graph.intern_tensor(input));
+                node.add_input(graph.intern_tensor(weight));
+                node.add_output(graph.intern_tensor(output));
+                graph.add_node(node);
+            }
+        }
+    });
+}
+
+// выделения памяти на узел при сборке графа и при разборе моделей
+static int bench_alloc(int argc, char* argv[])
+{
+    const size_t n = 100000;
+
+    // сами строки-аргументы: одинаковы в обоих вариантах, вычитаем их
+    size_t baseline = count_allocations([&]() {
+        for (size_t i = 0; i < n; i++)
+        {
+            std::string name = tensor_name(i, "q_proj/MatMul");
+            std::string input = tensor_name(i ? i - 1 : 0, "q_proj/MatMul_output_0");
+            std::string weight = tensor_name(i, "q_proj/weight_transposed");
+            std::string output = tensor_name(i, "q_proj/MatMul_output_0");
+        }
+    });
+
+    double copied = double(build_graph(n, false) - baseline) / n;
+    double moved = double(build_graph(n, true) - baseline) / n;
+
+    std::cout << "=== Allocations per node (" << n << " nodes) ===\n";
+    std::cout << "  copy builder: " << copied << "\n";
+    std::cout << "  move builder: " << moved << "\n";
+
+    for (int i = 0; i < argc; i++)
+    {
+        size_t nodes = 0;
+        size_t allocs = count_allocations([&]() {
+            ONNXParser parser(argv[i]);
+            Graph graph = parser.parse();
+            nodes = graph.get_nodes().size();
+        });
+
+        std::cout << "  parse " << argv[i] << ": " << nodes << " nodes, "
+                  << double(allocs) / (nodes ? nodes : 1) << " allocations per node\n";
+    }
+
+    // перемещение не должно выделять больше, чем копирование
+    if (moved > copied)
+    {
+        std::cerr << "move builder allocates more than copy builder\n";
+        return 1;
+    }
+    return 0;
+}
+
+// секунды на один вызов fn: повторяем, пока не наберётся min_seconds
+template <typename Fn>
+static double time_per_call(Fn&& fn, double min_seconds)
+{
+    using clock = std::chrono::steady_clock;
+
+    fn(); // прогрев: упаковочные буферы, кэши
+    size_t calls = 0;
+    auto start = clock::now();
+    double elapsed = 0.0;
+
+    do
+    {
+        fn();
+        calls++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_seconds);
+
+    return elapsed / calls;
+}
+
+// форма умножения: C[M, N] = op(A)[M, K] * op(B)[K, N]
+struct GemmShape
+{
+    const char* label;
+    size_t m, n, k;
+    bool trans_a, trans_b;
+};
+
+// GFLOP/s sgemm на всех доступных бэкендах и наивного тройного цикла;
+// результаты бэкендов сверяются с наивным циклом
+static int bench_gemm(bool quick)
+{
+    // квадратные и «узкие» формы полносвязных слоёв (Gemm с transB = 1, как в моделях из tests/)
+    std::vector<GemmShape> shapes = {
+        {"square", 64, 64, 64, false, false},
+        {"square", 128, 128, 128, false, false},
+        {"square", 256, 256, 256, false, false},
+        {"square", 512, 512, 512, false, false},
+        {"square tA", 256, 256, 256, true, false},
+        {"fc1 b=1", 1, 128, 6272, false, true},
+        {"fc1 b=32", 32, 128, 6272, false, true},
+        {"fc2 b=1", 1, 10, 128, false, true},
+        {"fc2 b=32", 32, 10, 128, false, true},
+        {"matmul b=1", 1, 64, 1568, false, false},
+        {"odd edges", 37, 53, 71, true, true},
+    };
+    if (quick)
+    {
+        // ctest: только сверка на малых формах, в том числе с краями не кратными плитке
+        shapes = {
+            {"square", 64, 64, 64, false, false},
+            {"square tA tB", 48, 40, 33, true, true},
+            {"fc b=1", 1, 10, 128, false, true},
+            {"matmul b=1", 1, 20, 50, false, false},
+            {"odd edges", 37, 53, 300, false, true},
+            {"odd edges tA", 101, 7, 13, true, false},
+        };
+    }
+
+    const double min_seconds = quick ? 0.0 : 0.2;
+    const GemmBackend backends[] = {GemmBackend::SCALAR, GemmBackend::AVX2, GemmBackend::AVX512};
+
+    std::cout << "=== GEMM, GFLOP/s (default backend: " << gemm_backend_name(gemm_backend()) << ") ===\n";
+    std::cout << std::left << std::setw(14) << "shape" << std::setw(20) << "M x N x K" << std::right
+              << std::setw(9) << "naive";
+    for (GemmBackend backend : backends)
+    {
+        if (gemm_backend_available(backend)) std::cout << std::setw(9) << gemm_backend_name(backend);
+    }
+    std::cout << "\n";
+
+    bool mismatch = false;
+
+    for (const GemmShape& s : shapes)
+    {
+        // детерминированные данные; op(A) и op(B) хранятся с учётом транспонирования
+        std::vector<float> a(s.m * s.k), b(s.k * s.n);
+        for (size_t i = 0; i < a.size(); i++) a[i] = float((i * 37) % 101) / 50.0f - 1.0f;
+        for (size_t i = 0; i < b.size(); i++) b[i] = float((i * 53) % 97) / 48.0f - 1.0f;
+        size_t lda = s.trans_a ? s.m : s.k;
+        size_t ldb = s.trans_b ? s.k : s.n;
+
+        // C заполнена, чтобы проверить и beta
+        std::vector<float> c_init(s.m * s.n);
+        for (size_t i = 0; i < c_init.size(); i++) c_init[i] = float(i % 7) - 3.0f;
+        const float alpha = 0.5f, beta = 0.25f;
+
+        std::vector<float> expected = c_init;
+        sgemm_reference(s.trans_a, s.trans_b, s.m, s.n, s.k, alpha, a.data(), lda, b.data(), ldb, beta,
+                        expected.data(), s.n);
+
+        const double flops = 2.0 * s.m * s.n * s.k;
+        std::vector<float> c = c_init;
+
+        double naive = time_per_call([&]() {
+            sgemm_reference(s.trans_a, s.trans_b, s.m, s.n, s.k, alpha, a.data(), lda, b.data(), ldb, beta,
+                            c.data(), s.n);
+        }, min_seconds);
+
+        std::cout << std::left << std::setw(14) << s.label
+                  << std::setw(20) << (std::to_string(s.m) + " x " + std::to_string(s.n) + " x " + std::to_string(s.k))
+                  << std::right << std::fixed << std::setprecision(2) << std::setw(9) << flops / naive * 1e-9;
+
+        for (GemmBackend backend : backends)
+        {
+            if (!gemm_backend_available(backend)) continue;
+
+            c = c_init;
+            sgemm(backend, s.trans_a, s.trans_b, s.m, s.n, s.k, alpha, a.data(), lda, b.data(), ldb, beta,
+                  c.data(), s.n);
+
+            for (size_t i = 0; i < c.size(); i++)
+            {
+                float tolerance = 1e-4f * s.k + 1e-4f * std::fabs(expected[i]);
+                if (std::fabs(c[i] - expected[i]) > tolerance)
+                {
+                    std::cerr << gemm_backend_name(backend) << " mismatch at " << s.label << "[" << i
+                              << "]: " << c[i] << " != " << expected[i] << "\n";
+                    mismatch = true;
+                    break;
+                }
+            }
+
+            double seconds = time_per_call([&]() {
+                sgemm(backend, s.trans_a, s.trans_b, s.m, s.n, s.k, alpha, a.data(), lda, b.data(), ldb, beta,
+                      c.data(), s.n);
+            }, min_seconds);
+            std::cout << std::setw(9) << flops / seconds * 1e-9;
+        }
+        std::cout << "\n";
+    }
+
+    return mismatch ? 1 : 0;
+}
+
+// свёртка для бенчмарка: вход [N, C, H, W], M фильтров k x k
+struct ConvShape
+{
+    const char* label;
+    int64_t batch, channels, height, width;
+    int64_t filters, kernel, stride, pad, dilation, group;
+};
+
+// время каждого применимого алгоритма свёртки и ускорение относительно прямого цикла;
+// результаты сверяются с прямым циклом. Winograd — с ядрами U, посчитанными заранее, как
+// в исполнителе. Полный прогон проваливается, если выбранный автоматически алгоритм
+// заметно медленнее im2col
+static int bench_conv(bool quick)
+{
+    // conv1/conv2 — свёртки из tests/complex_net.onnx и custom_net.onnx
+    std::vector<ConvShape> shapes = {
+        {"conv1 net", 1, 1, 28, 28, 16, 3, 1, 1, 1, 1},
+        {"conv2 net", 1, 16, 28, 28, 32, 3, 2, 1, 1, 1},
+        {"3x3 c64", 1, 64, 56, 56, 64, 3, 1, 1, 1, 1},
+        {"3x3 c128", 1, 128, 28, 28, 128, 3, 1, 1, 1, 1},
+        {"3x3 c32 b8", 8, 32, 28, 28, 32, 3, 1, 1, 1, 1},
+        {"3x3 c16", 1, 16, 28, 28, 16, 3, 1, 1, 1, 1},
+        {"3x3 c128 7x7", 1, 128, 7, 7, 128, 3, 1, 1, 1, 1},
+        {"3x3 c64 112", 1, 64, 112, 112, 64, 3, 1, 1, 1, 1},
+        {"1x1 64->128", 1, 64, 56, 56, 128, 1, 1, 0, 1, 1},
+        {"5x5 dil2", 1, 16, 32, 32, 32, 5, 1, 4, 2, 1},
+        {"dw 3x3 c128", 1, 128, 56, 56, 128, 3, 1, 1, 1, 128},
+        {"dw 3x3 s2", 1, 64, 56, 56, 64, 3, 2, 1, 1, 64},
+        {"grouped g4", 1, 64, 28, 28, 64, 3, 1, 1, 1, 4},
+    };
+    if (quick)
+    {
+        // ctest: только сверка, формы с нечётными краями и паддингом
+        shapes = {
+            {"conv1 net", 1, 1, 28, 28, 16, 3, 1, 1, 1, 1},
+            {"3x3 odd", 2, 9, 11, 13, 10, 3, 1, 1, 1, 1},
+            {"3x3 nopad", 1, 8, 7, 6, 8, 3, 1, 0, 1, 1},
+            {"s2 dil2", 1, 6, 15, 17, 5, 3, 2, 2, 2, 1},
+            {"1x1", 2, 12, 9, 9, 7, 1, 1, 0, 1, 1},
+            {"dw x2", 1, 4, 10, 9, 8, 3, 2, 1, 1, 4},
+            {"grouped g3", 1, 6, 8, 8, 9, 3, 1, 1, 1, 3},
+        };
+    }
+
+    const double min_seconds = quick ? 0.0 : 0.2;
+    const ConvAlgorithm algorithms[] = {ConvAlgorithm::DIRECT, ConvAlgorithm::IM2COL, ConvAlgorithm::WINOGRAD,
+                                        ConvAlgorithm::DEPTHWISE};
+
+    // допуск на шум замеров: выбранный алгоритм может уступать im2col не больше 10%
+    const double chosen_slack = 1.1;
+
+    std::cout << "=== Conv, ms per call (speedup vs direct), * = chosen automatically ===\n";
+    bool mismatch = false;
+    bool bad_choice = false;
+
+    for (const ConvShape& s : shapes)
+    {
+        Node node;
+        node.set_op_type("Conv");
+        node.add_ints_attr("strides", {s.stride, s.stride});
+        node.add_ints_attr("dilations", {s.dilation, s.dilation});
+        node.add_ints_attr("pads", {s.pad, s.pad, s.pad, s.pad});
+        node.add_int_attr("group", s.group);
+
+        std::vector<int64_t> x_shape = {s.batch, s.channels, s.height, s.width};
+        std::vector<int64_t> w_shape = {s.filters, s.channels / s.group, s.kernel, s.kernel};
+        ConvGeometry g = conv_geometry(node, x_shape, w_shape);
+
+        std::vector<float> x(shape_size(x_shape)), w(shape_size(w_shape)), bias(s.filters);
+        for (size_t i = 0; i < x.size(); i++) x[i] = float((i * 37) % 101) / 50.0f - 1.0f;
+        for (size_t i = 0; i < w.size(); i++) w[i] = float((i * 53) % 97) / 48.0f - 1.0f;
+        for (size_t i = 0; i < bias.size(); i++) bias[i] = float(i % 5) * 0.1f;
+
+        size_t out_size = shape_size({g.batch, g.out_channels, g.out_h, g.out_w});
+        std::vector<float> expected(out_size), y(out_size);
+        conv2d(ConvAlgorithm::DIRECT, g, x.data(), w.data(), bias.data(), expected.data());
+
+        std::vector<float> u;
+        if (conv_algorithm_supported(ConvAlgorithm::WINOGRAD, g)) u = winograd_kernels(w.data(), s.filters, s.channels);
+
+        std::cout << std::left << std::setw(14) << s.label << std::right;
+        ConvAlgorithm chosen = choose_conv_algorithm(g);
+        double direct_seconds = 0.0, im2col_seconds = 0.0, chosen_seconds = 0.0;
+
+        for (ConvAlgorithm algorithm : algorithms)
+        {
+            if (!conv_algorithm_supported(algorithm, g)) continue;
+
+            std::fill(y.begin(), y.end(), 0.0f);
+            const float* pu = u.empty() ? nullptr : u.data();
+            conv2d(algorithm, g, x.data(), w.data(), bias.data(), y.data(), pu);
+
+            float tolerance = 1e-4f * float(w_shape[1] * s.kernel * s.kernel);
+            for (size_t i = 0; i < y.size(); i++)
+            {
+                if (std::fabs(y[i] - expected[i]) > tolerance + 1e-4f * std::fabs(expected[i]))
+                {
+                    std::cerr << conv_algorithm_name(algorithm) << " mismatch at " << s.label << "[" << i
+                              << "]: " << y[i] << " != " << expected[i] << "\n";
+                    mismatch = true;
+                    break;
+                }
+            }
+
+            double seconds = time_per_call([&]() {
+                conv2d(algorithm, g, x.data(), w.data(), bias.data(), y.data(), pu);
+            }, min_seconds);
+            if (algorithm == ConvAlgorithm::DIRECT) direct_seconds = seconds;
+            if (algorithm == ConvAlgorithm::IM2COL) im2col_seconds = seconds;
+            if (algorithm == chosen) chosen_seconds = seconds;
+
+            std::cout << "  " << conv_algorithm_name(algorithm) << (algorithm == chosen ? "*" : "") << " "
+                      << std::fixed << std::setprecision(3) << seconds * 1e3 << " ms (x"
+                      << std::setprecision(1) << direct_seconds / seconds << ")";
+        }
+        std::cout << "\n";
+
+        if (!quick && chosen_seconds > im2col_seconds * chosen_slack)
+        {
+            // возможно, шум: лучшее из нескольких чередующихся замеров обоих алгоритмов
+            for (int attempt = 0; attempt < 5; attempt++)
+            {
+                const float* pu = u.empty() ? nullptr : u.data();
+                chosen_seconds = std::min(chosen_seconds, time_per_call([&]() {
+                    conv2d(chosen, g, x.data(), w.data(), bias.data(), y.data(), pu);
+                }, min_seconds));
+                im2col_seconds = std::min(im2col_seconds, time_per_call([&]() {
+                    conv2d(ConvAlgorithm::IM2COL, g, x.data(), w.data(), bias.data(), y.data());
+                }, min_seconds));
+            }
+        }
+        if (!quick && chosen_seconds > im2col_seconds * chosen_slack)
+        {
+            std::cerr << s.label << ": chosen " << conv_algorithm_name(chosen) << " is slower than im2col\n";
+            bad_choice = true;
+        }
+    }
+
+    return mismatch || bad_choice ? 1 : 0;
+}
+
+// граф из width ветвей по depth пар Conv 3x3 + Relu над общим входом x [1, C, H, W];
+// ветви сходятся в Concat по каналам. width == 1 — цепочка из depth свёрток
+static Graph branchy_graph(size_t width, size_t depth, int64_t channels)
+{
+    Graph graph;
+    TensorId x = graph.intern_tensor("x");
+    graph.add_input(x);
+
+    std::vector<float> weights(static_cast<size_t>(channels * channels * 9));
+    // масштаб ~ 1/sqrt(C * 9): активации не затухают до денормалов на длинной цепочке
+    const float scale = 3.0f / std::sqrt(float(channels * 9));
+    for (size_t i = 0; i < weights.size(); i++) weights[i] = (float((i * 53) % 97) / 48.0f - 1.0f) * scale;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(weights.data());
+
+    Tensor w;
+    w.set_name("w");
+    w.set_data_type(FLOAT);
+    for (int64_t dim : {channels, channels, int64_t(3), int64_t(3)}) w.add_dim(dim);
+    w.set_raw_data(std::vector<uint8_t>(bytes, bytes + weights.size() * sizeof(float)));
+    graph.add_tensor(std::move(w));
+
+    std::vector<TensorId> branch_outputs;
+    for (size_t b = 0; b < width; b++)
+    {
+        TensorId current = x;
+        for (size_t d = 0; d < depth; d++)
+        {
+            std::string prefix = "b" + std::to_string(b) + "_" + std::to_string(d);
+
+            Node conv;
+            conv.set_name(prefix + "_conv");
+            conv.set_op_type("Conv");
+            conv.add_ints_attr("pads", {1, 1, 1, 1});
+            conv.add_input(current);
+            conv.add_input(graph.intern_tensor("w"));
+            conv.add_output(graph.intern_tensor(prefix + "_c"));
+            graph.add_node(std::move(conv));
+
+            Node relu;
+            relu.set_name(prefix + "_relu");
+            relu.set_op_type("Relu");
+            relu.add_input(graph.intern_tensor(prefix + "_c"));
+            current = graph.intern_tensor(prefix + "_r");
+            relu.add_output(current);
+            graph.add_node(std::move(relu));
+        }
+        branch_outputs.push_back(current);
+    }
+
+    TensorId y = branch_outputs[0];
+    if (width > 1)
+    {
+        Node concat;
+        concat.set_name("concat");
+        concat.set_op_type("Concat");
+        concat.add_int_attr("axis", 1);
+        for (TensorId out : branch_outputs) concat.add_input(out);
+        y = graph.intern_tensor("y");
+        concat.add_output(y);
+        graph.add_node(std::move(concat));
+    }
+    graph.add_output(y);
+    return graph;
+}
+
+// время выполнения графа исполнителем на 1..N потоках; выходы сверяются с однопоточными
+static int bench_parallel(bool quick)
+{
+    const int64_t channels = quick ? 8 : 32;
+    const int64_t size = quick ? 12 : 56;
+    const size_t width = quick ? 4 : 8;
+    const size_t depth = quick ? 2 : 4;
+    const double min_seconds = quick ? 0.0 : 0.3;
+
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> thread_counts = {1, 2, 4};
+    if (hardware > 4) thread_counts.push_back(hardware);
+
+    std::vector<float> data(static_cast<size_t>(channels * size * size));
+    for (size_t i = 0; i < data.size(); i++) data[i] = float((i * 37) % 101) / 50.0f - 1.0f;
+    std::unordered_map<std::string, Value> inputs;
+    inputs.emplace("x", Value({1, channels, size, size}, data));
+
+    std::cout << "=== Parallel executor, ms per run (speedup vs 1 thread), " << hardware << " hardware threads ===\n";
+    bool mismatch = false;
+
+    // одинаковый объём работы: width ветвей по depth или одна цепочка width * depth
+    struct Case { const char* label; size_t width, depth; };
+    for (const Case& c : {Case{"wide", width, depth}, Case{"chain", 1, width * depth}})
+    {
+        Graph graph = branchy_graph(c.width, c.depth, channels);
+        std::cout << std::left << std::setw(8) << c.label << std::right;
+
+        std::unordered_map<std::string, Value> expected;
+        double serial_seconds = 0.0;
+
+        for (size_t threads : thread_counts)
+        {
+            Executor executor(graph);
+            executor.set_threads(threads);
+
+            std::unordered_map<std::string, Value> results = executor.run(inputs);
+            if (threads == 1) expected = results;
+
+            for (const auto& [name, value] : expected)
+            {
+                const Value& actual = results.at(name);
+                if (actual.get_shape() != value.get_shape() ||
+                    !std::equal(value.data(), value.data() + value.element_count(), actual.data()))
+                {
+                    std::cerr << c.label << ": " << threads << " threads, output " << name << " differs\n";
+                    mismatch = true;
+                }
+            }
+
+            double seconds = time_per_call([&]() { executor.run(inputs); }, min_seconds);
+            if (threads == 1) serial_seconds = seconds;
+
+            std::cout << "  " << threads << "t " << std::fixed << std::setprecision(3) << seconds * 1e3
+                      << " ms (x" << std::setprecision(2) << serial_seconds / seconds << ")";
+        }
+        std::cout << "\n";
+    }
+
+    return mismatch ? 1 : 0;
+}
+
+// минимальная запись protobuf для синтетических моделей
+static void put_varint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static void put_int(std::string& out, uint64_t field, uint64_t value)
+{
+    put_varint(out, field << 3);
+    put_varint(out, value);
+}
+
+static void put_bytes(std::string& out, uint64_t field, const std::string& bytes)
+{
+    put_varint(out, (field << 3) | 2);
+    put_varint(out, bytes.size());
+    out += bytes;
+}
+
+// ValueInfoProto: float-тензор формы [batch, dim]
+static std::string value_info(const std::string& name, int64_t dim)
+{
+    std::string batch, size, shape, tensor, type, info;
+    put_bytes(batch, 2, "batch");                         // dim_param
+    put_int(size, 1, static_cast<uint64_t>(dim));         // dim_value
+    put_bytes(shape, 1, batch);
+    put_bytes(shape, 1, size);
+    put_int(tensor, 1, FLOAT);
+    put_bytes(tensor, 2, shape);
+    put_bytes(type, 1, tensor);
+    put_bytes(info, 1, name);
+    put_bytes(info, 2, type);
+    return info;
+}
+
+// модель-цепочка из layers слоёв Gemm(x, W, b) → Relu, у каждого слоя свои веса
+// и value_info выходов — как у экспортированного трансформера, только мелкие тензоры
+static std::string synthetic_model(size_t layers)
+{
+    const int64_t dim = 4;
+    std::string weight_bytes(dim * dim * sizeof(float), '\0');
+    std::string bias_bytes(dim * sizeof(float), '\0');
+    for (size_t i = 0; i < weight_bytes.size(); i++) weight_bytes[i] = static_cast<char>(i * 7);
+
+    std::string graph;
+    std::string current = "x";
+
+    for (size_t i = 0; i < layers; i++)
+    {
+        std::string gemm_out = tensor_name(i, "q_proj/Gemm_output_0");
+        std::string relu_out = tensor_name(i, "act/Relu_output_0");
+
+        std::string trans_b, alpha;
+        put_bytes(trans_b, 1, "transB");
+        put_int(trans_b, 3, 1);
+        put_int(trans_b, 20, ATTR_INT);
+        put_bytes(alpha, 1, "alpha");
+        put_varint(alpha, (2 << 3) | 5);
+        float one = 1.0f;
+        alpha.append(reinterpret_cast<const char*>(&one), sizeof(one));
+        put_int(alpha, 20, ATTR_FLOAT);
+
+        std::string gemm;
+        put_bytes(gemm, 1, current);
+        put_bytes(gemm, 1, tensor_name(i, "q_proj/weight"));
+        put_bytes(gemm, 1, tensor_name(i, "q_proj/bias"));
+        put_bytes(gemm, 2, gemm_out);
+        put_bytes(gemm, 3, tensor_name(i, "q_proj/Gemm"));
+        put_bytes(gemm, 4, "Gemm");
+        put_bytes(gemm, 5, trans_b);
+        put_bytes(gemm, 5, alpha);
+        put_bytes(graph, 1, gemm);
+
+        std::string relu;
+        put_bytes(relu, 1, gemm_out);
+        put_bytes(relu, 2, relu_out);
+        put_bytes(relu, 3, tensor_name(i, "act/Relu"));
+        put_bytes(relu, 4, "Relu");
+        put_bytes(graph, 1, relu);
+        current = relu_out;
+    }
+
+    for (size_t i = 0; i < layers; i++)
+    {
+        std::string weight, bias;
+        put_int(weight, 1, dim);
+        put_int(weight, 1, dim);
+        put_int(weight, 2, FLOAT);
+        put_bytes(weight, 8, tensor_name(i, "q_proj/weight"));
+        put_bytes(weight, 9, weight_bytes);
+        put_bytes(graph, 5, weight);
+
+        put_int(bias, 1, dim);
+        put_int(bias, 2, FLOAT);
+        put_bytes(bias, 8, tensor_name(i, "q_proj/bias"));
+        put_bytes(bias, 9, bias_bytes);
+        put_bytes(graph, 5, bias);
+    }
+
+    put_bytes(graph, 2, "synthetic");
+    put_bytes(graph, 11, value_info("x", dim));
+    put_bytes(graph, 12, value_info(current, dim));
+    for (size_t i = 0; i < layers; i++) put_bytes(graph, 13, value_info(tensor_name(i, "q_proj/Gemm_output_0"), dim));
+
+    std::string model;
+    put_int(model, 1, 8);
+    put_bytes(model, 2, "parser_bench");
+    put_bytes(model, 7, graph);
+    return model;
+}
+
+// графы совпадают целиком: имена и их TensorId, узлы, инициализаторы, формы
+static bool same_graph(const Graph& a, const Graph& b)
+{
+    const SymbolTable& sa = a.get_symbols();
+    const SymbolTable& sb = b.get_symbols();
+    if (sa.size() != sb.size()) return false;
+    for (TensorId id = 0; id < sa.size(); id++)
+    {
+        if (sa.name(id) != sb.name(id)) return false;
+    }
+
+    if (a.get_nodes().size() != b.get_nodes().size()) return false;
+    for (size_t i = 0; i < a.get_nodes().size(); i++)
+    {
+        const Node& x = a.get_nodes()[i];
+        const Node& y = b.get_nodes()[i];
+        if (x.get_name() != y.get_name() || x.get_op_type() != y.get_op_type() ||
+            x.get_inputs() != y.get_inputs() || x.get_outputs() != y.get_outputs() ||
+            x.get_ints_attrs() != y.get_ints_attrs() || x.get_float_attrs() != y.get_float_attrs() ||
+            x.get_string_attrs() != y.get_string_attrs() || x.get_floats_attrs() != y.get_floats_attrs())
+        {
+            return false;
+        }
+    }
+
+    if (a.get_initializers().size() != b.get_initializers().size()) return false;
+    for (const auto& [id, tensor] : a.get_initializers())
+    {
+        const Tensor* other = b.find_initializer(id);
+        if (other == nullptr || other->get_dims() != tensor.get_dims() ||
+            other->get_raw_data() != tensor.get_raw_data())
+        {
+            return false;
+        }
+    }
+
+    if (a.get_inputs() != b.get_inputs() || a.get_outputs() != b.get_outputs()) return false;
+    if (a.get_tensor_infos().size() != b.get_tensor_infos().size()) return false;
+    for (const auto& [id, info] : a.get_tensor_infos())
+    {
+        auto it = b.get_tensor_infos().find(id);
+        if (it == b.get_tensor_infos().end() || it->second.data_type != info.data_type ||
+            it->second.dims != info.dims || it->second.dim_params != info.dim_params)
+        {
+            return false;
+        }
+    }
+    return a.getGraphName() == b.getGraphName();
+}
+
+// разбор синтетической модели на 1..N потоках; графы сверяются с однопоточным
+static int bench_parse(bool quick)
+{
+    const size_t layers = quick ? 5000 : 100000;
+    const double min_seconds = quick ? 0.0 : 0.5;
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "parser_bench_model.onnx";
+    {
+        std::string model = synthetic_model(layers);
+        std::ofstream file(path, std::ios::binary);
+        file.write(model.data(), static_cast<std::streamsize>(model.size()));
+    }
+
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> thread_counts = {1, 2, 4};
+    if (hardware > 4) thread_counts.push_back(hardware);
+
+    std::cout << "=== Parse " << layers * 2 << " nodes, " << layers * 2 << " initializers ("
+              << std::filesystem::file_size(path) / 1024 << " KiB), ms per parse ===\n";
+
+    bool mismatch = false;
+    Graph expected;
+    double serial_seconds = 0.0;
+
+    for (size_t threads : thread_counts)
+    {
+        auto parse = [&]() {
+            ONNXParser parser(path.string());
+            parser.set_threads(threads);
+            return parser.parse();
+        };
+
+        Graph graph = parse();
+        if (threads == 1) expected = std::move(graph);
+        else if (!same_graph(expected, graph))
+        {
+            std::cerr << threads << " threads: graph differs from sequential parse\n";
+            mismatch = true;
+        }
+
+        double seconds = time_per_call([&]() { parse(); }, min_seconds);
+        if (threads == 1) serial_seconds = seconds;
+        std::cout << "  " << threads << "t " << std::setprecision(4) << seconds * 1e3 << " ms (x"
+                  << std::fixed << std::setprecision(2) << serial_seconds / seconds << std::defaultfloat << ")";
+    }
+    std::cout << "\n";
+
+    std::filesystem::remove(path);
+    return mismatch ? 1 : 0;
+}
+
+// побайтовый декодер varint (как BinaryReader до быстрого пути) — эталон для сверки и скорости
+static bool reference_varint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; pos < size && shift < 64; shift += 7)
+    {
+        uint8_t byte = data[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+// смещения всех varint сообщения в [begin, end): теги, длины и значения полей.
+// Поле LEN, которое целиком разбирается как сообщение, обходится рекурсивно
+// (строки и сырые данные — нет). false — участок не похож на сообщение
+static bool collect_varints(const uint8_t* data, size_t begin, size_t end, int depth, std::vector<size_t>& offsets)
+{
+    size_t first = offsets.size();
+    size_t pos = begin;
+
+    while (pos < end)
+    {
+        uint64_t tag = 0, value = 0;
+        offsets.push_back(pos);
+        if (!reference_varint(data, end, pos, tag) || (tag >> 3) == 0) break;
+
+        int wire_type = static_cast<int>(tag & 0x07);
+        if (wire_type == 0)
+        {
+            offsets.push_back(pos);
+            if (!reference_varint(data, end, pos, value)) break;
+        }
+        else if (wire_type == 1 || wire_type == 5)
+        {
+            pos += wire_type == 1 ? 8 : 4;
+        }
+        else if (wire_type == 2)
+        {
+            offsets.push_back(pos);
+            if (!reference_varint(data, end, pos, value) || value > end - pos) break;
+            if (depth < 16) collect_varints(data, pos, pos + value, depth + 1, offsets);
+            pos += value;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (pos == end) return true;
+    offsets.resize(first);
+    return false;
+}
+
+// суммы декодированных значений: не дают компилятору выбросить замеряемые циклы
+static volatile uint64_t varint_sink = 0;
+
+// varint'ов в секунду: BinaryReader::read_varint против побайтового цикла;
+// значения и позиции после чтения сверяются
+static int bench_varint(int argc, char* argv[])
+{
+    struct Stream { std::string label; std::string path; };
+    std::vector<Stream> streams;
+    for (int i = 0; i < argc; i++) streams.push_back({std::filesystem::path(argv[i]).filename().string(), argv[i]});
+
+    // поток varint разной длины (1..10 байтов): у реальных моделей почти все однобайтовые
+    std::filesystem::path mixed_path = std::filesystem::temp_directory_path() / "parser_bench_varints.bin";
+    {
+        std::string mixed;
+        uint64_t state = 88172645463325252ULL;
+        for (size_t i = 0; i < 1000000; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            put_int(mixed, 1, state >> (state % 64)); // тег и значение случайной длины
+        }
+        std::ofstream file(mixed_path, std::ios::binary);
+        file.write(mixed.data(), static_cast<std::streamsize>(mixed.size()));
+    }
+    streams.push_back({"mixed lengths", mixed_path.string()});
+
+    std::cout << "=== Varint decoding, million varints per second ===\n";
+    bool mismatch = false;
+
+    for (const Stream& stream : streams)
+    {
+        BinaryReader reader(stream.path);
+        const uint8_t* data = reader.get_buffer()->data();
+        size_t size = reader.get_buffer()->get_size();
+
+        std::vector<size_t> offsets;
+        collect_varints(data, 0, size, 0, offsets);
+        if (offsets.empty()) continue;
+
+        uint64_t fast_sum = 0, reference_sum = 0;
+        for (size_t offset : offsets)
+        {
+            size_t pos = offset;
+            uint64_t expected = 0;
+            reference_varint(data, size, pos, expected);
+
+            reader.seek(offset);
+            if (reader.read_varint() != expected || reader.get_cur_pos() != pos)
+            {
+                std::cerr << stream.label << ": varint at " << offset << " decoded differently\n";
+                mismatch = true;
+                break;
+            }
+        }
+
+        double fast = time_per_call([&]() {
+            for (size_t offset : offsets)
+            {
+                reader.seek(offset);
+                fast_sum += reader.read_varint();
+            }
+        }, 0.2);
+
+        double reference = time_per_call([&]() {
+            for (size_t offset : offsets)
+            {
+                size_t pos = offset;
+                uint64_t value = 0;
+                reference_varint(data, size, pos, value);
+                reference_sum += value;
+            }
+        }, 0.2);
+
+        std::cout << "  " << std::left << std::setw(18) << stream.label << std::right
+                  << std::setw(9) << offsets.size() << " varints: fast " << std::fixed << std::setprecision(1)
+                  << offsets.size() / fast / 1e6 << ", byte loop " << offsets.size() / reference / 1e6
+                  << std::defaultfloat << "\n";
+        varint_sink = fast_sum + reference_sum;
+    }
+
+    std::filesystem::remove(mixed_path);
+    return mismatch ? 1 : 0;
+}
+
+// загрузка синтетической модели из кеша против разбора; граф из кеша сверяется с разобранным.
+// Кеш изменённой модели и повреждённый кеш должны отвергаться, а не падать
+static int bench_cache(bool quick)
+{
+    const size_t layers = quick ? 5000 : 100000;
+    const double min_seconds = quick ? 0.0 : 0.5;
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "parser_bench_cached.onnx";
+    std::filesystem::path cache_path = std::filesystem::temp_directory_path() / "parser_bench_cached.gcache";
+    auto write_model = [&](const std::string& model) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(model.data(), static_cast<std::streamsize>(model.size()));
+    };
+    std::string model = synthetic_model(layers);
+    write_model(model);
+
+    auto parse = [&]() {
+        ONNXParser parser(path.string());
+        return parser.parse();
+    };
+    auto load = [&]() {
+        ExternalDataFiles files(path.string(), ReadMode::MMAP);
+        return load_graph_cache(cache_path.string(), path.string(), files);
+    };
+
+    bool mismatch = false;
+    Graph expected = parse();
+    if (!save_graph_cache(expected, path.string(), cache_path.string()))
+    {
+        std::cerr << "cache was not written\n";
+        return 1;
+    }
+
+    std::optional<Graph> cached = load();
+    if (!cached || !same_graph(expected, *cached))
+    {
+        std::cerr << "graph from cache differs from parsed graph\n";
+        mismatch = true;
+    }
+
+    double parse_seconds = time_per_call([&]() { parse(); }, min_seconds);
+    double load_seconds = time_per_call([&]() { load(); }, min_seconds);
+    std::cout << "=== Cache " << layers * 2 << " nodes (model " << std::filesystem::file_size(path) / 1024
+              << " KiB, cache " << std::filesystem::file_size(cache_path) / 1024 << " KiB) ===\n"
+              << "  parse " << std::setprecision(4) << parse_seconds * 1e3 << " ms, cache load "
+              << load_seconds * 1e3 << " ms (x" << std::fixed << std::setprecision(2)
+              << parse_seconds / load_seconds << std::defaultfloat << ")\n";
+
+    // повреждения кеша — на маленькой модели: обрезка и порча байтов заголовка и таблиц
+    model = synthetic_model(20);
+    write_model(model);
+    save_graph_cache(parse(), path.string(), cache_path.string());
+
+    std::string cache_bytes;
+    {
+        std::ifstream file(cache_path, std::ios::binary);
+        cache_bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    auto write_cache = [&](const std::string& bytes) {
+        std::ofstream file(cache_path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    };
+    for (size_t length : {size_t(0), size_t(16), cache_bytes.size() / 2, cache_bytes.size() - 1})
+    {
+        write_cache(cache_bytes.substr(0, length));
+        if (load())
+        {
+            std::cerr << "truncated cache (" << length << " bytes) was accepted\n";
+            mismatch = true;
+        }
+    }
+    for (size_t k = 0; k < 2000; k++)
+    {
+        std::string corrupted = cache_bytes;
+        size_t position = (k * 2654435761u) % corrupted.size();
+        corrupted[position] = static_cast<char>(corrupted[position] ^ (1 + k % 255));
+        write_cache(corrupted);
+        load(); // любой результат, кроме падения
+    }
+
+    // модель изменилась (тот же размер и mtime, другое содержимое) — кеш устарел
+    write_cache(cache_bytes);
+    auto mtime = std::filesystem::last_write_time(path);
+    model[model.size() / 2] = static_cast<char>(model[model.size() / 2] ^ 1);
+    write_model(model);
+    std::filesystem::last_write_time(path, mtime);
+    if (load())
+    {
+        std::cerr << "cache of a modified model was accepted\n";
+        mismatch = true;
+    }
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(cache_path);
+    return mismatch ? 1 : 0;
+}
+
+// сводка потокового прохода: счётчики и хэш всех имён и атрибутов (для сверки источников)
+struct StreamSummary
+{
+    size_t nodes = 0;
+    size_t tensors = 0;
+    size_t attributes = 0;
+    uint64_t digest = 0;
+
+    bool operator==(const StreamSummary& other) const
+    {
+        return nodes == other.nodes && tensors == other.tensors && attributes == other.attributes &&
+               digest == other.digest;
+    }
+};
+
+static StreamSummary stream_summary(StreamReader& reader)
+{
+    StreamSummary summary;
+    auto mix = [&](std::string_view text) {
+        for (char c : text) summary.digest = (summary.digest ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+        summary.digest = (summary.digest ^ 0xFF) * 0x100000001b3ULL;
+    };
+
+    StreamCallbacks callbacks;
+    callbacks.on_node = [&](const StreamNode& node) {
+        summary.nodes++;
+        mix(node.name);
+        mix(node.op_type);
+        for (std::string_view name : node.inputs) mix(name);
+        for (std::string_view name : node.outputs) mix(name);
+        for (const StreamAttribute& attr : node.attributes)
+        {
+            summary.attributes++;
+            mix(attr.name);
+            summary.digest += static_cast<uint64_t>(attr.i) + static_cast<uint64_t>(attr.f * 1000.0f) + attr.ints.size();
+        }
+    };
+    callbacks.on_tensor = [&](const StreamTensor& tensor) {
+        summary.tensors++;
+        mix(tensor.name);
+        summary.digest += tensor.data_offset * 31 + tensor.data_length;
+    };
+
+    ONNXStreamParser(reader, std::move(callbacks)).parse();
+    return summary;
+}
+
+// потоковый разбор синтетической модели: узлы и инициализаторы совпадают с ONNXParser,
+// результат не зависит от источника (istream, дескриптор) и размера окна, а число
+// выделений памяти — от размера модели
+static int bench_stream(bool quick)
+{
+    const size_t layers = quick ? 5000 : 100000;
+    const double min_seconds = quick ? 0.0 : 0.5;
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "parser_bench_stream.onnx";
+    auto write_model = [&](size_t count) {
+        std::string model = synthetic_model(count);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(model.data(), static_cast<std::streamsize>(model.size()));
+    };
+    auto scan_file = [&](size_t window) {
+        std::ifstream file(path, std::ios::binary);
+        StreamReader reader(file, window);
+        return stream_summary(reader);
+    };
+
+    bool mismatch = false;
+
+    // выделения памяти: маленькая модель и большая (после прогрева буферов разборщика)
+    write_model(20);
+    size_t small_allocations = count_allocations([&]() { scan_file(1 << 16); });
+    write_model(layers);
+    size_t large_allocations = count_allocations([&]() { scan_file(1 << 16); });
+
+    StreamSummary expected = scan_file(1 << 16);
+    Graph graph = ONNXParser(path.string()).parse();
+    if (expected.nodes != graph.get_nodes().size() || expected.tensors != graph.get_initializers().size())
+    {
+        std::cerr << "stream: " << expected.nodes << " nodes, " << expected.tensors << " initializers, parser: "
+                  << graph.get_nodes().size() << ", " << graph.get_initializers().size() << "\n";
+        mismatch = true;
+    }
+
+    // окно меньше одного узла: записи собираются через много дочитываний
+    for (size_t window : {size_t(16), size_t(100), size_t(4096)})
+    {
+        if (!(scan_file(window) == expected))
+        {
+            std::cerr << "window " << window << ": result differs\n";
+            mismatch = true;
+        }
+    }
+
+#ifdef BIN_READER_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        StreamReader reader(fd, 1 << 12);
+        if (!(stream_summary(reader) == expected))
+        {
+            std::cerr << "file descriptor: result differs\n";
+            mismatch = true;
+        }
+        ::close(fd);
+    }
+#endif
+
+    // обрезанный поток — исключение, а не молчаливый частичный результат
+    {
+        std::string model = synthetic_model(layers);
+        std::istringstream truncated(model.substr(0, model.size() / 2));
+        StreamReader reader(truncated);
+        bool failed = false;
+        try
+        {
+            stream_summary(reader);
+        }
+        catch (const std::exception&)
+        {
+            failed = true;
+        }
+        if (!failed)
+        {
+            std::cerr << "truncated stream was accepted\n";
+            mismatch = true;
+        }
+    }
+
+    double size_mb = static_cast<double>(std::filesystem::file_size(path)) / (1 << 20);
+    double stream_seconds = time_per_call([&]() { scan_file(1 << 16); }, min_seconds);
+    double parse_seconds = time_per_call([&]() { ONNXParser(path.string()).parse(); }, min_seconds);
+    std::cout << "=== Stream " << layers * 2 << " nodes (" << std::setprecision(3) << size_mb << " MiB) ===\n"
+              << "  stream " << std::setprecision(4) << stream_seconds * 1e3 << " ms (" << size_mb / stream_seconds
+              << " MiB/s), parse to Graph " << parse_seconds * 1e3 << " ms\n"
+              << "  allocations: " << small_allocations << " for 40 nodes, " << large_allocations << " for "
+              << layers * 2 << " nodes\n";
+
+    // память не растёт с моделью: на узел не приходится ни одного выделения
+    if (large_allocations > small_allocations + 64)
+    {
+        std::cerr << "allocations grow with model size\n";
+        mismatch = true;
+    }
+
+    std::filesystem::remove(path);
+    return mismatch ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " alloc [model.onnx ...] | gemm [--quick] | conv [--quick] | parallel [--quick] | parse [--quick] | varint [model.onnx ...] | cache [--quick] | stream [--quick]\n";
+        return 1;
+    }
+
+    std::string mode = argv[1];
+
+    try
+    {
+        if (mode == "alloc") return bench_alloc(argc - 2, argv + 2);
+        if (mode == "gemm") return bench_gemm(argc > 2 && std::string(argv[2]) == "--quick");
+        if (mode == "conv") return bench_conv(argc > 2 && std::string(argv[2]) == "--quick");
+        if (mode == "parallel") return bench_parallel(argc > 2 && std::string(argv[2]) == "--quick");
+        if (mode == "parse") return bench_parse(argc > 2 && std::string(argv[2]) == "--quick");
+        if (mode == "varint") return bench_varint(argc - 2, argv + 2);
+        if (mode == "cache") return bench_cache(argc > 2 && std::string(argv[2]) == "--quick");
+        if (mode == "stream") return bench_stream(argc > 2 && std::string(argv[2]) == "--quick");
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cerr << "Unknown benchmark: " << mode << "\n";
+    return 1;
+}